@@ -15,7 +15,7 @@ void  AsyncSimpleServerHandlers(){
     static const char E1[] PROGMEM = "Param(";
     static const char E404Title[] PROGMEM = "Page does not exist";
     static const char E404FeedBack[] PROGMEM = "Error 404, please try again";
-    char* buf = new char[HTMLpageBufLen];     // Temp buffer
+    if ( !RunWifi.Admit(request) ) return;                    // 429 / 503 answered, captive probes of a crowd
     #ifdef LOGGME
       RunUtil.InfoStamp(SysClock,Mname,E0,1,0); Serial.print(request->url()); Serial.print(F(" -END\n"));
       int params = request->params();
@@ -28,8 +28,7 @@ void  AsyncSimpleServerHandlers(){
         Serial.print(F(" -END\n"));
       } // end of param loop
     #endif LOGGME
-    request->send(404, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,1,E404Title,E404FeedBack,Mname));
-    delete [] buf;                                // release buffer
+    RunWifi.SendUtilityPage(request,SysClock,1,E404Title,E404FeedBack,404);   // streamed, no page buffer
   });
   //......................................................................................./
   // for root
@@ -50,12 +49,10 @@ void  AsyncSimpleServerHandlers(){
         static const char Mname[] PROGMEM = "Testing simple page  (/test):";
         static const char CredTitle[] PROGMEM = "Credenitial input form";
         static const char CredFeedBack[] PROGMEM = "-";
-        char* buf = new char[HTMLpageBufLen];                 // Temp buffer
-        request->send(200, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,3,CredTitle,"",CredSettingTrigger));
+        size_t len = RunWifi.SendUtilityPage(request,SysClock,3,CredTitle,"");
         #ifdef LOGGME
-          RunUtil.InfoStamp(SysClock,Mname,G1,1,0); Serial.print(buf); Serial.print(F(" - END\n"));
+          RunUtil.InfoStamp(SysClock,Mname,G1,1,0); Serial.print(len); Serial.print(F(" bytes - END\n"));
         #endif LOGGME
-        delete [] buf;                                // release buffer
   });
   //......................................................................................./ 
   //......................................................................................./
@@ -65,19 +62,27 @@ void  AsyncSimpleServerHandlers(){
     IoTWEBserver.on("/cred", HTTP_GET, [] (AsyncWebServerRequest *request) {  // Process '/cred' 
         static const char Mname[] PROGMEM = "Credential input form (/cred):";
         static const char CredTitle[] PROGMEM = "Credenitial input form";
-        char* buf = new char[HTMLpageBufLen];                 // Temp buffer
-        request->send(200, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,3,CredTitle,"",CredSettingTrigger));
+        if ( !RunWifi.Admit(request) ) return;                      // 429 / 503 answered
+        size_t len = RunWifi.SendUtilityPage(request,SysClock,3,CredTitle,"");
         #ifdef LOGGME
-          RunUtil.InfoStamp(SysClock,Mname,G1,1,0); Serial.print(buf); Serial.print(F(" - END\n"));
+          RunUtil.InfoStamp(SysClock,Mname,G1,1,0); Serial.print(len); Serial.print(F(" bytes - END\n"));
         #endif LOGGME
-        delete [] buf;                                // release buffer
     });
     //......................................................................................./
     // for setting of credenials      
     IoTWEBserver.on(CredSettingTrigger, HTTP_GET, [] (AsyncWebServerRequest *request) { // process '/setting'
+      if ( !RunWifi.Admit(request) ) return;                        // no EEPROM write for a refused request
+      #if _CMDQUEUE==1
+        RunWifi.ServiceOTACred(request,SysClock);                     // posted, stored by <ServiceCommands> in loop()
+      #else
         SysWifi = RunWifi.ServiceOTACred(request,SysClock,SysWifi);   
+      #endif  //_CMDQUEUE
     }); 
   #endif  OTAWIFICONFIG
+  #if _GZASSETS==1
+    RunWifi.RegisterAssets(&IoTWEBserver);                                        // style sheet and credential form from flash
+  #endif  //_GZASSETS
+    RunWifi.RegisterStatus(&IoTWEBserver);                                        // JSON connection status at /status, for pollers
 
     //......................................................................................./    
   #ifdef  OTAelegantServer
@@ -145,21 +150,20 @@ void ServiceRoot(AsyncWebServerRequest *request){
   */
   static const char Mname[] PROGMEM = "ServiceRoot(/):";
   static const char D0[] PROGMEM = "\n\n\nDefault page in test mode\n";
-  char* buf = new char[HTMLpageBufLen];                 // Temp buffer
+  size_t len = 0;                                       // page streamed by chunks, no page buffer
   if ( SysWifi.WiFiStatus==Configure_OTA ) {
     #ifdef  OTAWIFICONFIG                               // for credentials input form for OTA      
       static const char CredTitle[] PROGMEM = "Credenitial input form";
-      request->send(200, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,3,CredTitle,"",CredSettingTrigger));
+      len = RunWifi.SendUtilityPage(request,SysClock,3,CredTitle,"");
     #endif  OTAWIFICONFIG
   } else {
     static const char RootTitle[] PROGMEM = "Default Root page in test mode";
     static const char RootFeedBack[] PROGMEM = "Try another input";
-    request->send(200, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,0,RootTitle,RootFeedBack,Mname));
+    len = RunWifi.SendUtilityPage(request,SysClock,0,RootTitle,RootFeedBack);
   }
   #ifdef DEBUGON1
-    RunUtil.InfoStamp(SysClock,Mname,G1,0,0); Serial.print(buf); Serial.print(F(" - END\n"));
+    RunUtil.InfoStamp(SysClock,Mname,G1,0,0); Serial.print(len); Serial.print(F(" bytes - END\n"));
   #endif DEBUGON1
-  delete [] buf;                                        // release buffer
 }     // end of ServiceRoot
 
 /****************************************************************************************/
@@ -170,19 +174,24 @@ void ServiceClrEEPROM(AsyncWebServerRequest *request){
   static const char Mname[] PROGMEM = "ServiceClrEEPROM(/erase):";
   static const char D0[] PROGMEM = "EEPROM cleared successfully<br>Go back to root";
   static const char E0[] PROGMEM = "Error while EEPROM clearing!!!!<br>Go back to root";
-  char* buf = new char[HTMLpageBufLen];                 // Temp buffer
+  #if _CMDQUEUE==1                                              // erased by <ServiceCommands> in loop()
+    static const char D1[] PROGMEM = "EEPROM clearing requested<br>Go back to root";
+    static const char E1[] PROGMEM = "Busy, try again<br>Go back to root";
+    if ( RunWifi.PostCommand(CmdErase) )  RunWifi.SendUtilityPage(request,SysClock,2,Mname,D1);
+    else                                  RunWifi.SendUtilityPage(request,SysClock,2,Mname,E1,503);
+    return;
+  #endif  //_CMDQUEUE
   if ( RunWifi.ClearEEPROMwifiCredentials(SysClock) ) {         // successful erase
-    request->send(200, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,2,Mname,D0,Mname));
+    RunWifi.SendUtilityPage(request,SysClock,2,Mname,D0);
     #ifdef LOGGME
       RunUtil.InfoStamp(SysClock,Mname,G1,1,0); Serial.print(F("EEPROM cleared successfully - END\n"));
     #endif LOGGME
   } else  {                                                     // for error
-    request->send(200, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,2,Mname,E0,Mname));
+    RunWifi.SendUtilityPage(request,SysClock,2,Mname,E0);
     #ifdef LOGGME
       RunUtil.InfoStamp(SysClock,Mname,G1,1,0); Serial.print(F("Error while EEPROM clearing!!!! - END\n"));
     #endif LOGGME
   }
-  delete [] buf;                                        // release buffer
 }     // end of ServiceClrEEPROM
 
 /****************************************************************************************/
@@ -192,13 +201,19 @@ void ServiceResetSystem(AsyncWebServerRequest *request){
    */
   static const char Mname[] PROGMEM = "ServiceResetSystem(/ResetSystem):";
   static const char D0[] PROGMEM = "Received reset system commnad<br>Wait util system reset.<br>Bye bye";
-  char* buf = new char[HTMLpageBufLen];                 // Temp buffer
-  request->send(200, TextHTML, RunWifi.SimpleUtilityPage(SysClock,SysWifi,buf,2,Mname,D0,Mname));
+  #if _CMDQUEUE==1                                              // reset by <ServiceCommands> in loop()
+    static const char E1[] PROGMEM = "Busy, try again<br>Go back to root";
+    if ( !RunWifi.PostCommand(CmdReset) ) {
+      RunWifi.SendUtilityPage(request,SysClock,2,Mname,E1,503);
+      return;
+    }
+  #else
+    SysWifi.activeTimeEvent = 4;                // semaphore to reset the system
+  #endif  //_CMDQUEUE
+  RunWifi.SendUtilityPage(request,SysClock,2,Mname,D0);
   #ifdef LOGGME
     RunUtil.InfoStamp(SysClock,Mname,G1,1,0); Serial.print(F("Received reset system commnad - END\n"));
   #endif LOGGME
-  SysWifi.activeTimeEvent = 4;                // semaphore to reset the system
-  delete [] buf;                                        // release buffer
 }     // end of ServiceResetSystem
 
 /****************************************************************************************/
@@ -50,7 +50,6 @@ WifiNet   RunWifi(SysWifi);           // Wifi instance
 #define   IoTWEBserverPort   80       // WiFi server port
 AsyncWebServer  IoTWEBserver(IoTWEBserverPort);
 void  JustForCompilation(AsyncWebServerRequest *request){  }
-#define   HTMLpageBufLen  7500        // length of HTMP page temp buffer
 
 #ifndef DONTEMAIL
   // email
@@ -116,7 +115,11 @@ void setup() {
     if ( SysClock.IsTimeSet ){          // network time set
       break;
     } else {                            // continue to retry
-      delay(500);
+      #if _SNTPCLIENT==1
+        yield();                        // GetWWWTime does not wait, the rounds run on each call
+      #else
+        delay(500);
+      #endif  //_SNTPCLIENT
       SysWifi.activeTimeEvent = 0;      // clear semaphor post action
     }
   } // end wait for network time
@@ -160,8 +163,19 @@ void loop() {
   #ifdef  OTAelegantServer
     ElegantOTA.loop();                  // for over the air firmware updates
   #endif  OTAelegantServer
+  #if _CMDQUEUE==1
+    if ( RunWifi.ServiceCommands(SysClock) ) SysWifi = RunWifi.State();   // commands of the web handlers
+  #endif  //_CMDQUEUE
+  RunWifi.ServiceEEPROM();              // deferred EEPROM commit <_DEFERCOMMIT>, key derivation <_PMKCACHE>
+  #if _CAPTIVEDNS==1
+    RunWifi.ServiceDNS();               // every name to the soft AP while waiting for credentials
+  #endif  //_CAPTIVEDNS
+  #if _WIFINTPON==1 && _SNTPCLIENT==1
+    RunWifi.ServiceNTP();               // network time rounds, the system clock follows
+  #endif  //_SNTPCLIENT
   if (SysWifi.activeTimeEvent==4) {     // Asyc command to reset the system
     delay(3000);
+    RunWifi.ServiceEEPROM(true);        // nothing pending may be lost
     ESP.restart();                      // https://techtutorialsx.com/2017/12/29/esp8266-arduino-software-restart/
   }   // end of reset system check
 } // end of loop
@@ -0,0 +1,113 @@
+/*
+ * AdmitBench.cpp provisioning handlers under a crowd of phones (PlatformIO env:admitbench)
+ * Created by Sachi Gerlitz
+ *
+ * <Phones> phones on the soft AP, each firing "/", "/cred" and a credential submission in turn every 50 mS of
+ * virtual time for <Seconds>; every answered response stays open 200 mS (a slow client draining it):
+ *    none      - the same handlers registered by the application, no admission
+ *    admitted  - <RegisterProvisioning>: <Admit> first, 429 / 503 with Retry-After
+ * prints the answers (200 / 429 / 503), EEPROM commits, slabs exhausted and host handler time of each run
+ * checks the admitted run rate limits, never exhausts the pool (503 comes before a slab is taken) and commits
+ * no more than the token buckets allow
+ * usage: program [Phones] [Seconds]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <chrono>
+#include  <deque>
+#include  <memory>
+#include  <string>
+
+struct  Open {
+  std::unique_ptr<AsyncWebServerRequest>  Request;
+  uint32_t  Until;                      // [mS] the client is done draining
+};
+
+struct  Tally {
+  uint32_t  Ok, TooMany, Busy;          // 200, 429, 503
+  uint32_t  Commits, Exhausted;
+  double    HandlerUs;
+};
+
+// **************************************************************************************** //
+static Tally Crowd(WifiNet& RunWifi, AsyncWebServer& Server, PosixClock& Clk, uint8_t Phones, uint32_t Seconds) {
+  Tally   T = {};
+  std::deque<Open>  open;
+  uint32_t  commits = RunWifi.getStats().EEPROMcommits, exhausted = RunWifi.Pool().Exhausted;
+  double    us = 0;
+  for ( uint32_t tick=0; tick<Seconds*20; tick++ ) {
+    Clk.advance(50);
+    uint32_t  now = millis();
+    while ( !open.empty() && (int32_t)(now-open.front().Until) >= 0 ) open.pop_front();   // slabs back
+    for ( uint8_t p=0; p<Phones; p++ ) {
+      static const char* const Url[] = { "/", ProvisionFormPath, CredSettingTrigger };
+      std::unique_ptr<AsyncWebServerRequest> request(new AsyncWebServerRequest(Url[(tick+p)%3], IPAddress(192,168,4,10+p)));
+      if ( (tick+p)%3==2 ) {
+        std::string ssid = "Net" + std::to_string(p);
+        request->addParam(SSID_Phrase, ssid.c_str());
+        request->addParam(PSWD_Phrase, "Kalisher46apt7");
+      }
+      auto    t0 = std::chrono::steady_clock::now();
+      int     code = Server.dispatch(*request);
+      us += std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-t0).count();
+      T.Ok += code==200;
+      T.TooMany += code==429;
+      T.Busy += code==503;
+      if ( code==200 ) open.push_back({ std::move(request), now+200 });
+    }
+  }
+  T.Commits = RunWifi.getStats().EEPROMcommits - commits;
+  T.Exhausted = RunWifi.Pool().Exhausted - exhausted;
+  T.HandlerUs = us/(Seconds*20*Phones);
+  return  T;
+}     // end of Crowd
+
+static void Print(const char* Name, const Tally& T) {
+  printf("%-9s 200 %6u   429 %6u   503 %6u   EEPROM commits %5u   slabs exhausted %5u   handler %.2f uS\n",
+         Name, T.Ok, T.TooMany, T.Busy, T.Commits, T.Exhausted, T.HandlerUs);
+}     // end of Print
+
+int main(int argc, char** argv) {
+  uint8_t     Phones = argc>1 ? atoi(argv[1]) : 12;
+  uint32_t    Seconds = argc>2 ? atol(argv[2]) : 10;
+  bool        ok = true;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  ManageWifi  M = {};
+  strcpy(M.WhoAmI, "ESP8266-Relay");
+  strcpy(M.Version, "0.3.2");
+  WifiNet     RunWifi(M);
+  TimePack    SysClock = {};
+
+  // the handlers as the application registered them before
+  AsyncWebServer  None(80);
+  static const char Title[] PROGMEM = "Credential input form";
+  ArRequestHandlerFunction  Form = [&](AsyncWebServerRequest* request) { RunWifi.SendUtilityPage(request, SysClock, 3, Title, ""); };
+  None.on("/", Form);
+  None.on(ProvisionFormPath, Form);
+  None.on(CredSettingTrigger, [&](AsyncWebServerRequest* request) { RunWifi.ServiceOTACred(request, SysClock); });
+  Tally   none = Crowd(RunWifi, None, Clk, Phones, Seconds);
+
+  AsyncWebServer  Admitted(80);
+  RunWifi.RegisterProvisioning(&Admitted, SysClock);
+  Clk.advance(60000);                                     // buckets full
+  Tally   admitted = Crowd(RunWifi, Admitted, Clk, Phones, Seconds);
+
+  printf("%u phones, a request every 50 mS each for %u S, responses open 200 mS, %u slabs\n", Phones, Seconds, PoolSlabs);
+  Print("none", none);
+  Print("admitted", admitted);
+  uint32_t  bound = Phones*(AdmitBurst + AdmitRate*Seconds);   // requests a full bucket lets through
+  ok &= admitted.TooMany>0 && admitted.Exhausted==0 && admitted.Ok+admitted.TooMany+admitted.Busy==none.Ok+none.TooMany+none.Busy;
+  ok &= admitted.Commits <= bound && admitted.Commits < none.Commits && admitted.Ok <= bound;
+  ok &= RunWifi.Pool().InUse==0;
+  printf("admit: %s\n", ok ? "rate limited, pool never exhausted, commits bounded" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
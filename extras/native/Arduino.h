@@ -0,0 +1,140 @@
+#pragma once
+/*
+ * Arduino.h host compatibility header for WifiNet native build (PlatformIO env:native)
+ * Created by Sachi Gerlitz
+ *
+ * covers the part of the Arduino ESP8266 core API used by the library; <millis>, <delay> and <Serial>
+ * are routed to the installed <WifiNetHal> (see WifiNetHalPosix.h)
+ */
+#ifndef WifiNetNativeArduino_h
+  #define WifiNetNativeArduino_h
+
+  #include  <stdint.h>
+  #include  <stddef.h>
+  #include  <stdlib.h>
+  #include  <stdio.h>
+  #include  <string.h>
+  #include  <time.h>
+  #include  <functional>
+  #include  <string>
+  #include  <algorithm>
+  #include  "WifiNetHal.h"
+
+  // flash access is plain memory on a host
+  #define PROGMEM
+  #define PGM_P               const char*
+  #define PSTR(s)             (s)
+  #define F(s)                (s)
+  #define FPSTR(p)            (p)
+  #define pgm_read_byte(a)    (*(const uint8_t*)(a))
+  #define pgm_read_word(a)    (*(const uint16_t*)(a))
+  #define pgm_read_dword(a)   (*(const uint32_t*)(a))
+  #define pgm_read_ptr(a)     (*(void* const*)(a))
+  #define strcpy_P            strcpy
+  #define strncpy_P           strncpy
+  #define strcat_P            strcat
+  #define strlen_P            strlen
+  #define strnlen_P           strnlen
+  #define strcmp_P            strcmp
+  #define strncmp_P           strncmp
+  #define memcpy_P            memcpy
+  #define sprintf_P           sprintf
+  #define snprintf_P          snprintf
+  #define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+  #define HEX                 16
+  #define DEC                 10
+  #define D4                  2
+  typedef uint8_t   byte;
+  typedef bool      boolean;
+  using std::min;
+  using std::max;
+
+  WifiNetHal&     WifiNetHost();                    // installed binding
+  unsigned long   millis();
+  unsigned long   micros();
+  void            delay(unsigned long Ms);
+  void            yield();
+  long            random(long Max);
+  long            random(long Min, long Max);
+  void            randomSeed(unsigned long Seed);
+  inline void     pinMode(uint8_t, uint8_t) {}
+  inline void     digitalWrite(uint8_t, uint8_t) {}
+
+  class String {
+    public:
+      String() {}
+      String(const char* S) : _S(S ? S : "") {}
+      String(const std::string& S) : _S(S) {}
+      String(int V)           : _S(std::to_string(V)) {}
+      String(unsigned V)      : _S(std::to_string(V)) {}
+      String(long V)          : _S(std::to_string(V)) {}
+      String(unsigned long V) : _S(std::to_string(V)) {}
+      const char* c_str() const           { return _S.c_str(); }
+      unsigned    length() const          { return _S.length(); }
+      int         toInt() const           { return atoi(_S.c_str()); }
+      void        toCharArray(char* Buf, unsigned Len) const { if ( !Len ) return; strncpy(Buf, _S.c_str(), Len-1); Buf[Len-1]=0; }
+      bool        equals(const String& O) const   { return _S==O._S; }
+      bool        operator==(const char* O) const { return _S==O; }
+      bool        operator==(const String& O) const { return _S==O._S; }
+      String&     operator+=(const char* O)   { _S+=O; return *this; }
+      String&     operator+=(const String& O) { _S+=O._S; return *this; }
+      String      operator+(const char* O) const  { return String(_S+O); }
+    private:
+      std::string _S;
+  };
+
+  class Print;
+  class Printable {
+    public:
+      virtual ~Printable() {}
+      virtual size_t printTo(Print& P) const=0;
+  };
+  class Print {
+    public:
+      virtual ~Print() {}
+      virtual size_t write(const uint8_t* Buf, size_t Len)=0;
+      size_t  write(uint8_t C)                  { return write(&C,1); }
+      size_t  print(const char* S)              { return write((const uint8_t*)S, strlen(S)); }
+      size_t  print(const String& S)            { return print(S.c_str()); }
+      size_t  print(char C)                     { return write((uint8_t)C); }
+      size_t  print(unsigned char V, int B=DEC) { return print((unsigned long)V,B); }
+      size_t  print(short V, int B=DEC)         { return print((long)V,B); }
+      size_t  print(unsigned short V, int B=DEC){ return print((unsigned long)V,B); }
+      size_t  print(int V, int B=DEC)           { return print((long)V,B); }
+      size_t  print(unsigned V, int B=DEC)      { return print((unsigned long)V,B); }
+      size_t  print(long V, int B=DEC)          { char b[24]; snprintf(b,sizeof(b),B==HEX?"%lX":"%ld",V); return print(b); }
+      size_t  print(unsigned long V, int B=DEC) { char b[24]; snprintf(b,sizeof(b),B==HEX?"%lX":"%lu",V); return print(b); }
+      size_t  print(long long V, int B=DEC)     { return print((long)V,B); }
+      size_t  print(unsigned long long V, int B=DEC) { return print((unsigned long)V,B); }
+      size_t  print(double V, int D=2)          { char b[32]; snprintf(b,sizeof(b),"%.*f",D,V); return print(b); }
+      size_t  print(const Printable& P)         { return P.printTo(*this); }
+      template<class T> size_t println(const T& V)  { size_t n=print(V); return n+print("\r\n"); }
+      size_t  println()                         { return print("\r\n"); }
+      size_t  printf(const char* Format, ...) __attribute__((format(printf,2,3)));
+  };
+  class HardwareSerial : public Print {
+    public:
+      void    begin(unsigned long) {}
+      size_t  write(const uint8_t* Buf, size_t Len);
+      using   Print::write;
+  };
+  extern HardwareSerial Serial;
+
+  class IPAddress : public Printable {          // octets kept in network order as the ESP8266 core does
+    public:
+      IPAddress() : _A(0) {}
+      IPAddress(uint8_t A, uint8_t B, uint8_t C, uint8_t D) : _A(A | (B<<8) | (C<<16) | ((uint32_t)D<<24)) {}
+      IPAddress(uint32_t A) : _A(A) {}
+      operator uint32_t() const                 { return _A; }
+      bool    operator==(const IPAddress& O) const { return _A==O._A; }
+      bool    operator==(uint32_t O) const      { return _A==O; }
+      uint8_t operator[](int I) const           { return (_A>>(8*I)) & 0xFF; }
+      bool    isSet() const                     { return _A!=0; }
+      String  toString() const                  { char b[16]; snprintf(b,sizeof(b),"%u.%u.%u.%u",(*this)[0],(*this)[1],(*this)[2],(*this)[3]); return String(b); }
+      bool    fromString(const char* S)         { unsigned a,b,c,d; if ( sscanf(S,"%u.%u.%u.%u",&a,&b,&c,&d)!=4 ) return false; *this=IPAddress(a,b,c,d); return true; }
+      size_t  printTo(Print& P) const           { return P.print(toString()); }
+    private:
+      uint32_t  _A;
+  };
+
+#endif  //WifiNetNativeArduino_h
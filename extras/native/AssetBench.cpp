@@ -0,0 +1,121 @@
+/*
+ * AssetBench.cpp provisioning UI served from compressed flash assets (PlatformIO env:assetbench, <_GZASSETS>)
+ * Created by Sachi Gerlitz
+ *
+ * a phone joins the soft AP <Visits> times and loads the credential form each time:
+ *    rendered  - the utility page of <option> 3 with the style inline, rendered on every request
+ *    assets    - <AssetFormPath> and <AssetCssPath> by <RegisterAssets>: sent once, then 304 on the ETag
+ * checks the form inflates to the page the tool built from WifiNetConfig.h, the 304 path and the ETag / encoding
+ * headers, and prints body bytes on air and host handler time per request
+ * usage: program [Visits] [Calls]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <chrono>
+#include  <string>
+#include  <zlib.h>
+
+// the credential form page with the style inline, as served before the assets
+WifiNetPageDef(InlineForm, "<html><head><title>ESP8266 Utilities</title>"
+  "<style>body {background-color: #9DCDF4; font-family: Arial, Helvetica, Sans-Serif; Color: blue;}</style></head>\n"
+  "<body><h2>" TplWhoAmI " " TplVersion " " TplStamp "</h2><h1>" TplTitle "</h1>"
+  "<form method='get' action='" TplAction "'>&nbsp;&nbsp;&nbsp;&nbsp;Network SSID:<input type='text' name='" TplSsidName
+  "'><BR><BR>Network password:<input type='text' name='" TplPswdName "'>&nbsp;<input type='submit' value='Enter'></form>"
+  TplTail);
+
+struct  Reply {
+  int           Code;
+  std::string   Body;
+  std::string   ETag;
+  std::string   Encoding;
+};
+
+// **************************************************************************************** //
+static Reply Get(AsyncWebServer& Server, const char* Url, const std::string& ETag = "") {
+  AsyncWebServerRequest request(Url);
+  Reply   R;
+  if ( !ETag.empty() ) request.addHeader("If-None-Match", ETag.c_str());
+  R.Code = Server.dispatch(request, &R.Body, 1460);
+  if ( request.response() )
+    for ( auto& H : request.response()->Headers ) {
+      if ( H.first=="ETag" )             R.ETag = H.second.c_str();
+      if ( H.first=="Content-Encoding" ) R.Encoding = H.second.c_str();
+    }
+  return  R;
+}     // end of Get
+
+static std::string Gunzip(const std::string& In) {
+  std::string   out(4096, '\0');
+  z_stream      z = {};
+  inflateInit2(&z, 16+MAX_WBITS);
+  z.next_in = (Bytef*)In.data();
+  z.avail_in = In.size();
+  z.next_out = (Bytef*)&out[0];
+  z.avail_out = out.size();
+  int   rc = inflate(&z, Z_FINISH);
+  out.resize(z.total_out);
+  inflateEnd(&z);
+  return  rc==Z_STREAM_END ? out : std::string();
+}     // end of Gunzip
+
+template<class F> static double UsPer(long Calls, F Body) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) Body();
+  return  std::chrono::duration<double,std::micro>(std::chrono::steady_clock::now()-t0).count()/Calls;
+}     // end of UsPer
+
+int main(int argc, char** argv) {
+  long        Visits = argc>1 ? atol(argv[1]) : 20;
+  long        Calls = argc>2 ? atol(argv[2]) : 100000;
+  bool        ok = true;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });    // <Admit> reads the clock
+  EEPROM.begin(Store.size());
+  ManageWifi  M = {};
+  strcpy(M.WhoAmI, "ESP8266-Relay");
+  strcpy(M.Version, "0.3.2");
+  WifiNet     RunWifi(M);
+  TimePack    SysClock = {};
+  AsyncWebServer  Server(80);
+  static const char CredTitle[] PROGMEM = "Credenitial input form";
+  RunWifi.RegisterPage(6, InlineForm);
+  Server.on("/cred", [&](AsyncWebServerRequest* request) { RunWifi.SendUtilityPage(request, SysClock, 6, CredTitle, ""); });
+  ok &= RunWifi.RegisterAssets(&Server);
+
+  // content and headers
+  Reply form = Get(Server, AssetFormPath), css = Get(Server, AssetCssPath);
+  std::string page = Gunzip(form.Body);
+  ok &= form.Code==200 && form.Encoding=="gzip" && !form.ETag.empty() && page.find("action='" AssetFormAction "'")!=std::string::npos &&
+        page.find("name='" AssetFormSsid "'")!=std::string::npos && page.find("href='" AssetCssPath "'")!=std::string::npos;
+  ok &= css.Code==200 && css.Encoding.empty() && css.Body.find("background-color")!=std::string::npos;
+  Reply again = Get(Server, AssetFormPath, form.ETag), other = Get(Server, AssetFormPath, "\"0000000000000000\"");
+  ok &= again.Code==304 && again.Body.empty() && again.ETag==form.ETag && other.Code==200;
+  ok &= Get(Server, AssetCssPath, "*").Code==304;
+
+  // bytes on air over <Visits>
+  size_t  rendered = 0, assets = 0;
+  std::string formTag, cssTag;
+  for ( long v=0; v<Visits; v++ ) {
+    rendered += Get(Server, "/cred").Body.size();
+    Reply F = Get(Server, AssetFormPath, formTag), C = Get(Server, AssetCssPath, cssTag);
+    assets += F.Body.size() + C.Body.size();
+    if ( F.Code==200 ) formTag = F.ETag;
+    if ( C.Code==200 ) cssTag = C.ETag;
+  }
+  printf("form page: %zu bytes rendered, %zu bytes gzip (%zu inflated) + %zu bytes style sheet\n",
+         Get(Server, "/cred").Body.size(), form.Body.size(), page.size(), css.Body.size());
+  printf("%ld visits: rendered %zu bytes, assets %zu bytes (x%.1f less on air)\n",
+         Visits, rendered, assets, assets ? (double)rendered/assets : 0.0);
+  printf("handler:   rendered %.2f uS   asset 200 %.2f uS   asset 304 %.2f uS   (host, per request)\n",
+         UsPer(Calls, [&]{ Get(Server, "/cred"); }), UsPer(Calls, [&]{ Get(Server, AssetFormPath); }),
+         UsPer(Calls, [&]{ Get(Server, AssetFormPath, form.ETag); }));
+  printf("assets: %s\n", ok ? "content, ETag and 304 as expected" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,148 @@
+/*
+ * ConnectBench.cpp time-to-ready benchmark of the WifiNet connection logic (PlatformIO env:bench)
+ * Created by Sachi Gerlitz
+ *
+ * drives <startWiFi> -> <WiFiTimeOut> -> <GetWWWTime> as the application does, against the scripted radio, DHCP
+ * and SNTP stand-ins of WifiNetHalPosix, on a virtual clock. Ready is connected and network time set.
+ * for every scenario prints the distribution of simulated time-to-ready and of <WiFiTimeOut> ticks
+ * usage: program [Runs] [Seed]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <vector>
+
+#define   BenchBudget   120000UL                // max simulated time[mS] of one run
+#define   NTPretryWait  500                     // wait[mS] between <GetWWWTime> calls (as the example sketch)
+
+struct  Scenario {
+  const char* Name;
+  bool        Stored;                           // credentials in EEPROM
+  bool        Full;                             // channel and BSSID in EEPROM (<CredStat>==2)
+  bool        APpresent;
+  bool        WrongPass;
+  uint32_t    AssocMs;                          // mean association time
+  uint32_t    DhcpMs;                           // mean DHCP time
+  uint8_t     NTPloss;                          // [%]
+};
+static const Scenario Scenarios[] = {
+  //  name            stored full  AP     wrong  assoc  dhcp  loss
+  { "cold-boot",      true,  false, true,  false,  300,   700,  0 },
+  { "warm-boot",      true,  true,  true,  false,  300,   700,  0 },
+  { "wrong-password", true,  true,  true,  true,   300,   700,  0 },
+  { "missing-AP",     true,  true,  false, false,  300,   700,  0 },
+  { "slow-DHCP",      true,  true,  true,  false,  300,  6000,  0 },
+  { "NTP-loss-50%",   true,  true,  true,  false,  300,   700, 50 },
+};
+
+struct  RunResult {
+  bool      Ready;
+  uint32_t  TimeMs;                             // to ready, or to give up (soft AP / budget)
+  uint32_t  Ticks;                              // <WiFiTimeOut> calls
+};
+
+static const uint8_t  BenchBssid[6] = {0x02,0x00,0x00,0x00,0x00,0x01};
+
+// **************************************************************************************** //
+static uint32_t Jitter(uint32_t Mean) {
+  /*
+    * +-25% uniform around <Mean>
+    */
+  return  Mean ? Mean - Mean/4 + rand()%(Mean/2+1) : 0;
+}     // end of Jitter
+
+// **************************************************************************************** //
+static RunResult  RunOnce(const Scenario& S, PosixStore& Store, const std::vector<uint8_t>& Image) {
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixLog    Log(nullptr);
+  memcpy(Store.data(), Image.data(), Image.size());   // same persistent state on every boot
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  WifiNetHostSntp(S.NTPloss, 20+rand()%60);
+  Radio.setLatency(Jitter(S.AssocMs), Jitter(S.DhcpMs), Jitter(1500));
+  if ( S.APpresent ) {
+    SimAP AP = { Per_SSID, S.WrongPass ? "other-pass" : Per_Pass, {0}, 6, -60,
+                 IPAddress(192,168,1,50), IPAddress(192,168,1,1), IPAddress(255,255,255,0), IPAddress(192,168,1,1) };
+    memcpy(AP.Bssid, BenchBssid, 6);
+    Radio.addAP(AP);
+  }
+
+  RunResult   R = { false, 0, 0 };
+  TimePack    SysClock = {};
+  SysClock.NTPbeginOnce = true;                 // power up
+  ManageWifi  SysWifi = {};
+  WifiNet     RunWifi(SysWifi);
+  EEPROM.begin(Store.size());
+  SysWifi = RunWifi.begin(SysWifi);
+  uint32_t    t0 = millis();
+  SysWifi = RunWifi.startWiFi(SysClock, SysWifi);
+  while ( millis()-t0 < BenchBudget ) {         // connect
+    SysWifi = RunWifi.WiFiTimeOut(SysClock, SysWifi);
+    R.Ticks++;
+    if ( SysWifi.activeTimeEvent==2 ) break;
+    if ( SysWifi.WiFiStatus==Configure_OTA ) { R.TimeMs = millis()-t0; return R; }    // gave up, soft AP
+    SysWifi.activeTimeEvent = 0;
+    delay(ReconnectTick);
+  }
+  while ( millis()-t0 < BenchBudget ) {         // network time
+    SysClock = RunWifi.GetWWWTime(SysClock, SysWifi);
+    if ( SysClock.IsTimeSet ) { R.Ready = true; break; }
+    delay(NTPretryWait);
+  }
+  R.TimeMs = millis()-t0;
+  return  R;
+}     // end of RunOnce
+
+// **************************************************************************************** //
+static uint32_t Pct(std::vector<uint32_t>& V, uint8_t P) {
+  if ( V.empty() ) return  0;
+  std::sort(V.begin(), V.end());
+  return  V[ (V.size()-1)*P/100 ];
+}     // end of Pct
+
+int main(int argc, char** argv) {
+  int       Runs = argc>1 ? atoi(argv[1]) : 200;
+  unsigned  Seed = argc>2 ? atoi(argv[2]) : 1;
+  srand(Seed);
+  PosixStore  Store(nullptr);
+  printf("WifiNet %s time-to-ready, %d runs per scenario, seed %u\n", WifiNetVersion, Runs, Seed);
+  printf("%-16s %7s | %8s %8s %8s %8s [mS] | %5s %5s %5s ticks\n", "scenario", "ready", "min", "median", "p95", "max", "min", "med", "p95");
+  for ( const Scenario& S : Scenarios ) {
+    // persistent state of this scenario, written once through the library
+    memset(Store.data(), 0xFF, Store.size());
+    {
+      PosixClock  Clk(true);
+      PosixRadio  Radio(&Clk);
+      PosixLog    Log(nullptr);
+      WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+      TimePack    SysClock = {};
+      ManageWifi  SysWifi = {};
+      WifiNet     RunWifi(SysWifi);
+      EEPROM.begin(Store.size());
+      char  ssid[SSIDlength+1], pass[PASSlength+1];
+      strncpy(ssid, Per_SSID, SSIDlength); ssid[SSIDlength] = 0;
+      strncpy(pass, Per_Pass, PASSlength); pass[PASSlength] = 0;
+      if ( S.Stored ) RunWifi.KeepCredentialsEEPROM(SysClock, ssid, pass);
+      if ( S.Full )   RunWifi.KeepChaBssidEEPROM(SysClock, (uint8_t*)BenchBssid, 6);
+    }
+    std::vector<uint8_t>  Image(Store.data(), Store.data()+Store.size());
+    std::vector<uint32_t> ready, ticks;
+    uint32_t  givenUp = 0;
+    for ( int r=0; r<Runs; r++ ) {
+      RunResult R = RunOnce(S, Store, Image);
+      if ( R.Ready ) ready.push_back(R.TimeMs);
+      else           givenUp = R.TimeMs;
+      ticks.push_back(R.Ticks);
+    }
+    char  frac[16];
+    snprintf(frac, sizeof(frac), "%u/%d", (unsigned)ready.size(), Runs);
+    if ( ready.empty() ) printf("%-16s %7s | gave up after %u mS %17s | %5u %5u %5u\n", S.Name, frac, givenUp, "",
+                                Pct(ticks,0), Pct(ticks,50), Pct(ticks,95));
+    else  printf("%-16s %7s | %8u %8u %8u %8u      | %5u %5u %5u\n", S.Name, frac, Pct(ready,0), Pct(ready,50), Pct(ready,95),
+                 Pct(ready,100), Pct(ticks,0), Pct(ticks,50), Pct(ticks,95));
+  }
+  return  0;
+}     // end of main
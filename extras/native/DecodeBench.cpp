@@ -0,0 +1,97 @@
+/*
+ * DecodeBench.cpp micro-benchmark of the persisted credential and IP decode (PlatformIO env:decodebench)
+ * Created by Sachi Gerlitz
+ *
+ * decodes a fully programmed credential record and the stored IP through the byte per <EEPROM.read> loops the
+ * library used before and through <fetchCredFromEEPROM> / <fetchIPaddress>, checks both give the same result
+ * and prints time per decode. saving the same credentials again must leave the complete record and commit nothing
+ * usage: program [Calls]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <chrono>
+
+static volatile uint8_t Sink;                   // keeps the decode loops alive
+
+// **************************************************************************************** //
+__attribute__((noinline)) static void LegacyCred(ManageWifi& M) {
+  /*
+    * the former byte loop decode of <fetchCredFromEEPROM>, out of line as the library call
+    */
+  if ( char(EEPROM.read(0))=='*' )      M.CredStat=2;
+  else if (char(EEPROM.read(0))=='+')   M.CredStat=1;
+  else                                  M.CredStat=0;
+  if ( M.CredStat==0 ) return;
+  for (uint8_t i=1; i <= SSIDlength; ++i) { M.Ssid[i-1]=char(EEPROM.read(i)); M.Ssid[i]='\0'; }
+  for (uint8_t i=0; i < PASSlength; ++i) { M.Password[i] = char(EEPROM.read(SSIDlength+i)); M.Password[i+1]='\0'; }
+  if ( M.CredStat==2 ) {
+    for (uint8_t i = 0; i < 6 ; ++i) M.WiFiBSsid[i] = byte(EEPROM.read(SSIDlength+PASSlength+1+i));
+    M.WiFichannel = byte(EEPROM.read(SSIDlength+PASSlength+1+6+1));
+  }
+}     // end of LegacyCred
+
+__attribute__((noinline)) static char* LegacyIP(char* buff, uint16_t EEPaddress) {
+  /*
+    * the former byte loop decode of <fetchIPaddress>
+    */
+  uint16_t  Address = EEPaddress;
+  char*     pbuf = buff;
+  for ( uint8_t ii=0; ii<15; ii++ ) {
+    *pbuf = EEPROM.read(Address++);
+    if ( *pbuf == 0x00 ) break;
+    pbuf++;
+    *pbuf = 0x00;
+  }
+  return  buff;
+}     // end of LegacyIP
+
+// **************************************************************************************** //
+template<class F> static double NsPer(long Calls, F Body) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) Body();
+  return  std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-t0).count()/Calls;
+}     // end of NsPer
+
+int main(int argc, char** argv) {
+  long        Calls = argc>1 ? atol(argv[1]) : 1000000;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  TimePack    SysClock = {};
+  ManageWifi  SysWifi = {};
+  WifiNet     RunWifi(SysWifi);
+  uint8_t     bssid[6] = {0x02,0x11,0x22,0x33,0x44,0x55};
+  RunWifi.KeepCredentialsEEPROM(SysClock, (char*)"HomeNetwork-5G", (char*)"correct horse battery");
+  RunWifi.KeepChaBssidEEPROM(SysClock, bssid, 11);
+  RunWifi.storeIPaddress(SysClock, "192.168.100.123", EEPROMipAddress);
+
+  ManageWifi  Old = {}, &New = RunWifi.State();
+  char        ipOld[16], ipNew[16];
+  LegacyCred(Old);
+  RunWifi.fetchCredFromEEPROM(SysClock);
+  LegacyIP(ipOld, EEPROMipAddress);
+  RunWifi.fetchIPaddress(ipNew, EEPROMipAddress);
+  bool  same = Old.CredStat==New.CredStat && strcmp(Old.Ssid,New.Ssid)==0 && strcmp(Old.Password,New.Password)==0 &&
+               memcmp(Old.WiFiBSsid,New.WiFiBSsid,6)==0 && Old.WiFichannel==New.WiFichannel && strcmp(ipOld,ipNew)==0;
+  uint32_t  commits = Store.Commits;
+  RunWifi.KeepCredentialsEEPROM(SysClock, (char*)"HomeNetwork-5G", (char*)"correct horse battery");
+  RunWifi.fetchCredFromEEPROM(SysClock);
+  bool  kept = Store.Commits==commits && New.CredStat==2;
+
+  double  credOld = NsPer(Calls, [&]{ LegacyCred(Old); Sink = Old.Ssid[0]; });
+  double  credNew = NsPer(Calls, [&]{ RunWifi.fetchCredFromEEPROM(SysClock); Sink = New.Ssid[0]; });
+  double  ipO = NsPer(Calls, [&]{ Sink = LegacyIP(ipOld, EEPROMipAddress)[0]; });
+  double  ipN = NsPer(Calls, [&]{ Sink = RunWifi.fetchIPaddress(ipNew, EEPROMipAddress)[0]; });
+  printf("%ld decodes per path, results %s\n", Calls, same ? "identical" : "DIFFER");
+  printf("same credentials saved again: %s\n", kept ? "record complete, no commit" : "FAILED");
+  printf("%-12s %8.1f nS byte loop  %8.1f nS one view  (x%.1f)\n", "credentials", credOld, credNew, credOld/credNew);
+  printf("%-12s %8.1f nS byte loop  %8.1f nS one view  (x%.1f)\n", "IP address", ipO, ipN, ipO/ipN);
+  return  same && kept ? 0 : 1;
+}     // end of main
@@ -0,0 +1,187 @@
+/*
+ * DnsProbe.cpp captive portal DNS responder against a local UDP client (PlatformIO env:dnsprobe, <_CAPTIVEDNS>)
+ * Created by Sachi Gerlitz
+ *
+ * the soft AP is started by <startOTAWifiServer> and the responder listens on <CaptiveDnsPort> (5353 here, no
+ * privilege needed); a client socket on 127.0.0.1 sends the queries a phone sends after joining:
+ *    A of the probe hosts (with and without EDNS), AAAA, another opcode, a response, a truncated and a bad name
+ * checks each answer (ID, flags, the soft AP address and TTL) or that nothing came back, that <ServiceDNS>
+ * allocates nothing, the OS probe URLs redirect to the form and the responder stops once the status moves on
+ * then prints answers per second of <WifiNetDns::answer> alone and of loopback round trips
+ * usage: program [Calls]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <arpa/inet.h>
+#include  <chrono>
+#include  <cstdlib>
+#include  <new>
+#include  <string>
+#include  <sys/socket.h>
+#include  <unistd.h>
+
+// heap blocks, counted while <Counting>
+static bool     Counting = false;
+static size_t   Blocks = 0;
+void* operator new(size_t N) {
+  if ( Counting ) Blocks++;
+  void*   p = malloc(N ? N : 1);
+  if ( !p ) throw std::bad_alloc();
+  return  p;
+}
+// out of line, so gcc does not pair the free with the malloc of <new> and warn
+__attribute__((noinline)) void operator delete(void* P) noexcept         { free(P); }
+__attribute__((noinline)) void operator delete(void* P, size_t) noexcept { free(P); }
+
+static int      Client = -1;
+static uint16_t NextId = 0x1234;
+
+// **************************************************************************************** //
+static std::string Query(const char* Name, uint16_t Type, uint8_t Flags = 0x01, bool Edns = false) {
+  std::string   q;
+  NextId++;
+  q += (char)(NextId>>8); q += (char)NextId;
+  q += (char)Flags; q += '\0';                            // RD (opcode, QR by <Flags>)
+  q += std::string("\0\1\0\0\0\0\0", 7);                  // one question
+  q += (char)Edns;
+  for ( const char* l=Name; *l; ) {                       // labels
+    const char* dot = strchr(l, '.');
+    size_t  n = dot ? dot-l : strlen(l);
+    q += (char)n;
+    q.append(l, n);
+    l += n + (dot ? 1 : 0);
+  }
+  q += '\0';
+  q += (char)(Type>>8); q += (char)Type; q += std::string("\0\1", 2);   // IN
+  if ( Edns ) q += std::string("\0\0\x29\x10\0\0\0\0\0\0\0", 11);        // OPT, 4096 bytes
+  return  q;
+}     // end of Query
+
+static std::string Ask(WifiNet& RunWifi, const std::string& Q, int Wait = 20) {
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(CaptiveDnsPort);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sendto(Client, Q.data(), Q.size(), 0, (sockaddr*)&a, sizeof(a));
+  char    buf[600];
+  for ( int t=0; t<Wait; t++ ) {                          // loop() passes
+    RunWifi.ServiceDNS();
+    ssize_t n = recv(Client, buf, sizeof(buf), MSG_DONTWAIT);
+    if ( n > 0 ) return std::string(buf, n);
+    usleep(1000);
+  }
+  return  std::string();
+}     // end of Ask
+
+static uint16_t Word(const std::string& R, size_t At) {
+  return  ((uint8_t)R[At]<<8) | (uint8_t)R[At+1];
+}     // end of Word
+
+static bool Answers(const std::string& Q, const std::string& R, uint16_t Count) {
+  /*
+    * <R> answers <Q>: same ID and question, QR AA RD, NOERROR, <Count> A records of 192.168.4.1, TTL <CaptiveDnsTtl>
+    */
+  size_t  qend = 12;
+  while ( Q[qend] ) qend += (uint8_t)Q[qend]+1;
+  qend += 5;
+  bool  ok = R.size()==qend+16*Count && R.compare(0, 2, Q, 0, 2)==0 && (uint8_t)R[2]==0x85 && R[3]==0 &&
+             Word(R, 4)==1 && Word(R, 6)==Count && Word(R, 8)==0 && Word(R, 10)==0 && R.compare(12, qend-12, Q, 12, qend-12)==0;
+  if ( ok && Count )
+    ok = Word(R, qend)==0xC00C && Word(R, qend+2)==1 && Word(R, qend+4)==1 &&
+         Word(R, qend+6)==(CaptiveDnsTtl>>16) && Word(R, qend+8)==(CaptiveDnsTtl & 0xFFFF) && Word(R, qend+10)==4 &&
+         R.compare(qend+12, 4, std::string("\xc0\xa8\x04\x01", 4))==0;
+  return  ok;
+}     // end of Answers
+
+template<class F> static double PerSecond(long Calls, F Body) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) Body();
+  return  Calls/std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+}     // end of PerSecond
+
+int main(int argc, char** argv) {
+  long        Calls = argc>1 ? atol(argv[1]) : 1000000;
+  bool        ok = true;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  ManageWifi  M = {};
+  WifiNet     RunWifi(M);
+  TimePack    SysClock = {};
+  AsyncWebServer  Server(80);
+  RunWifi.RegisterProvisioning(&Server, SysClock);
+  Client = socket(AF_INET, SOCK_DGRAM, 0);
+
+  ok &= RunWifi.ServiceDNS()==0 && !RunWifi.Dns().active();   // no soft AP yet
+  RunWifi.startOTAWifiServer(SysClock);
+  ok &= RunWifi.Dns().active();
+  if ( !ok ) { printf("dns: FAILED, responder not listening on %u\n", CaptiveDnsPort); return 1; }
+
+  // the queries of a phone
+  auto    check = [&](const char* What, bool Pass) { printf("  %-44s %s\n", What, Pass ? "ok" : "FAILED"); ok &= Pass; };
+  std::string q;
+  q = Query("connectivitycheck.gstatic.com", 1);  check("A connectivitycheck.gstatic.com", Answers(q, Ask(RunWifi, q), 1));
+  q = Query("captive.apple.com", 1, 0x01, true);  check("A captive.apple.com with EDNS (cut)", Answers(q, Ask(RunWifi, q), 1));
+  q = Query("www.msftconnecttest.com", 255);      check("ANY www.msftconnecttest.com", Answers(q, Ask(RunWifi, q), 1));
+  q = Query("detectportal.firefox.com", 28);      check("AAAA detectportal.firefox.com (no record)", Answers(q, Ask(RunWifi, q), 0));
+  q = Query("clients3.google.com", 1, 0x10);      // opcode 2 (STATUS)
+  std::string r = Ask(RunWifi, q);
+  check("STATUS opcode (NOTIMP)", r.size()==12 && ((uint8_t)r[2] & 0xF8)==0x90 && r[3]==4 && Word(r, 4)==0);
+  uint32_t  dropped = RunWifi.Dns().Dropped;
+  check("response (dropped)", Ask(RunWifi, Query("captive.apple.com", 1, 0x81), 5).empty());
+  q = Query("captive.apple.com", 1);
+  check("truncated question (dropped)", Ask(RunWifi, q.substr(0, q.size()-6), 5).empty());
+  q = Query("captive.apple.com", 1);
+  q[12] = 64;                                             // a label over 63
+  check("bad label (dropped)", Ask(RunWifi, q, 5).empty() && RunWifi.Dns().Dropped==dropped+3);
+
+  // no allocation
+  q = Query("connectivitycheck.gstatic.com", 1);
+  sockaddr_in a = {};
+  a.sin_family = AF_INET;
+  a.sin_port = htons(CaptiveDnsPort);
+  a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  sendto(Client, q.data(), q.size(), 0, (sockaddr*)&a, sizeof(a));
+  usleep(2000);
+  Blocks = 0;
+  Counting = true;
+  uint8_t   sent = RunWifi.ServiceDNS();
+  Counting = false;
+  char    buf[600];
+  check("ServiceDNS allocates nothing", sent==1 && Blocks==0 && recv(Client, buf, sizeof(buf), 0) > 0);
+
+  // probe URLs
+  static const char* const Probes[] = { "/generate_204", "/hotspot-detect.html", "/connecttest.txt", "/canonical.html" };
+  bool  moved = true;
+  uint8_t phone = 10;
+  for ( const char* P : Probes ) {
+    AsyncWebServerRequest request(P, IPAddress(192,168,4,phone++));
+    moved &= Server.dispatch(request)==302;
+    bool  to = false;
+    for ( auto& H : request.response()->Headers ) to |= H.first=="Location" && H.second=="http://192.168.4.1" ProvisionFormPath;
+    moved &= to;
+  }
+  check("probe URLs: 302 to http://192.168.4.1" ProvisionFormPath, moved);
+
+  // speed
+  uint8_t pkt[CaptiveDnsLen];
+  printf("answer %.0f /S   loopback round trip %.0f /S   (host)\n",
+         PerSecond(Calls, [&]{ memcpy(pkt, q.data(), q.size()); WifiNetDns::answer(pkt, q.size(), sizeof(pkt), 0x0104A8C0); }),
+         PerSecond(Calls/100, [&]{ Ask(RunWifi, q); }));
+
+  // credentials in, the status moves on
+  RunWifi.State().WiFiStatus = Trying_Connect;
+  RunWifi.ServiceDNS();
+  check("stopped out of Configure_OTA", !RunWifi.Dns().active() && Ask(RunWifi, q, 5).empty());
+  printf("%u queries, %u answered, %u dropped\n", RunWifi.Dns().Queries, RunWifi.Dns().Answered, RunWifi.Dns().Dropped);
+  printf("dns: %s\n", ok ? "answers, drops and probe redirects as expected" : "FAILED");
+  close(Client);
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,42 @@
+#pragma once
+/*
+ * EEPROM.h host compatibility header for WifiNet native build
+ * Created by Sachi Gerlitz
+ *
+ * <EEPROM> works on the RAM image of <WifiNetHost().Store>, <commit> writes it back when it changed
+ * (dirty tracking as the ESP8266 core, so <PosixStore> counts the flash writes of the target)
+ */
+#ifndef WifiNetNativeEEPROM_h
+  #define WifiNetNativeEEPROM_h
+
+  #include  "Arduino.h"
+
+  class EEPROMClass {
+    public:
+      void      begin(size_t Size)              { _Size = Size < WifiNetHost().Store->size() ? Size : WifiNetHost().Store->size(); }
+      bool      end()                           { return commit(); }
+      size_t    length()                        { return _Size; }
+      uint8_t   read(int Address)               { return ( (size_t)Address<_Size ) ? WifiNetHost().Store->data()[Address] : 0; }
+      void      write(int Address, uint8_t V)   {
+        if ( (size_t)Address<_Size && WifiNetHost().Store->data()[Address]!=V ) { WifiNetHost().Store->data()[Address] = V; _Dirty = true; } }
+      bool      commit()                        {
+        if ( !_Dirty ) return  true;
+        _Dirty = false;
+        return  WifiNetHost().Store->commit(); }
+      uint8_t*  getDataPtr()                    { _Dirty = true; return WifiNetHost().Store->data(); }
+      const uint8_t* getConstDataPtr() const    { return WifiNetHost().Store->data(); }
+      template<class T> T& get(int Address, T& V)   {
+        if ( Address+sizeof(T) <= _Size ) memcpy(&V, WifiNetHost().Store->data()+Address, sizeof(T));
+        return  V; }
+      template<class T> const T& put(int Address, const T& V) {
+        if ( Address+sizeof(T) <= _Size && memcmp(WifiNetHost().Store->data()+Address, &V, sizeof(T)) ) {
+          memcpy(WifiNetHost().Store->data()+Address, &V, sizeof(T));
+          _Dirty = true; }
+        return  V; }
+    private:
+      size_t    _Size = 0;
+      bool      _Dirty = false;
+  };
+  extern EEPROMClass EEPROM;
+
+#endif  //WifiNetNativeEEPROM_h
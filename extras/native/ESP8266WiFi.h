@@ -0,0 +1,89 @@
+#pragma once
+/*
+ * ESP8266WiFi.h host compatibility header for WifiNet native build
+ * Created by Sachi Gerlitz
+ *
+ * <WiFi> forwards to <WifiNetHost().Radio>; station events are raised by <WiFi.poll> on radio status changes
+ */
+#ifndef WifiNetNativeESP8266WiFi_h
+  #define WifiNetNativeESP8266WiFi_h
+
+  #include  "Arduino.h"
+  #include  <memory>
+  #include  <sys/time.h>
+  #include  <vector>
+
+  enum  wl_status_t { WL_IDLE_STATUS=0, WL_NO_SSID_AVAIL=1, WL_SCAN_COMPLETED=2, WL_CONNECTED=3, WL_CONNECT_FAILED=4,
+                      WL_CONNECTION_LOST=5, WL_WRONG_PASSWORD=6, WL_DISCONNECTED=7 };
+  enum  WiFiMode_t  { WIFI_OFF=0, WIFI_STA=1, WIFI_AP=2, WIFI_AP_STA=3 };
+  struct  WiFiEventStationModeConnected       { String ssid; uint8_t bssid[6]; uint8_t channel; };
+  struct  WiFiEventStationModeDisconnected    { String ssid; uint8_t bssid[6]; int reason; };
+  struct  WiFiEventStationModeAuthModeChanged { uint8_t oldMode; uint8_t newMode; };
+  struct  WiFiEventStationModeGotIP           { IPAddress ip; IPAddress mask; IPAddress gw; };
+  struct  WiFiEventHandlerOpaque              { std::function<void()> Fire; uint8_t Kind; };
+  typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+  class ESP8266WiFiClass {
+    public:
+      bool        mode(WiFiMode_t)                { return true; }
+      void        persistent(bool)                {}
+      bool        setAutoReconnect(bool)          { return true; }
+      bool        disconnect(bool=false)          { WifiNetHost().Radio->disconnect(); return true; }
+      wl_status_t begin(const char* Ssid, const char* Pass=nullptr, int32_t Channel=0, const uint8_t* Bssid=nullptr, bool=true) {
+        WifiNetHost().Radio->begin(Ssid, Pass ? Pass : "", Channel, Bssid); return status(); }
+      wl_status_t status();
+      bool        isConnected()                   { return status()==WL_CONNECTED; }
+      bool        config(IPAddress IP, IPAddress Gateway, IPAddress Mask, IPAddress Dns=IPAddress(), IPAddress=IPAddress()) {
+        return  WifiNetHost().Radio->config(IP, Gateway, Mask, Dns); }
+      IPAddress   localIP()                       { return IPAddress(WifiNetHost().Radio->localIP()); }
+      IPAddress   gatewayIP()                     { return IPAddress(WifiNetHost().Radio->gatewayIP()); }
+      IPAddress   subnetMask()                    { return IPAddress(WifiNetHost().Radio->subnetMask()); }
+      IPAddress   dnsIP(uint8_t=0)                { return IPAddress(WifiNetHost().Radio->dnsIP()); }
+      uint8_t*    BSSID()                         { return (uint8_t*)WifiNetHost().Radio->BSSID(); }
+      int32_t     channel()                       { return WifiNetHost().Radio->channel(); }
+      int32_t     RSSI()                          { return WifiNetHost().Radio->RSSI(); }
+      int8_t      scanNetworks(bool=false, bool=false)  { return WifiNetHost().Radio->scanNetworks(); }
+      String      SSID(uint8_t I)                 { const char* s; int32_t r; uint8_t c; const uint8_t* b;
+                                                    return WifiNetHost().Radio->scanResult(I,&s,&r,&c,&b) ? String(s) : String(); }
+      int32_t     RSSI(uint8_t I)                 { const char* s; int32_t r=0; uint8_t c; const uint8_t* b; WifiNetHost().Radio->scanResult(I,&s,&r,&c,&b); return r; }
+      int32_t     channel(uint8_t I)              { const char* s; int32_t r; uint8_t c=0; const uint8_t* b; WifiNetHost().Radio->scanResult(I,&s,&r,&c,&b); return c; }
+      uint8_t*    BSSID(uint8_t I)                { const char* s; int32_t r; uint8_t c; const uint8_t* b=nullptr; WifiNetHost().Radio->scanResult(I,&s,&r,&c,&b); return (uint8_t*)b; }
+      void        scanDelete()                    {}
+      bool        softAP(const String& Ssid)      { return WifiNetHost().Radio->softAP(Ssid.c_str()); }
+      IPAddress   softAPIP()                      { return IPAddress(WifiNetHost().Radio->softAPIP()); }
+      WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> Handler);
+      WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> Handler);
+      WiFiEventHandler onStationModeAuthModeChanged(std::function<void(const WiFiEventStationModeAuthModeChanged&)> Handler);
+      WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> Handler);
+      void        poll();                         // raise events of radio status change
+    private:
+      std::vector<std::weak_ptr<WiFiEventHandlerOpaque>> _Handlers;
+      uint8_t     _LastStatus = WL_IDLE_STATUS;
+      WiFiEventHandler  add(uint8_t Kind, std::function<void()> Fire);
+  };
+  extern ESP8266WiFiClass WiFi;
+
+  struct  rst_info { uint32_t reason; };
+  #define REASON_DEFAULT_RST      0
+  #define REASON_DEEP_SLEEP_AWAKE 5
+  class EspClass {                                // no RTC memory and heap figures on a host, flash by <WifiNetHost().Flash>
+    public:
+      bool        flashEraseSector(uint32_t Sector);
+      bool        flashWrite(uint32_t Address, const uint32_t* Data, size_t Len);
+      bool        flashRead(uint32_t Address, uint32_t* Data, size_t Len);
+      bool        rtcUserMemoryRead(uint32_t, uint32_t*, size_t)  { return false; }
+      bool        rtcUserMemoryWrite(uint32_t, uint32_t*, size_t) { return false; }
+      rst_info*   getResetInfoPtr()               { static rst_info r = { REASON_DEFAULT_RST }; return &r; }
+      uint32_t    getFreeHeap()                   { return 0; }
+      uint32_t    getMaxFreeBlockSize()           { return 0; }
+      void        deepSleep(uint64_t)             {}
+      void        restart()                       { exit(0); }
+  };
+  extern EspClass ESP;
+
+  void  configTime(int TZoffset, int DSToffset, const char* Server1, const char* Server2=nullptr, const char* Server3=nullptr);
+  bool  getLocalTime(struct tm* Info, uint32_t TimeOutMs=5000);
+  int   WifiNetHostSetTime(const struct timeval* Tv, const void* Tz);    // sets the binding clock, not the host's
+  #define settimeofday  WifiNetHostSetTime
+
+#endif  //WifiNetNativeESP8266WiFi_h
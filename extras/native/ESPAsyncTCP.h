@@ -0,0 +1,21 @@
+#pragma once
+/*
+ * ESPAsyncTCP.h host compatibility header for WifiNet native build
+ * Created by Sachi Gerlitz
+ *
+ * the connection of a request, for its remote IP (<WifiNet::Admit>)
+ */
+#ifndef WifiNetNativeAsyncTCP_h
+  #define WifiNetNativeAsyncTCP_h
+
+  #include  "Arduino.h"
+
+  class AsyncClient {
+    public:
+      AsyncClient(IPAddress Remote = IPAddress(192,168,4,2)) : _Remote(Remote) {}
+      IPAddress remoteIP() const              { return _Remote; }
+    private:
+      IPAddress _Remote;
+  };
+
+#endif  //WifiNetNativeAsyncTCP_h
@@ -0,0 +1,121 @@
+#pragma once
+/*
+ * ESPAsyncWebServer.h host compatibility header for WifiNet native build
+ * Created by Sachi Gerlitz
+ *
+ * no sockets: handlers registered by <on> are called by <AsyncWebServer::dispatch>, which returns the response
+ * (chunked responses are drained through their filler with the given chunk size); the request is gone, and its
+ * <onDisconnect> handler called, when the <AsyncWebServerRequest> is destroyed
+ */
+#ifndef WifiNetNativeAsyncWebServer_h
+  #define WifiNetNativeAsyncWebServer_h
+
+  #include  "Arduino.h"
+  #include  "ESPAsyncTCP.h"
+  #include  <vector>
+  #include  <utility>
+
+  enum  WebRequestMethod { HTTP_GET=0x01, HTTP_POST=0x02, HTTP_ANY=0xFF };
+  typedef std::function<size_t(uint8_t*, size_t, size_t)> AwsResponseFiller;
+  typedef std::function<void(void)> ArDisconnectHandler;
+
+  class AsyncWebParameter {
+    public:
+      AsyncWebParameter(const String& Name, const String& Value) : _Name(Name), _Value(Value) {}
+      const String& name() const    { return _Name; }
+      const String& value() const   { return _Value; }
+    private:
+      String    _Name, _Value;
+  };
+  class AsyncWebHeader {
+    public:
+      AsyncWebHeader(const String& Name, const String& Value) : _Name(Name), _Value(Value) {}
+      const String& name() const    { return _Name; }
+      const String& value() const   { return _Value; }
+    private:
+      String    _Name, _Value;
+  };
+  class AsyncWebServerResponse {
+    public:
+      int       Code = 200;
+      String    ContentType;
+      std::string Body;
+      AwsResponseFiller Filler;
+      std::vector<std::pair<String,String>> Headers;
+      void      addHeader(const String& Name, const String& Value) { Headers.push_back(std::make_pair(Name,Value)); }
+      void      setCode(int C)                { Code = C; }
+  };
+  class AsyncWebServerRequest {
+    public:
+      AsyncWebServerRequest(const String& Url, IPAddress Remote = IPAddress(192,168,4,2)) : _Url(Url), _Client(Remote) {}
+      ~AsyncWebServerRequest()                        { if ( _OnDisconnect ) _OnDisconnect(); delete _Response; }
+      void      onDisconnect(ArDisconnectHandler Fn)  { _OnDisconnect = Fn; }
+      void      addParam(const String& Name, const String& Value) { _Params.push_back(AsyncWebParameter(Name,Value)); }
+      void      addHeader(const String& Name, const String& Value) { _Headers.push_back(AsyncWebHeader(Name,Value)); }
+      bool      hasHeader(const String& Name) const             { return getHeader(Name)!=nullptr; }
+      AsyncWebHeader* getHeader(const String& Name) const {
+        for ( auto& H : _Headers ) if ( H.name()==Name ) return (AsyncWebHeader*)&H;
+        return  nullptr; }
+      size_t    params() const                        { return _Params.size(); }
+      bool      hasParam(const String& Name, bool=false, bool=false) const { return getParam(Name)!=nullptr; }
+      AsyncWebParameter* getParam(const String& Name, bool=false, bool=false) const {
+        for ( auto& P : _Params ) if ( P.name()==Name ) return (AsyncWebParameter*)&P;
+        return  nullptr; }
+      AsyncWebParameter* getParam(size_t I) const     { return I<_Params.size() ? (AsyncWebParameter*)&_Params[I] : nullptr; }
+      const String& url() const                       { return _Url; }
+      AsyncClient* client()                           { return &_Client; }
+      AsyncWebServerResponse* beginResponse(int Code, const String& Type="", const String& Body="") {
+        AsyncWebServerResponse* R = new AsyncWebServerResponse; R->Code=Code; R->ContentType=Type; R->Body=Body.c_str(); return R; }
+      AsyncWebServerResponse* beginResponse_P(int Code, const String& Type, const uint8_t* Data, size_t Len) {
+        AsyncWebServerResponse* R = beginResponse(Code,Type); R->Body.assign((const char*)Data,Len); return R; }
+      AsyncWebServerResponse* beginChunkedResponse(const String& Type, AwsResponseFiller Filler) {
+        AsyncWebServerResponse* R = new AsyncWebServerResponse; R->ContentType=Type; R->Filler=Filler; return R; }
+      void      send(AsyncWebServerResponse* R)       { delete _Response; _Response = R; }
+      void      send(int Code, const String& Type="", const String& Body="") { send(beginResponse(Code,Type,Body)); }
+      void      redirect(const String& Url)           { AsyncWebServerResponse* R = beginResponse(302); R->addHeader("Location",Url); send(R); }
+      AsyncWebServerResponse* response()              { return _Response; }
+    private:
+      String    _Url;
+      AsyncClient _Client;
+      std::vector<AsyncWebParameter> _Params;
+      std::vector<AsyncWebHeader> _Headers;
+      AsyncWebServerResponse* _Response = nullptr;
+      ArDisconnectHandler _OnDisconnect;
+  };
+  typedef std::function<void(AsyncWebServerRequest*)> ArRequestHandlerFunction;
+  class AsyncCallbackWebHandler {};
+
+  class AsyncWebServer {
+    public:
+      AsyncWebServer(uint16_t) {}
+      void      begin() {}
+      AsyncCallbackWebHandler& on(const char* Url, WebRequestMethod, ArRequestHandlerFunction Handler) { return on(Url,Handler); }
+      AsyncCallbackWebHandler& on(const char* Url, ArRequestHandlerFunction Handler) {
+        _Routes.push_back(std::make_pair(String(Url),Handler)); static AsyncCallbackWebHandler h; return h; }
+      void      onNotFound(ArRequestHandlerFunction Handler)  { _NotFound = Handler; }
+      int       dispatch(AsyncWebServerRequest& Request, std::string* Body=nullptr, size_t Chunk=256) {
+        /*
+          * run the handler of <Request.url()>, returns HTTP code (0 - no response) and the body drained into <Body>
+          */
+        ArRequestHandlerFunction Handler = _NotFound;
+        for ( auto& R : _Routes ) if ( R.first==Request.url() ) { Handler = R.second; break; }
+        if ( !Handler ) return 404;
+        Handler(&Request);
+        AsyncWebServerResponse* R = Request.response();
+        if ( !R ) return 0;
+        if ( Body ) {
+          *Body = R->Body;
+          if ( R->Filler ) {
+            std::vector<uint8_t> buf(Chunk);
+            size_t n;
+            while ( (n = R->Filler(buf.data(), Chunk, Body->size())) > 0 ) Body->append((const char*)buf.data(), n);
+          }
+        }
+        return  R->Code;
+      }
+    private:
+      std::vector<std::pair<String,ArRequestHandlerFunction>> _Routes;
+      ArRequestHandlerFunction _NotFound;
+  };
+
+#endif  //WifiNetNativeAsyncWebServer_h
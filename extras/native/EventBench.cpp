@@ -0,0 +1,192 @@
+/*
+ * EventBench.cpp boot to IP of the station event connect path (PlatformIO env:eventbench, env:pollbench)
+ * Created by Sachi Gerlitz
+ *
+ * mocked events - <StationGotIP> / <StationDisconnected> / <StationAuthChanged> called directly, as the SDK
+ *                 event source does: the state, the <onWifiConnected> callback and <IsWifiConnected> follow
+ * PosixRadio    - the station events raised by <WiFi.poll> on radio status change; a loop() of 1 mS passes calls
+ *                 <WiFiTimeOut> every <ReconnectTick> as the application timer does. per run it takes the time from
+ *                 boot to the got-IP callback (event) and to the tick reporting connected (<activeTimeEvent> 2),
+ *                 and the wait of <startWiFi> for the old link to go down
+ *    cold-boot  - no link before <startWiFi>
+ *    rejoin     - <startWiFi> again on a connected station (re-scan)
+ * env:pollbench is the same run with _WIFIEVENTS=0 (fixed 500 mS after the disconnect, IP seen by the tick)
+ * usage: program [Runs] [Seed]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <algorithm>
+#include  <vector>
+
+#define   BenchBudget   30000UL                 // max simulated time[mS] of one connect
+
+static const uint8_t  BenchBssid[6] = {0x02,0x00,0x00,0x00,0x00,0x01};
+static uint32_t   EventAt = 0;                  // <millis> of the got-IP callback, 0 - none
+static uint32_t   EventIP = 0;
+static uint32_t   EventCalls = 0;
+
+static void OnConnected(const ManageWifi& M) {
+  EventAt = millis();
+  EventIP = M.DeviceIP.Addr;
+  EventCalls++;
+}     // end of OnConnected
+
+// **************************************************************************************** //
+static uint32_t Jitter(uint32_t Mean) {
+  return  Mean ? Mean - Mean/4 + rand()%(Mean/2+1) : 0;
+}     // end of Jitter
+
+static uint32_t Pct(std::vector<uint32_t>& V, uint8_t P) {
+  if ( V.empty() ) return  0;
+  std::sort(V.begin(), V.end());
+  return  V[ (V.size()-1)*P/100 ];
+}     // end of Pct
+
+struct  Sample {
+  uint32_t  Wait;                               // [mS] in <startWiFi>
+  uint32_t  Event;                              // [mS] start to got-IP callback, 0 - none
+  uint32_t  Tick;                               // [mS] start to the tick reporting connected, 0 - none
+};
+
+// **************************************************************************************** //
+static Sample Connect(WifiNet& RunWifi, TimePack SysClock) {
+  /*
+    * <startWiFi>, then loop() passes of 1 mS until <WiFiTimeOut> reports connected
+    */
+  Sample    S = { 0, 0, 0 };
+  EventAt = 0;
+  uint32_t  t0 = millis();
+  RunWifi.startWiFi(SysClock);
+  S.Wait = millis()-t0;
+  uint32_t  tick = millis();
+  while ( millis()-t0 < BenchBudget ) {
+    WifiNetHost().Clock->delay(1);
+    yield();                                    // station events
+    if ( millis()-tick < ReconnectTick ) continue;
+    tick = millis();
+    ManageWifi& M = RunWifi.WiFiTimeOut(SysClock);
+    if ( M.activeTimeEvent==2 ) { S.Tick = millis()-t0; break; }
+    M.activeTimeEvent = 0;
+  }
+  if ( EventAt ) S.Event = EventAt-t0;
+  return  S;
+}     // end of Connect
+
+int main(int argc, char** argv) {
+  int       Runs = argc>1 ? atoi(argv[1]) : 200;
+  unsigned  Seed = argc>2 ? atoi(argv[2]) : 1;
+  bool      ok = true;
+  srand(Seed);
+  auto      check = [&](const char* What, bool Pass) { printf("  %-52s %s\n", What, Pass ? "ok" : "FAILED"); ok &= Pass; };
+  PosixStore  Store(nullptr);
+
+  // mocked event source
+  {
+    PosixClock  Clk(true);
+    PosixRadio  Radio(&Clk);
+    PosixLog    Log(nullptr);
+    WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+    EEPROM.begin(Store.size());
+    ManageWifi  SysWifi = {};
+    WifiNet     RunWifi(SysWifi);
+    #if _WIFIEVENTS==1
+      TimePack  SysClock = {};
+    #endif  //_WIFIEVENTS
+    RunWifi.begin();
+    RunWifi.onWifiConnected(OnConnected);
+    RunWifi.State().WiFiStatus = Trying_Connect;
+    EventCalls = 0;
+    RunWifi.StationGotIP(IPAddress(10,0,0,7), IPAddress(255,255,255,0), IPAddress(10,0,0,1));
+    check("got-IP: state Connected, callback with the IP", RunWifi.State().WiFiStatus==Connected &&
+          RunWifi.State().DeviceIP.Addr==(uint32_t)IPAddress(10,0,0,7) && EventCalls==1 && EventIP==(uint32_t)IPAddress(10,0,0,7));
+    #if _WIFIEVENTS==1
+      RunWifi.IsWifiConnected(SysClock);        // the radio is down: only the latched event says connected
+      check("IsWifiConnected takes the latched got-IP", RunWifi.State().WiFiStatus==Connected);
+    #endif  //_WIFIEVENTS
+    RunWifi.StationDisconnected(8);
+    check("disconnected: state Connection_lost", RunWifi.State().WiFiStatus==Connection_lost);
+    #if _WIFIEVENTS==1
+      RunWifi.State().WiFiStatus = Trying_Connect;
+      RunWifi.StationAuthChanged(2, 4);
+      RunWifi.IsWifiConnected(SysClock);
+      check("auth mode changed: the wait restarts (Connection_lost)", RunWifi.State().WiFiStatus==Connection_lost);
+    #endif  //_WIFIEVENTS
+  }
+
+  // persistent state: full credentials (channel and BSSID), written once through the library
+  memset(Store.data(), 0xFF, Store.size());
+  {
+    PosixClock  Clk(true);
+    PosixRadio  Radio(&Clk);
+    PosixLog    Log(nullptr);
+    WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+    EEPROM.begin(Store.size());
+    TimePack    SysClock = {};
+    ManageWifi  SysWifi = {};
+    WifiNet     RunWifi(SysWifi);
+    char  ssid[SSIDlength+1], pass[PASSlength+1];
+    strncpy(ssid, Per_SSID, SSIDlength); ssid[SSIDlength] = 0;
+    strncpy(pass, Per_Pass, PASSlength); pass[PASSlength] = 0;
+    RunWifi.KeepCredentialsEEPROM(SysClock, ssid, pass);
+    RunWifi.KeepChaBssidEEPROM(SysClock, (uint8_t*)BenchBssid, 6);
+  }
+  std::vector<uint8_t>  Image(Store.data(), Store.data()+Store.size());
+
+  // boot to IP against the radio events
+  std::vector<uint32_t> wait[2], event[2], tick[2];
+  uint32_t  missed = 0;
+  for ( int r=0; r<Runs; r++ ) {
+    PosixClock  Clk(true);
+    PosixRadio  Radio(&Clk);
+    PosixLog    Log(nullptr);
+    memcpy(Store.data(), Image.data(), Image.size());
+    WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+    Radio.setLatency(Jitter(300), Jitter(700));
+    SimAP AP = { Per_SSID, Per_Pass, {0}, 6, -60,
+                 IPAddress(192,168,1,50), IPAddress(192,168,1,1), IPAddress(255,255,255,0), IPAddress(192,168,1,1) };
+    memcpy(AP.Bssid, BenchBssid, 6);
+    Radio.addAP(AP);
+    TimePack    SysClock = {};
+    ManageWifi  SysWifi = {};
+    WifiNet     RunWifi(SysWifi);
+    EEPROM.begin(Store.size());
+    RunWifi.begin();
+    RunWifi.onWifiConnected(OnConnected);
+    Clk.advance(rand()%ReconnectTick);          // boot phase against the radio
+    for ( uint8_t k=0; k<2; k++ ) {             // cold boot, then rejoin on the connected station
+      Sample  S = Connect(RunWifi, SysClock);
+      if ( !S.Tick ) { missed++; break; }
+      wait[k].push_back(S.Wait);
+      tick[k].push_back(S.Tick);
+      if ( S.Event ) event[k].push_back(S.Event);
+    }
+  }
+
+  static const char* const Name[2] = { "cold-boot", "rejoin" };
+  printf("WifiNet %s boot to IP, %d runs, seed %u, station events %s\n", WifiNetVersion, Runs, Seed, _WIFIEVENTS ? "on" : "off");
+  printf("%-10s | startWiFi wait  | IP known by event      | IP known by tick [mS]\n", "");
+  printf("%-10s | %6s %6s   | %6s %6s %6s   | %6s %6s %6s\n", "", "median", "max", "min", "median", "p95", "min", "median", "p95");
+  for ( uint8_t k=0; k<2; k++ ) {
+    uint32_t  w50 = Pct(wait[k],50), w100 = Pct(wait[k],100);
+    uint32_t  e0 = Pct(event[k],0), e50 = Pct(event[k],50), e95 = Pct(event[k],95);
+    uint32_t  t0 = Pct(tick[k],0), t50 = Pct(tick[k],50), t95 = Pct(tick[k],95);
+    if ( event[k].empty() ) printf("%-10s | %6u %6u   | %6s %6s %6s   | %6u %6u %6u\n", Name[k], w50, w100, "-", "-", "-", t0, t50, t95);
+    else  printf("%-10s | %6u %6u   | %6u %6u %6u   | %6u %6u %6u\n", Name[k], w50, w100, e0, e50, e95, t0, t50, t95);
+    #if _WIFIEVENTS==1
+      ok &= event[k].size()==tick[k].size() && e50 < t50 && e95 <= t95;
+    #endif  //_WIFIEVENTS
+  }
+  ok &= missed==0;
+  #if _WIFIEVENTS==1
+    check("rejoin: startWiFi waits for the link down only", Pct(wait[1],100) < WiFiDisconnectWait);
+    check("cold boot: startWiFi does not wait", Pct(wait[0],100)==0);
+    printf("events: %s\n", ok ? "IP known at the event, before the tick" : "FAILED");
+  #else
+    printf("events: %s\n", ok ? "off, IP known by the tick" : "FAILED");
+  #endif  //_WIFIEVENTS
+  return  ok ? 0 : 1;
+}     // end of main
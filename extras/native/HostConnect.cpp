@@ -0,0 +1,57 @@
+/*
+ * HostConnect.cpp host run of the WifiNet connection logic (PlatformIO env:native)
+ * Created by Sachi Gerlitz
+ *
+ * joins a simulated AP <Runs> times on a virtual clock and prints the per-phase statistics of <WifiNet>
+ * usage: program [Runs] [-v]       (-v - library log on stdout)
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <chrono>
+
+static const char* PhaseName[PhaseCount] = { "disconnect", "begin", "assoc+auth", "got-IP", "static-IP", "cred-update", "ntp-sync" };
+
+int main(int argc, char** argv) {
+  int     Runs = argc>1 ? atoi(argv[1]) : 20;
+  bool    Verbose = argc>2 && strcmp(argv[2],"-v")==0;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);                       // RAM only, erased
+  PosixLog    Log(Verbose ? stdout : nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  SimAP   AP = { Per_SSID, Per_Pass, {0x02,0x00,0x00,0x00,0x00,0x01}, 6, -55,
+                 IPAddress(192,168,1,50), IPAddress(192,168,1,1), IPAddress(255,255,255,0), IPAddress(192,168,1,1) };
+  Radio.addAP(AP);
+
+  TimePack    SysClock = {};
+  Utilities   RunUtil(SysClock);
+  ManageWifi  SysWifi = {};
+  WifiNet     RunWifi(SysWifi);
+  EEPROM.begin(EEPROM.length() ? EEPROM.length() : 4096);
+  SysWifi = RunWifi.begin(SysWifi);
+
+  auto  t0 = std::chrono::steady_clock::now();
+  int   ok = 0;
+  for ( int r=0; r<Runs; r++ ) {
+    SysWifi = RunWifi.startWiFi(SysClock, SysWifi);
+    for ( int t=0; t<10*ConnTimeOutRep; t++ ) {     // bounded, the soft AP path never reports connected
+      SysWifi = RunWifi.WiFiTimeOut(SysClock, SysWifi);
+      if ( SysWifi.activeTimeEvent==2 ) { ok++; break; }
+      SysWifi.activeTimeEvent = 0;
+      delay(ReconnectTick);
+    }
+    SysWifi.activeTimeEvent = 0;
+  }
+  double  wall = std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+
+  printf("runs %d connected %d virtual %lu mS wall %.3f S\n", Runs, ok, millis(), wall);
+  for ( uint8_t p=0; p<PhaseCount; p++ ) {
+    uint16_t  mn, md, p95;
+    if ( RunWifi.PhaseStats(p, &mn, &md, &p95) ) printf("%-12s min %5u median %5u p95 %5u mS\n", PhaseName[p], mn, md, p95);
+  }
+  return  ok==Runs ? 0 : 1;
+}   // end of main
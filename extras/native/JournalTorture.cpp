@@ -0,0 +1,118 @@
+/*
+ * JournalTorture.cpp power loss and wear run of the flash record journal (PlatformIO env:journal)
+ * Created by Sachi Gerlitz
+ *
+ * wear  - stores the IP record <Writes> times through <WifiNet::storeIPaddress> and counts flash erases,
+ *         against one sector erase per write of the EEPROM commit path; the value must survive a reboot
+ * torn  - random record writes / removes on <WifiNetJournal> with power lost at random points (torn record
+ *         writes, torn sector headers, torn erases during compaction); after every loss the journal is mounted
+ *         again and each key must read back its last acknowledged version, or the new one for the key in flight
+ * usage: program [Writes] [Ops] [Seed]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  "WifiNetJournal.h"
+#include  <vector>
+#include  <algorithm>
+
+#define   TornKeys      4                       // keys used by the torn run
+#define   TornPeriod    6                       // about one power loss armed per <TornPeriod> operations
+
+typedef std::vector<uint8_t> Value;             // empty - no record
+
+// **************************************************************************************** //
+static bool Matches(WifiNetJournal& J, uint8_t Key, const Value& V) {
+  uint8_t buf[JournalMaxRecord];
+  int16_t n = J.read(Key, buf, sizeof(buf));
+  if ( V.empty() ) return  n<0;
+  return  n==(int16_t)V.size() && memcmp(buf, V.data(), n)==0;
+}     // end of Matches
+
+// **************************************************************************************** //
+static bool Wear(long Writes) {
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  PosixFlash  Flash(JournalSectors);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, &Flash });
+  TimePack    SysClock = {};
+  char        ip[16], last[16] = "";
+  {
+    ManageWifi  SysWifi = {};
+    WifiNet     RunWifi(SysWifi);
+    EEPROM.begin(Store.size());
+    RunWifi.begin();
+    for ( long w=0; w<Writes; w++ ) {
+      snprintf(ip, sizeof(ip), "10.0.%ld.%ld", (w/250)%250, w%250+1);
+      if ( RunWifi.storeIPaddress(SysClock, ip, EEPROMipAddress) ) strcpy(last, ip);
+    }
+  }
+  memset(Store.data(), 0xFF, Store.size());     // reboot, EEPROM image lost
+  ManageWifi  SysWifi = {};
+  WifiNet     RunWifi(SysWifi);
+  EEPROM.begin(Store.size());
+  RunWifi.begin();
+  RunWifi.fetchIPaddress(ip, EEPROMipAddress);
+  uint32_t  mn = *std::min_element(Flash.SectorErases.begin(), Flash.SectorErases.end());
+  uint32_t  mx = *std::max_element(Flash.SectorErases.begin(), Flash.SectorErases.end());
+  printf("wear:  %ld IP writes, %u sector erases over %u sectors (min %u max %u), %.1f writes per erase\n",
+         Writes, Flash.Erases, JournalSectors, mn, mx, Flash.Erases ? (double)Writes/Flash.Erases : 0.0);
+  printf("       EEPROM commit path: %ld erases of one sector; EEPROM commits now %u\n", Writes, Store.Commits);
+  printf("       after reboot IP \"%s\" (last stored \"%s\") %s\n", ip, last, strcmp(ip,last)==0 ? "OK" : "LOST");
+  return  strcmp(ip,last)==0 && Store.Commits==0;
+}     // end of Wear
+
+// **************************************************************************************** //
+static bool Torn(long Ops) {
+  PosixFlash  Flash(JournalSectors);
+  WifiNetHostInstall({ nullptr, nullptr, nullptr, nullptr, &Flash });
+  WifiNetJournal  J;
+  J.begin(0, JournalSectors);
+  Value     Acked[TornKeys];
+  long      losses = 0, bad = 0, inFlightNew = 0;
+  for ( long op=0; op<Ops; op++ ) {
+    uint8_t key = rand()%TornKeys;
+    Value   next;
+    if ( rand()%10 ) {                          // write, 10% remove
+      next.resize(1 + rand()%JournalMaxRecord);
+      for ( auto& b : next ) b = rand();
+    }
+    if ( rand()%TornPeriod==0 ) Flash.tearAfter(rand()%(JournalSectorSize + 2*JournalMaxRecord));
+    bool  ok = next.empty() ? J.remove(key) : J.write(key, next.data(), next.size());
+    if ( !Flash.lost() ) {
+      if ( ok ) Acked[key] = next;
+      else      bad++;                          // no power loss, must succeed
+      continue;
+    }
+    losses++;                                   // power lost: reboot and check every key
+    Flash.powerUp();
+    J = WifiNetJournal();
+    J.begin(0, JournalSectors);
+    for ( uint8_t k=0; k<TornKeys; k++ ) {
+      if ( Matches(J, k, Acked[k]) ) continue;
+      if ( k==key && Matches(J, k, next) ) { Acked[k] = next; inFlightNew++; continue; }
+      bad++;
+      printf("torn:  op %ld key %u lost its last version\n", op, k);
+    }
+  }   // end of operations
+  uint32_t  mn = *std::min_element(Flash.SectorErases.begin(), Flash.SectorErases.end());
+  uint32_t  mx = *std::max_element(Flash.SectorErases.begin(), Flash.SectorErases.end());
+  printf("torn:  %ld operations, %ld power losses (%ld kept the write in flight), %ld failures\n", Ops, losses, inFlightNew, bad);
+  printf("       %u sector erases (min %u max %u per sector)\n", Flash.Erases, mn, mx);
+  return  bad==0;
+}     // end of Torn
+
+int main(int argc, char** argv) {
+  long      Writes = argc>1 ? atol(argv[1]) : 10000;
+  long      Ops = argc>2 ? atol(argv[2]) : 20000;
+  unsigned  Seed = argc>3 ? atoi(argv[3]) : 1;
+  srand(Seed);
+  bool  ok = Wear(Writes);
+  ok &= Torn(Ops);
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,236 @@
+/*
+ * OutageBench.cpp fleet wide outage replay against the reconnect policy (PlatformIO env:outagebench)
+ * Created by Sachi Gerlitz
+ *
+ * a site power blip: the router and <Fleet> devices power up together, the devices within <BootSpread> mS,
+ * the router serves its AP <RouterBoot> mS later and admits <RouterRate> joins a second (the rest fail as no AP).
+ * the devices run in lockstep on virtual time, each with its own clock and radio (a blocking wait of one device
+ * does not hold the others); a device sleeps <NextWakeIn> between <WiFiTimeOut> calls as the application does.
+ * per policy it takes
+ *    router load    - <begin> calls a second after the router is up: peak, and joins refused
+ *    recovery       - router up to got-IP: median, p95, last; devices fallen to the soft AP
+ *    waits          - every wait the policy returned, and the radio idle gap between windows (gap - window)
+ * runs: fixed wait without retries (library default, soft AP after one window), fixed wait with retries,
+ * exponential with full jitter, and a user <ReconnectPolicyCB> (equal jitter). it checks that jitter spreads
+ * the load below the fixed wait peak, that no wait passes the cap and that every retrying device recovers.
+ * built with _WIFIEVENTS=0: the host event source is one per process, not one per radio
+ * usage: program [Fleet] [Seed]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <algorithm>
+#include  <map>
+#include  <memory>
+#include  <vector>
+
+#define   BootSpread    3000UL                  // devices power up within[mS]
+#define   RouterBoot    180000UL                // router AP up after[mS]
+#define   RouterRate    20                      // joins admitted a second
+#define   Horizon       900000UL                // simulated time[mS] of one run
+#define   Retries       30                      // <MaxAttempts> of the retrying runs
+#define   Window        ((uint32_t)ConnTimeOutRep*ReconnectTick)
+
+static const uint8_t  BenchBssid[6] = {0x02,0x00,0x00,0x00,0x00,0x01};
+
+struct  Router {
+  uint32_t  UpAt;
+  std::map<uint32_t,uint16_t> Load;             // <begin> calls a second
+  std::map<uint32_t,uint16_t> Admitted;
+  uint32_t  Refused;
+};
+static Router Site;
+
+class FleetRadio : public PosixRadio {          // joins go through the router admission
+  public:
+    FleetRadio(WifiNetClock* Clock) : PosixRadio(Clock), _Clock(Clock) {}
+    bool      begin(const char* Ssid, const char* Pass, uint8_t Channel, const uint8_t* Bssid) {
+      uint32_t  now = _Clock->millis();
+      Starts.push_back(now);
+      clearAPs();
+      if ( now >= Site.UpAt ) {
+        uint32_t  s = (now-Site.UpAt)/1000;
+        Site.Load[s]++;
+        if ( Site.Admitted[s] < RouterRate ) {
+          Site.Admitted[s]++;
+          SimAP AP = { Per_SSID, Per_Pass, {0}, 6, -60,
+                       IPAddress(192,168,1,50), IPAddress(192,168,1,1), IPAddress(255,255,255,0), IPAddress(192,168,1,1) };
+          memcpy(AP.Bssid, BenchBssid, 6);
+          addAP(AP);
+        } else Site.Refused++;
+      }
+      return  PosixRadio::begin(Ssid, Pass, Channel, Bssid);
+    }
+    std::vector<uint32_t> Starts;               // <millis> of the <begin> calls
+  private:
+    WifiNetClock* _Clock;
+};
+
+static std::vector<uint32_t> Returned;          // waits returned by the user policy
+static uint32_t EqualJitter(uint8_t Attempt, uint32_t Base, uint32_t Cap) {
+  uint32_t  expo = ( Attempt<31 && Base <= (Cap >> Attempt) ) ? Base << Attempt : Cap;
+  uint32_t  wait = expo/2 + random(expo/2+1);
+  Returned.push_back(wait);
+  return  wait;
+}     // end of EqualJitter
+
+// **************************************************************************************** //
+static uint32_t Pct(std::vector<uint32_t>& V, uint8_t P) {
+  if ( V.empty() ) return  0;
+  std::sort(V.begin(), V.end());
+  return  V[ (V.size()-1)*P/100 ];
+}     // end of Pct
+
+struct  Result {
+  uint16_t  Peak;                               // most <begin> calls in a second after the router is up
+  uint32_t  Refused;
+  uint32_t  Median, P95, Last;                  // [mS] router up to got-IP
+  uint32_t  Recovered, SoftAP;
+  uint32_t  MaxGap;                             // [mS] longest radio idle gap between windows
+  uint32_t  Wakes;                              // <WiFiTimeOut> calls of the fleet
+};
+
+struct  Device {
+  std::unique_ptr<PosixClock> Clk;
+  std::unique_ptr<FleetRadio> Radio;
+  ManageWifi  SysWifi;
+  std::unique_ptr<WifiNet> Wifi;
+  uint32_t  NextAt;
+  uint32_t  UpAt;                               // got-IP, 0 - not yet
+  bool      Booted;
+};
+
+// **************************************************************************************** //
+static Result Replay(int Fleet, const std::vector<uint8_t>& Image, uint8_t Policy, uint8_t MaxAttempts) {
+  /*
+    * one outage: all devices in lockstep until all are up, in the soft AP or <Horizon>
+    */
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  memcpy(Store.data(), Image.data(), Image.size());
+  Site = Router();
+  Site.UpAt = RouterBoot;
+  Result    R = {};
+  TimePack  SysClock = {};
+  std::vector<Device> Dev(Fleet);
+  for ( Device& D : Dev ) {
+    D.Clk.reset(new PosixClock(true));
+    D.Radio.reset(new FleetRadio(D.Clk.get()));
+    D.Radio->setLatency(200+random(200), 500+random(400));
+    WifiNetHostInstall({ D.Radio.get(), &Store, D.Clk.get(), &Log, nullptr });
+    EEPROM.begin(Store.size());
+    D.SysWifi = {};
+    D.Wifi.reset(new WifiNet(D.SysWifi));
+    D.Wifi->begin();
+    if ( Policy==ReconnectCustom ) D.Wifi->setReconnectPolicy(EqualJitter, MaxAttempts);
+    else  D.Wifi->setReconnectPolicy(Policy, ReconnectBase, ReconnectCap, MaxAttempts);
+    D.NextAt = random(BootSpread);              // power up
+  }
+  std::vector<uint32_t> up;
+  uint32_t  open = Fleet;
+  uint32_t  t = 0;
+  while ( open && t < Horizon ) {
+    t = Horizon;
+    for ( Device& D : Dev ) if ( !D.UpAt && D.SysWifi.WiFiStatus!=Configure_OTA ) t = std::min(t, D.NextAt);
+    for ( Device& D : Dev ) {
+      if ( D.UpAt || D.SysWifi.WiFiStatus==Configure_OTA || D.NextAt > t ) continue;
+      if ( t > D.Clk->millis() ) D.Clk->advance(t-D.Clk->millis());
+      WifiNetHostInstall({ D.Radio.get(), &Store, D.Clk.get(), &Log, nullptr });
+      if ( !D.Booted ) {
+        D.Booted = true;
+        D.Wifi->startWiFi(SysClock);
+        D.NextAt = D.Clk->millis()+ReconnectTick;
+        continue;
+      }
+      R.Wakes++;
+      ManageWifi& M = D.Wifi->WiFiTimeOut(SysClock);
+      if ( M.activeTimeEvent==2 ) {
+        D.UpAt = D.Clk->millis();
+        up.push_back(D.UpAt-RouterBoot);
+        open--;
+        continue;
+      }
+      if ( M.WiFiStatus==Configure_OTA ) { R.SoftAP++; open--; continue; }
+      M.activeTimeEvent = 0;
+      D.NextAt = D.Clk->millis()+std::max(1UL, D.Wifi->NextWakeIn());
+    }
+  }
+  for ( auto& L : Site.Load ) R.Peak = std::max(R.Peak, L.second);
+  R.Refused = Site.Refused;
+  R.Recovered = up.size();
+  R.Median = Pct(up,50); R.P95 = Pct(up,95); R.Last = Pct(up,100);
+  for ( Device& D : Dev )
+    for ( size_t i=1; i<D.Radio->Starts.size(); i++ ) {
+      uint32_t  gap = D.Radio->Starts[i]-D.Radio->Starts[i-1];
+      R.MaxGap = std::max(R.MaxGap, gap > Window ? gap-Window : 0);
+    }
+  return  R;
+}     // end of Replay
+
+int main(int argc, char** argv) {
+  int       Fleet = argc>1 ? atoi(argv[1]) : 200;
+  unsigned  Seed = argc>2 ? atoi(argv[2]) : 1;
+  bool      ok = true;
+  randomSeed(Seed);
+  auto      check = [&](const char* What, bool Pass) { printf("  %-60s %s\n", What, Pass ? "ok" : "FAILED"); ok &= Pass; };
+
+  // persistent state: full credentials (channel and BSSID), written once through the library
+  PosixStore  Store(nullptr);
+  memset(Store.data(), 0xFF, Store.size());
+  {
+    PosixClock  Clk(true);
+    PosixRadio  Radio(&Clk);
+    PosixLog    Log(nullptr);
+    WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+    EEPROM.begin(Store.size());
+    TimePack    SysClock = {};
+    ManageWifi  SysWifi = {};
+    WifiNet     RunWifi(SysWifi);
+    char  ssid[SSIDlength+1], pass[PASSlength+1];
+    strncpy(ssid, Per_SSID, SSIDlength); ssid[SSIDlength] = 0;
+    strncpy(pass, Per_Pass, PASSlength); pass[PASSlength] = 0;
+    RunWifi.KeepCredentialsEEPROM(SysClock, ssid, pass);
+    RunWifi.KeepChaBssidEEPROM(SysClock, (uint8_t*)BenchBssid, 6);
+  }
+  std::vector<uint8_t>  Image(Store.data(), Store.data()+Store.size());
+
+  struct  Run { const char* Name; uint8_t Policy; uint8_t MaxAttempts; Result R; };
+  Run       Runs[] = {
+    { "fixed, no retry",    ReconnectFixed,     0, {} },
+    { "fixed",              ReconnectFixed,     Retries, {} },
+    { "exp full jitter",    ReconnectExpJitter, Retries, {} },
+    { "user equal jitter",  ReconnectCustom,    Retries, {} },
+  };
+  printf("WifiNet %s outage replay, %d devices, seed %u, router up at %lu mS admitting %u joins/S, window %u mS\n",
+         WifiNetVersion, Fleet, Seed, RouterBoot, RouterRate, Window);
+  printf("%-18s | router load    | router up to got-IP [mS]  | soft | max gap | wakes\n", "");
+  printf("%-18s | %5s %8s | %6s %6s %6s %4s | %4s | %7s | %6s\n", "", "peak/S", "refused", "median", "p95", "last", "up", "AP", "[mS]", "");
+  for ( Run& X : Runs ) {
+    Returned.clear();
+    X.R = Replay(Fleet, Image, X.Policy, X.MaxAttempts);
+    Result& R = X.R;
+    printf("%-18s | %6u %7u | %6u %6u %6u %4u | %4u | %7u | %6u\n", X.Name, R.Peak, R.Refused, R.Median, R.P95, R.Last,
+           R.Recovered, R.SoftAP, R.MaxGap, R.Wakes);
+  }
+  Result&   none = Runs[0].R;
+  Result&   fixed = Runs[1].R;
+  Result&   expo = Runs[2].R;
+  Result&   user = Runs[3].R;
+  uint32_t  most = Returned.empty() ? 0 : *std::max_element(Returned.begin(), Returned.end());
+  check("library default: the fleet falls to the soft AP together", none.SoftAP==(uint32_t)Fleet && none.Recovered==0);
+  check("fixed wait: every device recovers", fixed.Recovered==(uint32_t)Fleet && fixed.SoftAP==0);
+  check("exp full jitter: every device recovers, none in the soft AP", expo.Recovered==(uint32_t)Fleet && expo.SoftAP==0);
+  check("user policy: every device recovers, none in the soft AP", user.Recovered==(uint32_t)Fleet && user.SoftAP==0);
+  check("spread: jitter peak load under half of the fixed wait peak", expo.Peak*2 < fixed.Peak && user.Peak*2 < fixed.Peak);
+  check("spread: jitter refuses fewer joins than the fixed wait", expo.Refused < fixed.Refused && user.Refused < fixed.Refused);
+  check("cap: no wait of the user policy over the cap", !Returned.empty() && most <= ReconnectCap);
+  check("cap: no radio idle gap over the cap (one tick slack)", expo.MaxGap <= ReconnectCap+ReconnectTick &&
+        user.MaxGap <= ReconnectCap+ReconnectTick);
+  check("fixed: idle gap is the base wait (one tick slack)", fixed.MaxGap <= ReconnectBase+ReconnectTick);
+  printf("  user policy: %u waits, longest %u mS (cap %u)\n", (unsigned)Returned.size(), most, (unsigned)ReconnectCap);
+  printf("outage: %s\n", ok ? "jitter spreads the router load, waits within the cap, the fleet recovers" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
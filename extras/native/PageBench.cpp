@@ -0,0 +1,297 @@
+/*
+ * PageBench.cpp utility page render throughput (PlatformIO env:pagebench)
+ * Created by Sachi Gerlitz
+ *
+ * renders every utility page <option> by
+ *    strcat    - the 0.3.2 page: each part appended by strcat_P (rescans the page on every append)
+ *    fragments - the fragment list renderer it replaced: one pointer per part, each part measured when it is copied
+ *    template  - <SimpleUtilityPage> on the compile time templates (WifiNetPage.h)
+ * checks the three give the same page, streams an application page registered by <RegisterPage> through
+ * <SendUtilityPage> in several chunk sizes, and prints pages per second of each renderer (the library is built
+ * with the _P functions of the target library, not compiler builtins, see <StrcpyP>)
+ * usage: program [Calls]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <chrono>
+#include  <string>
+
+// on the target the _P string functions are library calls reading flash; called through pointers here, so the
+// host compiler does not turn the reference renderers into copies of known length
+static char*  (*volatile StrcpyP)(char*, const char*) = strcpy;
+static char*  (*volatile StrcatP)(char*, const char*) = strcat;
+static size_t (*volatile StrlenP)(const char*) = strlen;
+static void*  (*volatile MemcpyP)(void*, const void*, size_t) = memcpy;
+#undef  strcpy_P
+#undef  strcat_P
+#undef  strlen_P
+#undef  memcpy_P
+#define strcpy_P(D,S)     StrcpyP(D,S)
+#define strcat_P(D,S)     StrcatP(D,S)
+#define strlen_P(S)       StrlenP(S)
+#define memcpy_P(D,S,N)   MemcpyP(D,S,N)
+
+static const char S_Title[] PROGMEM = "<html><head><title>ESP8266 Utilities</title>";
+static const char S_Style[] PROGMEM = "<style>body {background-color: #9DCDF4; font-family: Arial, Helvetica, Sans-Serif; Color: blue;}</style></head>\n";
+static const char Body_H[]  PROGMEM = "<body>";
+static const char Body_E[]  PROGMEM = "</body></html>";
+static const char S_H1[]    PROGMEM = "<h1>";
+static const char S_H1E[]   PROGMEM = "</h1>";
+static const char S_H2[]    PROGMEM = "<h2>";
+static const char S_H2E[]   PROGMEM = "</h2>";
+static const char S_Form[]  PROGMEM = "<form method='get' action='";
+static const char S_Form1[] PROGMEM = "'>&nbsp;&nbsp;&nbsp;&nbsp;Network SSID:<input type='text' name='";
+static const char S_Form2[] PROGMEM = "'><BR><BR>Network password:<input type='text' name='";
+#if CredSlots>1
+  static const char S_FormP[] PROGMEM = "'><BR><BR>Priority (0-255):<input type='text' name='";
+#endif  //CredSlots
+static const char S_Form3[] PROGMEM = "'>&nbsp;<input type='submit' value='Enter'></form>";
+static const char Msg1[]    PROGMEM = "<h1>SSID and code obtaine are:</h1>";
+static const char Msg2[]    PROGMEM = "<h1>System is about to boot. Bye bye</h1>";
+
+static TimePack   SysClock = {};
+static Utilities  RunUtil(SysClock);
+
+// **************************************************************************************** //
+__attribute__((noinline)) static char* StrcatPage(const ManageWifi& M, char* buf, uint8_t option,
+                                                   const char* Title, const char* FeedBack) {
+  /*
+    * the 0.3.2 <SimpleUtilityPage>
+    */
+  char  action[16];
+  strcpy_P(buf,S_Title);
+  strcat_P(buf,S_Style);
+  strcat_P(buf,Body_H);
+  strcat_P(buf,S_H2);
+  strcat  (buf,M.WhoAmI);
+  strcat_P(buf,_G3);
+  strcat  (buf,M.Version);
+  strcat_P(buf,_G3);
+  memset(action, 0, sizeof(action));
+  strcat  (buf,RunUtil.TimestampToString(SysClock,action));
+  strcat_P(buf,S_H2E);
+  strcat_P(buf,S_H1);
+  strcat_P(buf,Title);
+  strcat_P(buf,S_H1E);
+  switch ( option ) {
+    case  0:
+    case  1:
+    case  2:
+      strcat_P(buf,S_H1); strcat_P(buf,FeedBack); strcat_P(buf,S_H1E);
+      break;
+    case  3:
+      strcat_P(buf,S_Form); strcat_P(buf,CredSettingTrigger+1);
+      strcat_P(buf,S_Form1); strcat_P(buf,SSID_Phrase);
+      strcat_P(buf,S_Form2); strcat_P(buf,PSWD_Phrase);
+      #if CredSlots>1
+        strcat_P(buf,S_FormP); strcat_P(buf,PRIO_Phrase);
+      #endif  //CredSlots
+      strcat_P(buf,S_Form3);
+      break;
+    case  4:
+      strcat_P(buf,Msg1); strcat_P(buf,S_H1);
+      strcat  (buf,M.Ssid); strcat_P(buf,_G3); strcat(buf,M.Password);
+      strcat_P(buf,S_H1E); strcat_P(buf,Msg2);
+      break;
+    default:
+      break;
+  }
+  strcat_P(buf,Body_E);
+  return  buf;
+}     // end of StrcatPage
+
+// **************************************************************************************** //
+// the fragment list renderer, as it was in WifiNet.cpp
+#define PageFrags     24                // max fragments of a utility page
+enum  Codes4Frag {                  // fragments taken from the page context, not from a constant
+  PgStamp=1,                            // time stamp
+  PgSsid=2,                             // SSID
+  PgPass=3,                             // password
+  PgSlots=4
+};
+struct  PageCtx {                       // one utility page: fragment list, values fixed at the request, stream cursor
+  const char* Frag[PageFrags];          // PROGMEM or instance strings, <Codes4Frag> for the values below
+  uint8_t     Count;
+  uint8_t     Cur;                      // fragment being sent
+  uint16_t    Offset;                   // bytes of <Cur> already sent
+  uint16_t    CurLen;                   // length of <Cur>, 0xFFFF not measured yet
+  size_t      Sent;                     // bytes produced
+  char        Stamp[16];
+  char        Ssid[SSIDlength+1];
+  char        Pass[PASSlength+1];
+};
+
+// **************************************************************************************** //
+static const char* PageText(const PageCtx& P, uint8_t Frag) {
+  switch ( (uintptr_t)P.Frag[Frag] ) {
+    case PgStamp:   return  P.Stamp;
+    case PgSsid:    return  P.Ssid;
+    case PgPass:    return  P.Pass;
+    default:        return  P.Frag[Frag];
+  }
+}     // end of PageText
+
+// **************************************************************************************** //
+__attribute__((noinline)) static size_t StreamPage(PageCtx& P, uint8_t* Buf, size_t MaxLen) {
+  /*
+    * copy the next <MaxLen> bytes of the page to <Buf>; the cursor keeps the fragment and the offset in it,
+    * so no fragment is rescanned and no page buffer is built
+    * returns bytes written, 0 once the page was sent
+    */
+  size_t  out = 0;
+  while ( out < MaxLen && P.Cur < P.Count ) {
+    const char* text = PageText(P, P.Cur);
+    if ( P.CurLen == 0xFFFF ) P.CurLen = strlen_P(text);
+    size_t  n = P.CurLen - P.Offset;
+    if ( n > MaxLen-out ) n = MaxLen-out;
+    memcpy_P(Buf+out, text+P.Offset, n);
+    out += n;
+    P.Offset += n;
+    if ( P.Offset < P.CurLen ) break;                   // buffer full mid-fragment
+    P.Cur++;
+    P.Offset = 0;
+    P.CurLen = 0xFFFF;
+  }   // end of fragments
+  P.Sent += out;
+  return  out;
+}     // end of StreamPage
+
+// **************************************************************************************** //
+static void FragmentLayout(PageCtx& P, TimePack _SysClock, const ManageWifi& M, uint8_t option, 
+                        const char* PageTitleName, const char* FeedBack){
+  /*
+    * lay out the utility page of <option> (see <SimpleUtilityPage>) as a fragment list in <P>
+    * the time stamp (and SSID / password for <option> 4) are copied to <P>, the rest is referred to
+    */
+  uint8_t n = 0;
+  memset(P.Stamp, 0, sizeof(P.Stamp));
+  RunUtil.TimestampToString(_SysClock,P.Stamp);        // get current time
+  P.Frag[n++] = S_Title;                                // title and style
+  P.Frag[n++] = S_Style;
+  P.Frag[n++] = Body_H;                                 // body
+  P.Frag[n++] = S_H2;                                   // Line 0 
+  P.Frag[n++] = M.WhoAmI;                               // platform name
+  P.Frag[n++] = _G3;                                    // ' '
+  P.Frag[n++] = M.Version;                              // version
+  P.Frag[n++] = _G3;
+  P.Frag[n++] = (const char*)PgStamp;
+  P.Frag[n++] = S_H2E;
+  P.Frag[n++] = S_H1;                                   // Line 1 
+  P.Frag[n++] = PageTitleName;                          // page title name
+  P.Frag[n++] = S_H1E;
+  switch ( option ) {                                   // line 2
+    case  0:                                            // default root
+    case  1:                                            // error 404
+    case  2:                                            // message from application
+      P.Frag[n++] = S_H1;
+      P.Frag[n++] = FeedBack;                           // message from application
+      P.Frag[n++] = S_H1E;
+      break;
+    case  3:                                            // credential input form
+      P.Frag[n++] = S_Form;
+      P.Frag[n++] = CredSettingTrigger+1;               // insert 'action' field (without '/')
+      P.Frag[n++] = S_Form1;
+      P.Frag[n++] = SSID_Phrase;                        // insert SSID field name
+      P.Frag[n++] = S_Form2;
+      P.Frag[n++] = PSWD_Phrase;                        // insert pasword field name
+      #if CredSlots>1
+        P.Frag[n++] = S_FormP;
+        P.Frag[n++] = PRIO_Phrase;                      // insert priority field name
+      #endif  //CredSlots
+      P.Frag[n++] = S_Form3;
+      break;
+    case  4:                                            // credential input acknowledge
+      strcpy(P.Ssid,M.Ssid);
+      strcpy(P.Pass,M.Password);
+      P.Frag[n++] = Msg1;                               // SSID and PW header
+      P.Frag[n++] = S_H1;
+      P.Frag[n++] = (const char*)PgSsid;                // print SSID
+      P.Frag[n++] = _G3;
+      P.Frag[n++] = (const char*)PgPass;                // print passcode
+      P.Frag[n++] = S_H1E;
+      P.Frag[n++] = Msg2;                               // bye bye
+      break;
+    case  5:                                            // do nothing
+    default:
+      break;
+  }
+  P.Frag[n++] = Body_E;
+  P.Count = n;
+  P.Cur = 0;
+  P.Offset = 0;
+  P.CurLen = 0xFFFF;
+  P.Sent = 0;
+}     // end of FragmentLayout
+
+__attribute__((noinline)) static char* FragmentPage(const ManageWifi& M, char* buf, uint8_t option,
+                                                     const char* Title, const char* FeedBack) {
+  PageCtx P;
+  FragmentLayout(P, SysClock, M, option, Title, FeedBack);
+  buf[StreamPage(P, (uint8_t*)buf, (size_t)-1 >> 1)] = 0x00;
+  return  buf;
+}     // end of FragmentPage
+
+// **************************************************************************************** //
+WifiNetPageDef(RelayPage, TplHead "<h1>Relay is " TplApp0 "</h1><h2>" TplApp1 " switches since " TplStamp "</h2>" TplTail);
+
+template<class F> static double PagesPerS(long Calls, F Body) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) Body();
+  return  Calls/std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+}     // end of PagesPerS
+
+int main(int argc, char** argv) {
+  long        Calls = argc>1 ? atol(argv[1]) : 200000;
+  bool        ok = true;
+  PosixStore  Store(nullptr);
+  WifiNetHostInstall({ nullptr, &Store, nullptr, nullptr, nullptr });
+  EEPROM.begin(Store.size());
+  ManageWifi  M = {};
+  strcpy(M.WhoAmI, "ESP8266-Relay");
+  strcpy(M.Version, "0.3.2");
+  strcpy(M.Ssid, "HomeNetwork-5G");
+  strcpy(M.Password, "correct horse");
+  WifiNet     RunWifi(M);
+  static char a[4096], b[4096], c[4096];
+  static const char Title[] PROGMEM = "Credenitial input form";
+  static const char FeedBack[] PROGMEM = "Try another input";
+
+  printf("option      bytes   strcat[pages/S]  fragments[pages/S]  template[pages/S]  template/fragments\n");
+  for ( uint8_t option=0; option<6; option++ ) {
+    StrcatPage(M, a, option, Title, FeedBack);
+    FragmentPage(M, b, option, Title, FeedBack);
+    RunWifi.SimpleUtilityPage(SysClock, M, c, option, Title, FeedBack, nullptr);
+    if ( strcmp(a, b) || strcmp(a, c) ) { printf("option %u: pages differ\n", option); ok = false; }
+    double  s = PagesPerS(Calls, [&]{ StrcatPage(M, a, option, Title, FeedBack); });
+    double  f = PagesPerS(Calls, [&]{ FragmentPage(M, b, option, Title, FeedBack); });
+    double  t = PagesPerS(Calls, [&]{ RunWifi.SimpleUtilityPage(SysClock, M, c, option, Title, FeedBack, nullptr); });
+    printf("%6u  %9zu  %15.0f  %18.0f  %17.0f  %18.2f\n", option, strlen(a), s, f, t, t/f);
+  }
+
+  // application page, streamed
+  AsyncWebServer  Server(80);
+  size_t          len = 0;
+  ok &= RunWifi.RegisterPage(6, RelayPage) && !RunWifi.RegisterPage(PageOptions, RelayPage);
+  Server.on("/relay", [&](AsyncWebServerRequest* request) {
+    char  count[8];
+    snprintf(count, sizeof(count), "%d", 42);           // temporary: copied into the page
+    const char* Values[] = { "on", count };
+    len = RunWifi.SendUtilityPage(request, SysClock, 6, Title, "", 200, Values, 2); });
+  std::string expect = std::string(a, strstr(a, "</h1>")+5-a) +
+                       "<h1>Relay is on</h1><h2>42 switches since </h2></body></html>";
+  for ( size_t chunk : { 1, 7, 64, 1460 } ) {
+    AsyncWebServerRequest request("/relay");
+    std::string body;
+    int   code = Server.dispatch(request, &body, chunk);
+    if ( code!=200 || body!=expect || len!=body.size() ) {
+      printf("application page, chunk %zu: code %d length %zu/%zu\n%s\n", chunk, code, len, body.size(), body.c_str());
+      ok = false;
+    }
+  }
+  printf("pages: %s\n", ok ? "identical, application page streamed" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
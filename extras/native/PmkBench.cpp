@@ -0,0 +1,172 @@
+/*
+ * PmkBench.cpp test vectors and benchmark of the WPA2 key derivation (PlatformIO env:pmkbench, <_PMKCACHE>)
+ * Created by Sachi Gerlitz
+ *
+ * vectors  - SHA1 (FIPS 180), HMAC-SHA1 (RFC 2202), PBKDF2-HMAC-SHA1 (RFC 6070) and WPA2 PMK (IEEE 802.11i H.4)
+ * derive   - host time of one PMK by <WifiNetPmk::derive> (pad states hashed once) against a plain PBKDF2 that
+ *            runs a full HMAC per iteration
+ * connect  - simulated time to got-IP of a stored network joined by passphrase (the SDK derives the key, assumed
+ *            <DeriveMs>) and by the kept key, through <startWiFi> / <WiFiTimeOut>; the key is derived by
+ *            <ServiceEEPROM> in loop() after the connect path, never inside it
+ * usage: program [Derivations] [DeriveMs]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  "WifiNetPmk.h"
+#include  <chrono>
+
+struct  Vector {
+  const char* Pass;
+  const char* Salt;
+  uint32_t    Iterations;
+  uint8_t     Len;
+  const char* Hex;
+};
+static const Vector Pbkdf2Vectors[] = {         // RFC 6070
+  { "password", "salt", 1, 20,    "0c60c80f961f0e71f3a9b524af6012062fe037a6" },
+  { "password", "salt", 2, 20,    "ea6c014dc72d6f8ccd1ed92ace1d41f0d8de8957" },
+  { "password", "salt", 4096, 20, "4b007901b765489abead49d926f721d065a429c1" },
+  { "passwordPASSWORDpassword", "saltSALTsaltSALTsaltSALTsaltSALTsalt", 4096, 25,
+                                  "3d2eec4fe41c849b80c8d83662c0e44a8b291a964cf2f07038" },
+};
+static const Vector PmkVectors[] = {            // IEEE 802.11i-2004 H.4 (passphrase, SSID)
+  { "password", "IEEE", 4096, 32, "f42c6fc52df0ebef9ebb4b90b38a5f902e83fe1b135a70e23aed762e9710a12e" },
+  { "ThisIsAPassword", "ThisIsASSID", 4096, 32, "0dc0d6eb90555ed6419756b9a15ec3e3209b63df707dd508d14581f8982721af" },
+};
+
+// **************************************************************************************** //
+static bool Check(const char* Name, const uint8_t* Got, uint8_t Len, const char* Hex) {
+  char  h[2*64+1];
+  for ( uint8_t i=0; i<Len; i++ ) snprintf(h+2*i, 3, "%02x", Got[i]);
+  bool  ok = strcmp(h, Hex)==0;
+  if ( !ok ) printf("vector %-10s FAILED: got %s expected %s\n", Name, h, Hex);
+  return  ok;
+}     // end of Check
+
+static bool Vectors() {
+  bool      ok = true;
+  uint8_t   out[64];
+  WifiNetPmk::sha1((const uint8_t*)"abc", 3, out);
+  ok &= Check("sha1", out, 20, "a9993e364706816aba3e25717850c26c9cd0d89d");
+  const char* two = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";  // 56 bytes, length in a 2nd block
+  WifiNetPmk::sha1((const uint8_t*)two, strlen(two), out);
+  ok &= Check("sha1", out, 20, "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+  uint8_t   key[20];
+  memset(key, 0x0B, sizeof(key));
+  WifiNetPmk::hmac(key, sizeof(key), (const uint8_t*)"Hi There", 8, out);
+  ok &= Check("hmac", out, 20, "b617318655057264e28bc0b6fb378c8ef146be00");
+  uint8_t   longKey[80];                        // RFC 2202 case 6, key longer than the block
+  memset(longKey, 0xAA, sizeof(longKey));
+  const char* msg = "Test Using Larger Than Block-Size Key - Hash Key First";
+  WifiNetPmk::hmac(longKey, sizeof(longKey), (const uint8_t*)msg, strlen(msg), out);
+  ok &= Check("hmac", out, 20, "aa4ae5e15272d00e95705637ce8a3b55ed402112");
+  for ( auto& V : Pbkdf2Vectors ) {
+    WifiNetPmk::pbkdf2((const uint8_t*)V.Pass, strlen(V.Pass), (const uint8_t*)V.Salt, strlen(V.Salt), V.Iterations, out, V.Len);
+    ok &= Check("pbkdf2", out, V.Len, V.Hex);
+  }
+  for ( auto& V : PmkVectors ) {
+    WifiNetPmk::derive(V.Pass, V.Salt, out);
+    ok &= Check("pmk", out, V.Len, V.Hex);
+  }
+  printf("vectors: %s\n", ok ? "all passed" : "FAILED");
+  return  ok;
+}     // end of Vectors
+
+// **************************************************************************************** //
+static void PlainPmk(const char* Pass, const char* Ssid, uint8_t Pmk[PmkLength]) {
+  /*
+    * PBKDF2 by the definition: every U(n) is a full HMAC (key pads hashed again each time)
+    */
+  uint8_t   msg[64+4], u[20], t[20];
+  size_t    sl = strlen(Ssid);
+  memcpy(msg, Ssid, sl);
+  for ( uint8_t block=1; block<=2; block++ ) {
+    msg[sl] = 0; msg[sl+1] = 0; msg[sl+2] = 0; msg[sl+3] = block;
+    WifiNetPmk::hmac((const uint8_t*)Pass, strlen(Pass), msg, sl+4, u);
+    memcpy(t, u, 20);
+    for ( uint32_t n=1; n<PmkIterations; n++ ) {
+      WifiNetPmk::hmac((const uint8_t*)Pass, strlen(Pass), u, 20, u);
+      for ( uint8_t i=0; i<20; i++ ) t[i] ^= u[i];
+    }
+    memcpy(Pmk+20*(block-1), t, block==1 ? 20 : PmkLength-20);
+  }
+}     // end of PlainPmk
+
+template<class F> static double MsPer(long Calls, F Body) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) Body();
+  return  std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-t0).count()/Calls;
+}     // end of MsPer
+
+// **************************************************************************************** //
+static uint32_t Connect(PosixStore& Store, uint32_t DeriveMs, bool* Kept) {
+  /*
+    * one boot on stored credentials, simulated time[mS] from <startWiFi> to got-IP
+    * <Kept> the key record is set when the connect path is over (before loop() runs)
+    */
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  Radio.setKeyDerivation(DeriveMs);
+  SimAP   AP = { Per_SSID, Per_Pass, {0x02,0x00,0x00,0x00,0x00,0x01}, 6, -55,
+                 IPAddress(192,168,1,50), IPAddress(192,168,1,1), IPAddress(255,255,255,0), IPAddress(192,168,1,1) };
+  Radio.addAP(AP);
+  TimePack    SysClock = {};
+  ManageWifi  SysWifi = {};
+  WifiNet     RunWifi(SysWifi);
+  EEPROM.begin(Store.size());
+  RunWifi.begin();
+  uint32_t    t0 = millis(), gotIP = 0;
+  RunWifi.startWiFi(SysClock);
+  for ( int t=0; t<600 && RunWifi.State().activeTimeEvent!=2; t++ ) {    // on to the got-IP path (keeps the key)
+    RunWifi.WiFiTimeOut(SysClock);
+    if ( !gotIP && RunWifi.State().WiFiStatus==Connected ) gotIP = millis()-t0;
+    delay(ReconnectTick);
+  }
+  PmkRecord   R;
+  EEPROM.get(EEPROMpmkAddress, R);
+  *Kept = R.Marker=='%';
+  RunWifi.ServiceEEPROM();                      // loop(): the key of the network joined
+  return  RunWifi.State().activeTimeEvent==2 ? gotIP : 0;
+}     // end of Connect
+
+int main(int argc, char** argv) {
+  long      Derivations = argc>1 ? atol(argv[1]) : 20;
+  uint32_t  DeriveMs = argc>2 ? atol(argv[2]) : 1200;
+  bool      ok = Vectors();
+
+  uint8_t   a[PmkLength], b[PmkLength];
+  double    plain = MsPer(Derivations, [&]{ PlainPmk("correct horse battery", "HomeNetwork-5G", a); });
+  double    pads = MsPer(Derivations, [&]{ WifiNetPmk::derive("correct horse battery", "HomeNetwork-5G", b); });
+  ok &= memcmp(a, b, PmkLength)==0;
+  printf("derive:  plain PBKDF2 %7.2f mS   pad states kept %7.2f mS   (x%.2f, host)\n", plain, pads, plain/pads);
+
+  PosixStore  Store(nullptr);
+  PosixClock  Clk(true);
+  PosixLog    Log(nullptr);
+  uint32_t    first, second;
+  bool        kept1, kept2;
+  WifiNetHostInstall({ nullptr, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  {                                             // provisioned as by the setting page: credentials (and key) stored
+    ManageWifi  M = {};
+    WifiNet     W(M);
+    TimePack    C = {};
+    uint8_t     bssid[6] = {0x02,0x00,0x00,0x00,0x00,0x01};
+    W.KeepCredentialsEEPROM(C, (char*)Per_SSID, (char*)Per_Pass);
+    W.KeepChaBssidEEPROM(C, bssid, 6);
+  }
+  EEPROM.write(EEPROMpmkAddress, '?');          // 1st boot: no key kept yet (upgrade from a passphrase build)
+  EEPROM.commit();
+  first = Connect(Store, DeriveMs, &kept1);
+  second = Connect(Store, DeriveMs, &kept2);
+  printf("connect: passphrase %5u mS   kept key %5u mS   (SDK key derivation assumed %u mS)\n", first, second, DeriveMs);
+  printf("key:     %s\n", !kept1 && kept2 ? "derived by ServiceEEPROM in loop(), not in the connect path" : "FAILED");
+  ok &= first && second && second + DeriveMs == first && !kept1 && kept2;
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,133 @@
+/*
+ * PoolBench.cpp web handler contexts in the slab pool (PlatformIO env:poolbench)
+ * Created by Sachi Gerlitz
+ *
+ * serves the utility page <Requests> times by
+ *    captured  - the page context copied into the response filler (a heap block per request, as before the pool)
+ *    pooled    - <SendUtilityPage>: the context in a slab of <WifiNet::Pool>, the filler holds a pointer
+ * and counts the heap blocks of the handler and its response (the host server stub allocates the same for both)
+ * then keeps <PoolSlabs>+2 requests open at once: the extra ones get 503 with Retry-After, the high water mark
+ * and the exhausted counter show on /metrics, and every slab is back once the requests are gone
+ * usage: program [Requests]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <cstdlib>
+#include  <memory>
+#include  <new>
+#include  <string>
+#include  <vector>
+
+// heap blocks and bytes, counted while <Counting>
+static bool     Counting = false;
+static size_t   Blocks = 0, Bytes = 0;
+void* operator new(size_t N) {
+  if ( Counting ) { Blocks++; Bytes += N; }
+  void*   p = malloc(N ? N : 1);
+  if ( !p ) throw std::bad_alloc();
+  return  p;
+}
+// out of line, so gcc does not pair the free with the malloc of <new> and warn
+__attribute__((noinline)) void operator delete(void* P) noexcept         { free(P); }
+__attribute__((noinline)) void operator delete(void* P, size_t) noexcept { free(P); }
+
+WifiNetPageDef(BenchPage, TplHead "<h2>Relay is " TplApp0 "</h2>" TplTail);
+
+struct  Tally {
+  size_t  Blocks, Bytes;
+};
+
+// **************************************************************************************** //
+template<class F> static Tally Count(AsyncWebServer& Server, const char* Url, long Requests, F Check) {
+  Tally   T = {0, 0};
+  for ( long r=0; r<Requests; r++ ) {
+    AsyncWebServerRequest request(Url);
+    std::string body;
+    body.reserve(1024);
+    Blocks = Bytes = 0;
+    Counting = true;
+    int     code = Server.dispatch(request, &body, 64);   // the page streams in full
+    Counting = false;
+    T.Blocks += Blocks;
+    T.Bytes += Bytes;
+    Check(code, body);
+  }
+  return  T;
+}     // end of Count
+
+int main(int argc, char** argv) {
+  long        Requests = argc>1 ? atol(argv[1]) : 1000;
+  bool        ok = true;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  ManageWifi  M = {};
+  strcpy(M.WhoAmI, "ESP8266-Relay");
+  strcpy(M.Version, "0.3.2");
+  WifiNet     RunWifi(M);
+  TimePack    SysClock = {};
+  AsyncWebServer  Server(80);
+  static const char Title[] PROGMEM = "Relay";
+  static const char* const On[] = { "on" };
+  RunWifi.RegisterPage(6, BenchPage);
+  RunWifi.RegisterMetrics(&Server);
+  Server.on("/pooled", [&](AsyncWebServerRequest* request) { RunWifi.SendUtilityPage(request, SysClock, 6, Title, "", 200, On, 1); });
+  Server.on("/captured", [&](AsyncWebServerRequest* request) {
+    WifiNetPage P;                                        // the handler before the pool
+    P.begin(BenchPage);
+    P.set(SlotWhoAmI, M.WhoAmI);
+    P.set(SlotVersion, M.Version);
+    P.keep(SlotStamp, "00:00:00");
+    P.set(SlotTitle, Title);
+    P.keep(SlotApp, On[0]);
+    request->send(request->beginChunkedResponse("text/html",
+      [P](uint8_t *buf, size_t maxLen, size_t index) mutable -> size_t { return P.render(buf, maxLen); })); });
+
+  // heap blocks per request
+  std::string   page;
+  auto  check = [&](int Code, const std::string& Body) {
+    if ( page.empty() ) page = Body.substr(Body.find("<h2>Relay"));
+    ok &= Code==200 && Body.find(page)!=std::string::npos; };
+  Tally cap = Count(Server, "/captured", Requests, check);
+  Tally pool = Count(Server, "/pooled", Requests, check);
+  ok &= RunWifi.Pool().InUse==0 && RunWifi.Pool().Borrows==(uint32_t)Requests;
+  printf("context %zu bytes, pool %u slabs of %u bytes\n", sizeof(WifiNetPage), PoolSlabs, PoolSlabSize);
+  printf("per request:  captured %.2f blocks %.0f bytes   pooled %.2f blocks %.0f bytes   (handler, response and stub)\n",
+         (double)cap.Blocks/Requests, (double)cap.Bytes/Requests, (double)pool.Blocks/Requests, (double)pool.Bytes/Requests);
+  ok &= pool.Blocks < cap.Blocks && cap.Bytes-pool.Bytes >= Requests*sizeof(WifiNetPage);
+
+  // <PoolSlabs>+2 requests open at once
+  std::vector<std::unique_ptr<AsyncWebServerRequest>> open;
+  int     served = 0, refused = 0;
+  for ( uint8_t r=0; r<PoolSlabs+2; r++ ) {
+    open.emplace_back(new AsyncWebServerRequest("/pooled"));
+    int   code = Server.dispatch(*open.back());
+    served += code==200;
+    if ( code==503 ) {
+      refused++;
+      bool  retry = false;
+      for ( auto& H : open.back()->response()->Headers ) retry |= H.first=="Retry-After";
+      ok &= retry;
+    }
+  }
+  ok &= served==PoolSlabs && refused==2 && RunWifi.Pool().InUse==PoolSlabs;
+  open.clear();                                           // clients gone
+  AsyncWebServerRequest scrape(MetricsPath);
+  std::string metrics;
+  ok &= Server.dispatch(scrape, &metrics, 128)==200;
+  ok &= metrics.find("wifinet_pool_exhausted_total 2\n")!=std::string::npos &&
+        metrics.find("# TYPE wifinet_pool_exhausted_total counter\n")!=std::string::npos &&
+        metrics.find("wifinet_pool_high_water " + std::to_string(PoolSlabs) + "\n")!=std::string::npos &&
+        metrics.find("wifinet_pool_in_use 1\n")!=std::string::npos;   // the scrape itself
+  printf("%u requests open: %d served, %d refused (503), high water %u, exhausted %u\n", PoolSlabs+2, served, refused,
+         RunWifi.Pool().HighWater, RunWifi.Pool().Exhausted);
+  printf("pool: %s\n", ok ? "no heap block for the page context, 503 when exhausted, all slabs returned" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,106 @@
+/*
+ * QueueTorture.cpp web handler / loop() command queue under two threads (PlatformIO env:queuetsan, ThreadSanitizer)
+ * Created by Sachi Gerlitz
+ *
+ * queue      - a producer thread posts <Items> sequence numbered records into a small <WifiNetQueue>, the main thread
+ *              takes them: every record arrives once, in order and whole (no torn copy), full and empty are hit
+ * handlers   - a thread plays the network callback context: credential form submissions through <ServiceOTACred>,
+ *              /erase and /ResetSystem posts; the main thread plays loop() with <ServiceCommands>.
+ *              the stored credentials are the last ones accepted, and every accepted command ran once
+ * built with -fsanitize=thread: a data race between the two sides fails the run (TSan exit code)
+ * usage: program [Items] [Forms]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <atomic>
+#include  <string>
+#include  <thread>
+
+struct  Record {
+  uint32_t  Seq;
+  uint8_t   Fill[27];                   // all <Seq> & 0xFF, a torn copy mixes two records
+};
+
+// **************************************************************************************** //
+static bool  QueueRun(uint32_t Items, uint32_t* Full, uint32_t* Empty) {
+  static WifiNetQueue<Record,4> Q;
+  std::thread producer([&] {
+    Record  R;
+    for ( uint32_t i=0; i<Items; ) {
+      R.Seq = i;
+      memset(R.Fill, i & 0xFF, sizeof(R.Fill));
+      if ( Q.post(R) ) i++;
+      else             { (*Full)++; std::this_thread::yield(); }
+    }
+  });
+  bool    ok = true;
+  Record  R;
+  for ( uint32_t next=0; next<Items; ) {
+    if ( !Q.take(R) ) { (*Empty)++; std::this_thread::yield(); continue; }
+    ok &= R.Seq==next++;
+    for ( uint8_t b : R.Fill ) ok &= b==(R.Seq & 0xFF);
+  }
+  producer.join();
+  return  ok && !Q.take(R);
+}     // end of QueueRun
+
+int main(int argc, char** argv) {
+  uint32_t    Items = argc>1 ? atol(argv[1]) : 1000000;
+  uint32_t    Forms = argc>2 ? atol(argv[2]) : 2000;
+  uint32_t    full = 0, empty = 0;
+  bool        ok = QueueRun(Items, &full, &empty);
+  printf("queue:    %u records, producer found it full %u times, consumer empty %u times\n", Items, full, empty);
+
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  ManageWifi  M = {};
+  strcpy(M.WhoAmI, "ESP8266-Relay");
+  strcpy(M.Version, "0.3.2");
+  WifiNet     RunWifi(M);
+  TimePack    SysClock = {};
+  AsyncWebServer  Server(80);
+  Server.on(CredSettingTrigger, [&](AsyncWebServerRequest* request) { RunWifi.ServiceOTACred(request, SysClock); });
+  Server.on("/erase", [&](AsyncWebServerRequest*) { RunWifi.PostCommand(CmdErase); });
+
+  std::atomic<uint32_t> accepted(0), busy(0);
+  std::atomic<bool>     done(false);
+  std::string           last;
+  std::thread handlers([&] {                              // network callback context
+    for ( uint32_t f=0; f<Forms; f++ ) {
+      AsyncWebServerRequest request(CredSettingTrigger);
+      std::string ssid = "Net" + std::to_string(f);
+      request.addParam(SSID_Phrase, ssid.c_str());
+      request.addParam(PSWD_Phrase, "Kalisher46apt7");
+      std::string body;
+      int   code = Server.dispatch(request, &body, 256);
+      if ( code==200 ) { accepted++; last = ssid; }
+      else             { busy++; std::this_thread::yield(); }
+    }
+    done = true;
+  });
+  uint32_t  ran = 0;
+  while ( !done ) {                                       // loop()
+    ran += RunWifi.ServiceCommands(SysClock);
+    std::this_thread::yield();
+  }
+  handlers.join();
+  ran += RunWifi.ServiceCommands(SysClock);
+  ManageWifi& S = RunWifi.State();
+  ok &= ran==accepted && accepted+busy==Forms && accepted>0;
+  ok &= last==S.Ssid && !strcmp(S.Password, "Kalisher46apt7") && S.activeTimeEvent==4;
+  AsyncWebServerRequest erase("/erase");
+  Server.dispatch(erase);
+  ok &= RunWifi.ServiceCommands(SysClock)==1 && RunWifi.ServiceCommands(SysClock)==0;
+  printf("handlers: %u forms, %u accepted and run by loop(), %u answered busy (503), stored \"%s\"\n",
+         Forms, accepted.load(), busy.load(), S.Ssid);
+  printf("torture: %s\n", ok ? "no loss, no reorder, no torn record" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,122 @@
+/*
+ * RecordsBench.cpp typed application records <WifiNetRecords> on the EEPROM image (PlatformIO env:recordsbench)
+ * Created by Sachi Gerlitz
+ *
+ * WifiNetRecords.h is included first: it builds on its own. The run checks
+ *    offsets       - declaration order from <WifiNetAppStart>, tag + <RecordSlot> per record, a 2nd registry at <End>
+ *    unwritten     - erased EEPROM reads as not written, the defaults are kept
+ *    whole copies  - read back equal, an unchanged write does not commit, writes share one commit
+ *    v1 -> v2      - the default migration keeps the old bytes as prefix (new fields keep defaults), a <RecordMigrate>
+ *                    converts; the migrated record is written back and reads as v2, the next record is not moved
+ *    erase         - the record reads as not written again
+ * usage: program
+ */
+#include  "WifiNetRecords.h"
+#include  "WifiNetHalPosix.h"
+
+struct  SettingsV1 {                            // as stored by the old firmware
+  static const uint8_t  RecordVersion = 1;
+  static const uint16_t RecordSlot = 48;
+  uint16_t  Interval;
+  char      Topic[16];
+};
+struct  Settings {                              // v2: a field added at the end
+  static const uint8_t  RecordVersion = 2;
+  static const uint16_t RecordSlot = 48;
+  uint16_t  Interval;
+  char      Topic[16];
+  uint32_t  Retain;
+};
+struct  CalibrationV1 {
+  static const uint8_t  RecordVersion = 1;
+  static const uint16_t RecordSlot = sizeof(int32_t);   // room kept for the next version
+  int16_t   OffsetC10;                          // [0.1 C]
+};
+struct  Calibration {                           // v2: milli degrees, converted by <RecordMigrate>
+  static const uint8_t  RecordVersion = 2;
+  static const uint16_t RecordSlot = sizeof(int32_t);
+  int32_t   OffsetMilli;                        // [0.001 C]
+  static bool RecordMigrate(Calibration& R, uint8_t From, const uint8_t* Old, uint16_t OldLen) {
+    if ( From!=1 || OldLen!=sizeof(CalibrationV1) ) return  false;
+    CalibrationV1 V;
+    memcpy(&V, Old, sizeof(V));
+    R.OffsetMilli = V.OffsetC10*100;
+    return  true;
+  }
+};
+struct  Counter {
+  static const uint8_t  RecordVersion = 1;
+  uint32_t  Boots;
+};
+
+typedef WifiNetRecords<WifiNetAppStart, SettingsV1, CalibrationV1, Counter> OldRecords;
+typedef WifiNetRecords<WifiNetAppStart, Settings, Calibration, Counter> AppRecords;
+typedef WifiNetRecords<AppRecords::End, Counter> MoreRecords;
+
+static_assert(AppRecords::offset<Settings>()==WifiNetAppStart, "1st record at <Base>");
+static_assert(AppRecords::offset<Calibration>()==WifiNetAppStart+4+48, "tag and <RecordSlot>");
+static_assert(AppRecords::offset<Counter>()==OldRecords::offset<Counter>(), "grown records in their slot do not move the next one");
+static_assert(MoreRecords::offset<Counter>()==AppRecords::End, "2nd registry at the <End> of the 1st");
+
+int main() {
+  bool        ok = true;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  memset(Store.data(), 0xFF, Store.size());
+  EEPROM.begin(MoreRecords::End);
+  auto      check = [&](const char* What, bool Pass) { printf("  %-60s %s\n", What, Pass ? "ok" : "FAILED"); ok &= Pass; };
+
+  // offsets
+  printf("WifiNet %s records from 0x%04X: Settings 0x%04X, Calibration 0x%04X, Counter 0x%04X, End 0x%04X, 2nd registry 0x%04X\n",
+         WifiNetVersion, WifiNetAppStart, AppRecords::offset<Settings>(), AppRecords::offset<Calibration>(),
+         AppRecords::offset<Counter>(), AppRecords::End, MoreRecords::offset<Counter>());
+  check("offsets: tag + slot per record, region end", AppRecords::offset<Counter>()==WifiNetAppStart+4+48+4+4 &&
+        AppRecords::End==AppRecords::offset<Counter>()+4+sizeof(Counter));
+  check("library records end below the application region", WifiNetAppStart >= EEPROMipAddress+16);
+
+  // unwritten
+  Settings  S = { 60, "home/sensor", 7 };
+  Counter   C = { 42 };
+  check("unwritten: read fails, defaults kept", !AppRecords::read(S) && S.Interval==60 && S.Retain==7 &&
+        !AppRecords::read(C) && C.Boots==42);
+
+  // whole copies
+  uint32_t  commits = Store.Commits;
+  C.Boots = 5;
+  Counter   D = { 9 };
+  check("write and read back", AppRecords::write(C) && AppRecords::read(D) && D.Boots==5 && Store.Commits==commits+1);
+  check("unchanged write: no commit", AppRecords::write(C) && Store.Commits==commits+1);
+  C.Boots = 6;
+  Counter   E = { 0 };
+  check("writes share one commit", AppRecords::write(C, false) && MoreRecords::write(E) && Store.Commits==commits+2);
+  Counter   F = { 1 };
+  check("2nd registry keeps its own copy", MoreRecords::read(F) && F.Boots==0 && AppRecords::read(D) && D.Boots==6);
+
+  // v1 -> v2
+  SettingsV1    S1 = { 15, "old/topic" };
+  CalibrationV1 K1 = { -25 };
+  OldRecords::write(S1, false);
+  OldRecords::write(K1);
+  Settings    S2 = { 60, "default", 3600 };
+  Calibration K2 = { 0 };
+  commits = Store.Commits;
+  check("default migration: old bytes kept, new field default", AppRecords::read(S2) && S2.Interval==15 &&
+        strcmp(S2.Topic,"old/topic")==0 && S2.Retain==3600 && Store.Commits==commits+1);
+  check("RecordMigrate: -2.5 C to -2500 milli", AppRecords::read(K2) && K2.OffsetMilli==-2500);
+  Settings    S3 = {};
+  Calibration K3 = { 1 };
+  commits = Store.Commits;
+  check("written back: reads as v2, no further migration", AppRecords::read(S3) && S3.Retain==3600 &&
+        AppRecords::read(K3) && K3.OffsetMilli==-2500 && Store.Commits==commits &&
+        Store.data()[AppRecords::offset<Settings>()+1]==Settings::RecordVersion);
+  check("record after the grown one not moved", AppRecords::read(D) && D.Boots==6);
+
+  // erase
+  check("erase: reads as not written", AppRecords::erase<Settings>() && !AppRecords::read(S3) && AppRecords::read(D));
+
+  printf("records: %s\n", ok ? "offsets, whole copies, migration and unwritten records as expected" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,217 @@
+/*
+ * SntpBench.cpp non blocking SNTP rounds against local UDP stand-in servers (PlatformIO env:sntpbench, <_SNTPCLIENT>)
+ * Created by Sachi Gerlitz
+ *
+ * three stand-in servers listen on 127.0.0.2...4 at <SntpPort> (12123 here, no privilege needed); each answers
+ * after its own path delay (virtual mS) with its own clock error, or drops, or sends a kiss of death or a bad reply.
+ * the loop pumps them and calls <service> while the virtual clock moves 1 mS a pass, then checks:
+ *    the sample of the lowest delay is taken (equal delays: the smaller offset), "RATE" holds a server off,
+ *    "DENY" drops it, all lost backs off doubling, spoofed / unsynchronized / stratum 16 replies are ignored,
+ *    <GetWWWTime> never waits, fills the <TimePack> and the <StartNTP> callback reports the round
+ * usage: program
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <arpa/inet.h>
+#include  <sys/socket.h>
+#include  <unistd.h>
+#include  <vector>
+
+static PosixClock Clk(true);
+static const int64_t  TrueBase = 1767225600000LL;         // [mS] 1-I-2026 00:00 UTC at virtual 0
+static int64_t  TrueMs()        { return TrueBase + Clk.millis(); }
+
+enum  Mode { Good, Drop, KodRate, KodDeny, Spoof, Unsync, Stratum16 };
+struct  Stand {                                           // one stand-in server
+  const char* Addr;
+  int       Fd;
+  uint32_t  DelayMs;                                      // round trip, half each way
+  int32_t   ErrMs;                                        // server clock against the true one
+  Mode      How;
+  std::vector<uint32_t> Got;                              // <millis> of the requests
+  uint8_t   Pkt[48];
+  bool      Pending;
+  uint32_t  DueAt;
+  sockaddr_in To;
+};
+static Stand  S[3] = { { "127.0.0.2", -1, 0, 0, Good, {}, {}, false, 0, {} },
+                       { "127.0.0.3", -1, 0, 0, Good, {}, {}, false, 0, {} },
+                       { "127.0.0.4", -1, 0, 0, Good, {}, {}, false, 0, {} } };
+
+// **************************************************************************************** //
+static void Put(uint8_t* P, int64_t Ms) {                 // epoch[mS] to NTP timestamp
+  uint32_t  sec = Ms/1000 + 2208988800LL;
+  uint32_t  frac = (uint32_t)((((uint64_t)(Ms%1000))<<32)/1000);
+  for ( uint8_t b=0; b<4; b++ ) { P[b] = sec >> (24-8*b); P[4+b] = frac >> (24-8*b); }
+}     // end of Put
+
+static void Pump() {
+  /*
+    * take the requests, send the replies that are due
+    */
+  uint32_t  now = Clk.millis();
+  for ( Stand& T : S ) {
+    uint8_t   in[64];
+    socklen_t n = sizeof(T.To);
+    if ( recvfrom(T.Fd, in, sizeof(in), MSG_DONTWAIT, (sockaddr*)&T.To, &n) == 48 ) {
+      T.Got.push_back(now);
+      if ( T.How == Drop ) continue;
+      memset(T.Pkt, 0, 48);
+      T.Pkt[0] = (T.How==Unsync ? 0xC0 : 0x00) | 0x24;  // version 4, server
+      T.Pkt[1] = T.How==Stratum16 ? 16 : 2;
+      memcpy(T.Pkt+24, in+40, 8);                         // originate = our transmit
+      if ( T.How == Spoof ) T.Pkt[31] ^= 0x5A;
+      if ( T.How==KodRate || T.How==KodDeny ) {
+        T.Pkt[1] = 0;
+        memcpy(T.Pkt+12, T.How==KodRate ? "RATE" : "DENY", 4);
+      }
+      int64_t   at = TrueMs() + T.DelayMs/2 + T.ErrMs;    // stamped when the request gets there
+      Put(T.Pkt+32, at);
+      Put(T.Pkt+40, at);
+      T.Pending = true;
+      T.DueAt = now + T.DelayMs;
+    }
+    if ( T.Pending && (int32_t)(now-T.DueAt) >= 0 ) {
+      sendto(T.Fd, T.Pkt, 48, 0, (sockaddr*)&T.To, sizeof(T.To));
+      T.Pending = false;
+    }
+  }
+}     // end of Pump
+
+static void Set(uint32_t D0, int32_t E0, Mode M0, uint32_t D1, int32_t E1, Mode M1, uint32_t D2, int32_t E2, Mode M2) {
+  S[0].DelayMs = D0; S[0].ErrMs = E0; S[0].How = M0;
+  S[1].DelayMs = D1; S[1].ErrMs = E1; S[1].How = M1;
+  S[2].DelayMs = D2; S[2].ErrMs = E2; S[2].How = M2;
+  for ( Stand& T : S ) { T.Got.clear(); T.Pending = false; }
+}     // end of Set
+
+static uint8_t Round(WifiNetSntp& Sntp, uint32_t MaxMs = 5000) {
+  /*
+    * pass loop() until a round ends
+    * returns  <Codes4Sntp> of the round, <SntpIdle> - none in <MaxMs>
+    */
+  for ( uint32_t t=0; t<MaxMs; t++ ) {
+    Pump();
+    uint8_t   r = Sntp.service(Clk.millis());
+    if ( r != SntpIdle ) return r;
+    Clk.advance(1);
+  }
+  return  SntpIdle;
+}     // end of Round
+
+static bool     DoneCalled = false, DoneSynced = false;
+static time_t   DoneEpoch = 0;
+static void Done(bool Synced, time_t Epoch, uint16_t) {
+  DoneCalled = true;
+  DoneSynced = Synced;
+  DoneEpoch = Epoch;
+}     // end of Done
+
+int main() {
+  bool        ok = true;
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  randomSeed(7);
+  Clk.advance(1000);
+  for ( Stand& T : S ) {
+    T.Fd = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in a = {};
+    a.sin_family = AF_INET;
+    a.sin_port = htons(SntpPort);
+    inet_pton(AF_INET, T.Addr, &a.sin_addr);
+    if ( T.Fd < 0 || bind(T.Fd, (sockaddr*)&a, sizeof(a)) < 0 ) { printf("sntp: FAILED, no stand-in on %s:%u\n", T.Addr, SntpPort); return 1; }
+  }
+  static const char* const Servers[] = { "127.0.0.2", "127.0.0.3", "127.0.0.4" };
+  auto    check = [&](const char* What, bool Pass) { printf("  %-52s %s\n", What, Pass ? "ok" : "FAILED"); ok &= Pass; };
+  auto    near = [](int64_t A, int64_t B, int64_t Ms) { return A-B <= Ms && B-A <= Ms; };
+
+  // lowest delay wins
+  WifiNetSntp Sntp;
+  Sntp.begin(Servers, 3);
+  Set(80, 40, Good, 10, 2, Good, 30, -15, Good);
+  uint8_t   r = Round(Sntp);
+  check("round synced, all three asked and answered", r==SntpSynced && Sntp.Requests==3 && Sntp.Replies==3);
+  check("lowest delay sample (10 mS, clock error +2 mS)", Sntp.Delay<=11 && near(Sntp.nowMs(Clk.millis()), TrueMs()+2, 2));
+  printf("  delay %u mS, clock %+lld mS against true\n", Sntp.Delay, (long long)(Sntp.nowMs(Clk.millis())-TrueMs()));
+
+  // equal delays: the smaller offset
+  Clk.advance(SntpPollS*1000UL);
+  Set(20, 60, Good, 20, 5, Good, 200, 0, Drop);
+  r = Round(Sntp);
+  check("equal delay: smaller offset taken (+5 mS)", r==SntpSynced && near(Sntp.nowMs(Clk.millis()), TrueMs()+5, 2));
+
+  // kiss of death
+  Clk.advance(SntpPollS*1000UL);
+  Set(10, 0, KodRate, 10, 0, KodDeny, 10, 0, Drop);
+  uint32_t  kod = Sntp.KissOfDeath;
+  r = Round(Sntp);
+  check("RATE and DENY counted, round failed", r==SntpFailed && Sntp.KissOfDeath==kod+2);
+  S[0].How = S[1].How = Good;
+  for ( Stand& T : S ) T.Got.clear();
+  r = Round(Sntp, SntpBackoffMs);                         // retries inside the hold-off of "RATE"
+  r = r==SntpFailed ? Round(Sntp, SntpBackoffMs) : r;
+  check("RATE held off, DENY dropped, the third asked", r==SntpFailed && S[0].Got.empty() && S[1].Got.empty() &&
+        S[2].Got.size()==2);
+  S[2].How = Good;
+  r = Round(Sntp, SntpBackoffMs);
+  check("RATE server back after its hold, DENY never", r==SntpSynced && !S[0].Got.empty() && S[1].Got.empty());
+
+  // all lost: doubling backoff
+  WifiNetSntp Lost;
+  Lost.begin(Servers, 3);
+  Set(10, 0, Drop, 10, 0, Drop, 10, 0, Drop);
+  bool      doubling = true;
+  for ( uint8_t n=0; n<6; n++ ) doubling &= Round(Lost, SntpBackoffMs+SntpTimeoutMs+10)==SntpFailed;
+  std::vector<uint32_t>& g = S[2].Got;
+  for ( size_t i=2; i<g.size(); i++ )                     // start gaps: timeout + retry, the retry doubles
+    doubling &= near(g[i]-g[i-1]-SntpTimeoutMs, 2*(int64_t)(g[i-1]-g[i-2]-SntpTimeoutMs), 2);
+  check("all lost: failed rounds, retry doubles", doubling && g.size()>=6 && Lost.Failed==6 && !Lost.synced());
+  printf("  retry gaps");
+  for ( size_t i=1; i<g.size(); i++ ) printf(" %u", g[i]-g[i-1]-SntpTimeoutMs);
+  printf(" mS\n");
+
+  // bad replies
+  WifiNetSntp Bad;
+  Bad.begin(Servers, 3);
+  Set(10, 0, Spoof, 10, 0, Unsync, 10, 0, Stratum16);
+  r = Round(Bad);
+  check("spoofed / LI 3 / stratum 16 ignored, round failed", r==SntpFailed && Bad.Ignored==3 && Bad.Replies==0 && !Bad.synced());
+
+  // WifiNet: <GetWWWTime> never waits
+  ManageWifi  M = {};
+  WifiNet     RunWifi(M);
+  TimePack    SysClock = {};
+  SysClock.NTPbeginOnce = true;
+  RunWifi.StartNTP(Done, Servers, 3);
+  Set(40, 0, Good, 25, 0, Good, 60, 0, Good);
+  bool      waited = false;
+  uint32_t  passes = 0;
+  for ( ; passes<2000 && !SysClock.IsTimeSet; passes++ ) {
+    Pump();
+    uint32_t  t0 = Clk.millis();
+    SysClock = RunWifi.GetWWWTime(SysClock, M);
+    waited |= Clk.millis() != t0;
+    Clk.advance(1);
+  }
+  time_t    now = TrueMs()/1000;
+  struct tm tm;
+  localtime_r(&now, &tm);                                 // TZ set by <GetWWWTime>
+  check("GetWWWTime never waits", !waited);
+  check("TimePack set to the local time", SysClock.IsTimeSet && SysClock.clockYear==tm.tm_year-100 &&
+        SysClock.clockDay==tm.tm_mday && SysClock.clockHour==tm.tm_hour && !SysClock.NTPbeginOnce);
+  check("callback: synced, epoch", DoneCalled && DoneSynced && near(DoneEpoch, now, 1));
+  check("binding clock set (settimeofday)", near(Clk.now(), now, 1));
+  printf("  %u loop passes to the time, %u rounds %u requests %u replies\n", passes, RunWifi.Sntp().Rounds,
+         RunWifi.Sntp().Requests, RunWifi.Sntp().Replies);
+
+  for ( Stand& T : S ) close(T.Fd);
+  printf("sntp: %s\n", ok ? "best sample, KoD, backoff and bad replies as expected, never blocks" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
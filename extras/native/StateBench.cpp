@@ -0,0 +1,102 @@
+/*
+ * StateBench.cpp micro-benchmark of the by value and in place <ManageWifi> APIs (PlatformIO env:statebench)
+ * Created by Sachi Gerlitz
+ *
+ * in connected steady state calls <WiFiTimeOut> and <IsWifiConnected> through both forms and prints
+ * time per call and the stack high-water mark (each form runs on its own painted thread stack)
+ * usage: program [Calls]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <chrono>
+#include  <pthread.h>
+
+#define   BenchStack    (256*1024)              // thread stack[bytes]
+#define   StackPaint    0xA5
+
+static WifiNet*   Wifi;
+static TimePack   SysClock;
+static ManageWifi SysWifi;
+static long       Calls;
+
+struct  BenchResult {
+  double    NsPerCall;
+  size_t    StackUsed;                          // [bytes]
+};
+
+// **************************************************************************************** //
+static void* ByValue(void* Out) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) {
+    SysWifi = Wifi->WiFiTimeOut(SysClock, SysWifi);
+    SysWifi = Wifi->IsWifiConnected(SysClock, SysWifi);
+  }
+  ((BenchResult*)Out)->NsPerCall = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-t0).count()/(2*Calls);
+  return  nullptr;
+}     // end of ByValue
+
+static void* InPlace(void* Out) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) {
+    Wifi->WiFiTimeOut(SysClock);
+    Wifi->IsWifiConnected(SysClock);
+  }
+  ((BenchResult*)Out)->NsPerCall = std::chrono::duration<double,std::nano>(std::chrono::steady_clock::now()-t0).count()/(2*Calls);
+  return  nullptr;
+}     // end of InPlace
+
+// **************************************************************************************** //
+static BenchResult  RunOnStack(void* (*Body)(void*)) {
+  /*
+    * run <Body> on a painted stack, the high-water mark is the part found overwritten (stack grows down)
+    */
+  BenchResult R = { 0, 0 };
+  uint8_t*    stack = (uint8_t*)aligned_alloc(4096, BenchStack);
+  memset(stack, StackPaint, BenchStack);
+  pthread_attr_t  attr;
+  pthread_attr_init(&attr);
+  pthread_attr_setstack(&attr, stack, BenchStack);
+  pthread_t   th;
+  pthread_create(&th, &attr, Body, &R);
+  pthread_join(th, nullptr);
+  size_t  untouched = 0;
+  while ( untouched < BenchStack && stack[untouched]==StackPaint ) untouched++;
+  R.StackUsed = BenchStack - untouched;
+  pthread_attr_destroy(&attr);
+  free(stack);
+  return  R;
+}     // end of RunOnStack
+
+int main(int argc, char** argv) {
+  Calls = argc>1 ? atol(argv[1]) : 200000;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  SimAP   AP = { Per_SSID, Per_Pass, {0x02,0x00,0x00,0x00,0x00,0x01}, 6, -55,
+                 IPAddress(192,168,1,50), IPAddress(192,168,1,1), IPAddress(255,255,255,0), IPAddress(192,168,1,1) };
+  Radio.addAP(AP);
+  EEPROM.begin(Store.size());
+  WifiNet     RunWifi(SysWifi);
+  Wifi = &RunWifi;
+  SysWifi = RunWifi.begin(SysWifi);
+  SysWifi = RunWifi.startWiFi(SysClock, SysWifi);
+  for ( int t=0; t<200 && SysWifi.activeTimeEvent!=2; t++ ) {  // connect once, then steady state
+    SysWifi = RunWifi.WiFiTimeOut(SysClock, SysWifi);
+    delay(ReconnectTick);
+  }
+  SysWifi.activeTimeEvent = 0;
+  RunWifi.State() = SysWifi;
+
+  BenchResult V = RunOnStack(ByValue);
+  BenchResult P = RunOnStack(InPlace);
+  printf("sizeof(ManageWifi) %u bytes, %ld calls per form\n", (unsigned)sizeof(ManageWifi), 2*Calls);
+  printf("%-10s %8.1f nS/call  stack high-water %6u bytes\n", "by value", V.NsPerCall, (unsigned)V.StackUsed);
+  printf("%-10s %8.1f nS/call  stack high-water %6u bytes\n", "in place", P.NsPerCall, (unsigned)P.StackUsed);
+  return  0;
+}     // end of main
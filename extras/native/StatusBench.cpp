@@ -0,0 +1,126 @@
+/*
+ * StatusBench.cpp JSON /status serializer throughput (PlatformIO env:statusbench)
+ * Created by Sachi Gerlitz
+ *
+ * registers <RegisterStatus> and checks the document (members, values, no trailing comma) in several chunk sizes,
+ * that draining the response allocates nothing, and the conditional path: 304 with the ETag while the connection
+ * is unchanged (RSSI and uptime moving), 200 with a new ETag once it changes
+ * then prints documents per second of the serializer alone (response filler), of a full 200 and of a 304
+ * usage: program [Calls]
+ */
+#include  "Arduino.h"
+#include  "Clock.h"
+#include  "Utilities.h"
+#include  "WifiNet.h"
+#include  "EEPROM.h"
+#include  "WifiNetHalPosix.h"
+#include  <chrono>
+#include  <cstdlib>
+#include  <new>
+#include  <string>
+
+// heap blocks, counted while <Counting>
+static bool     Counting = false;
+static size_t   Blocks = 0;
+void* operator new(size_t N) {
+  if ( Counting ) Blocks++;
+  void*   p = malloc(N ? N : 1);
+  if ( !p ) throw std::bad_alloc();
+  return  p;
+}
+// out of line, so gcc does not pair the free with the malloc of <new> and warn
+__attribute__((noinline)) void operator delete(void* P) noexcept         { free(P); }
+__attribute__((noinline)) void operator delete(void* P, size_t) noexcept { free(P); }
+
+struct  Reply {
+  int           Code;
+  std::string   Body;
+  std::string   ETag;
+};
+
+// **************************************************************************************** //
+static Reply Get(AsyncWebServer& Server, const std::string& ETag = "", size_t Chunk = 1460) {
+  AsyncWebServerRequest request(StatusPath);
+  Reply   R;
+  if ( !ETag.empty() ) request.addHeader("If-None-Match", ETag.c_str());
+  R.Code = Server.dispatch(request, &R.Body, Chunk);
+  if ( request.response() )
+    for ( auto& H : request.response()->Headers ) if ( H.first=="ETag" ) R.ETag = H.second.c_str();
+  return  R;
+}     // end of Get
+
+template<class F> static double PerSecond(long Calls, F Body) {
+  auto  t0 = std::chrono::steady_clock::now();
+  for ( long i=0; i<Calls; i++ ) Body();
+  return  Calls/std::chrono::duration<double>(std::chrono::steady_clock::now()-t0).count();
+}     // end of PerSecond
+
+int main(int argc, char** argv) {
+  long        Calls = argc>1 ? atol(argv[1]) : 200000;
+  bool        ok = true;
+  PosixClock  Clk(true);
+  PosixRadio  Radio(&Clk);
+  PosixStore  Store(nullptr);
+  PosixLog    Log(nullptr);
+  WifiNetHostInstall({ &Radio, &Store, &Clk, &Log, nullptr });
+  EEPROM.begin(Store.size());
+  ManageWifi  M = {};
+  WifiNet     RunWifi(M);
+  AsyncWebServer  Server(80);
+  RunWifi.RegisterStatus(&Server);
+
+  // before any connection
+  Reply   none = Get(Server);
+  ok &= none.Code==200 && none.Body.find("\"ip\":null,")!=std::string::npos &&
+        none.Body.find("\"connect_ms\":null,")!=std::string::npos && none.Body.find("\"rssi_dbm\":null,")!=std::string::npos &&
+        none.Body.find("\"ntp_synced\":false,")!=std::string::npos;
+
+  // connected
+  ManageWifi& S = RunWifi.State();
+  static const uint8_t Bssid[6] = { 0x24, 0x4b, 0xfe, 0x01, 0xa2, 0xc3 };
+  RunWifi.StartAttempt();
+  Clk.advance(812);
+  RunWifi.MarkPhase(PhGotIP);
+  S.WiFiStatus = 2;
+  S.CredStat = 3;
+  S.WiFichannel = 6;
+  S.DeviceIP = 0x1101A8C0;                                // 192.168.1.17, network order
+  ok &= strcmp(S.DeviceIP, "192.168.1.17")==0 && strlen(S.DeviceIP)==12;   // reads as the former char DeviceIP[18]
+  memcpy(S.WiFiBSsid, Bssid, sizeof(Bssid));
+  Reply   doc = Get(Server);
+  printf("%s", doc.Body.c_str());
+  ok &= doc.Code==200 && doc.ETag.compare(0, 3, "W/\"")==0 && doc.Body.front()=='{' && doc.Body.compare(doc.Body.size()-2, 2, "}\n")==0;
+  for ( const char* m : { "\"wifi_status\":2,", "\"cred_stat\":3,", "\"ip\":\"192.168.1.17\",", "\"bssid\":\"24:4b:fe:01:a2:c3\",",
+                          "\"channel\":6,", "\"rssi_dbm\":", "\"uptime_s\":", "\"connect_ms\":812,", "\"ntp_age_s\":null\n" } )
+    ok &= doc.Body.find(m)!=std::string::npos;
+  ok &= doc.Body.find(",\n}")==std::string::npos;
+  for ( size_t chunk : { 1, 7, 64, 4096 } ) ok &= Get(Server, "", chunk).Body==doc.Body;
+
+  // draining the response allocates nothing
+  AsyncWebServerRequest request(StatusPath);
+  Server.dispatch(request);
+  AwsResponseFiller Fill = request.response()->Filler;
+  uint8_t buf[1460];
+  size_t  len = 0, n;
+  Blocks = 0;
+  Counting = true;
+  while ( (n = Fill(buf, 64, len)) > 0 ) len += n;
+  Counting = false;
+  ok &= len==doc.Body.size() && Blocks==0;
+
+  // conditional requests
+  Clk.advance(5000);                                      // uptime moves
+  Reply   same = Get(Server, doc.ETag), strong = Get(Server, doc.ETag.substr(2));
+  ok &= same.Code==304 && same.Body.empty() && same.ETag==doc.ETag && strong.Code==304;
+  S.WiFichannel = 11;                                     // roamed
+  Reply   moved = Get(Server, doc.ETag);
+  ok &= moved.Code==200 && moved.ETag!=doc.ETag && moved.Body.find("\"channel\":11,")!=std::string::npos;
+  ok &= RunWifi.Pool().InUse==1;                          // only the request of <Fill>, still open
+
+  printf("document %zu bytes, ETag %s\n", doc.Body.size(), doc.ETag.c_str());
+  printf("serializer %.0f docs/S   200 %.0f /S   304 %.0f /S   (host)\n",
+         PerSecond(Calls, [&]{ for ( size_t i=0; (n = Fill(buf, sizeof(buf), i)) > 0; ) i += n; }),
+         PerSecond(Calls/4, [&]{ Get(Server); }), PerSecond(Calls/4, [&]{ Get(Server, moved.ETag); }));
+  printf("status: %s\n", ok ? "document, no allocation and 304 as expected" : "FAILED");
+  return  ok ? 0 : 1;
+}     // end of main
@@ -0,0 +1,69 @@
+#pragma once
+/*
+ * WiFiUdp.h host compatibility header for WifiNet native build
+ * Created by Sachi Gerlitz
+ *
+ * <WiFiUDP> over a non blocking POSIX datagram socket, so the captive portal DNS responder (<WifiNetDns>)
+ * answers a real client on the host: <parsePacket> takes one datagram into a fixed buffer, <read> copies it out,
+ * <beginPacket> / <write> / <endPacket> send one back. no allocation
+ */
+#ifndef WifiNetNativeWiFiUdp_h
+  #define WifiNetNativeWiFiUdp_h
+
+  #include  "Arduino.h"
+  #include  <arpa/inet.h>
+  #include  <netinet/in.h>
+  #include  <sys/socket.h>
+  #include  <unistd.h>
+
+  class WiFiUDP {
+    public:
+      ~WiFiUDP()                                { stop(); }
+      uint8_t   begin(uint16_t Port) {
+        stop();
+        _Fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in a = {};
+        a.sin_family = AF_INET;
+        a.sin_port = htons(Port);
+        a.sin_addr.s_addr = htonl(INADDR_ANY);
+        if ( _Fd < 0 || bind(_Fd, (sockaddr*)&a, sizeof(a)) < 0 ) { stop(); return 0; }
+        return  1; }
+      void      stop()                          { if ( _Fd >= 0 ) close(_Fd); _Fd = -1; _InLen = _InPos = _OutLen = 0; }
+      int       parsePacket() {
+        if ( _Fd < 0 ) return 0;
+        socklen_t n = sizeof(_From);
+        ssize_t   r = recvfrom(_Fd, _In, sizeof(_In), MSG_DONTWAIT, (sockaddr*)&_From, &n);
+        _InLen = r > 0 ? r : 0;
+        _InPos = 0;
+        return  _InLen; }
+      int       available()                     { return _InLen - _InPos; }
+      int       read(uint8_t* Buf, size_t Len) {
+        size_t  n = Len < (size_t)available() ? Len : available();
+        memcpy(Buf, _In+_InPos, n);
+        _InPos += n;
+        return  n; }
+      IPAddress remoteIP()                      { return IPAddress((uint32_t)_From.sin_addr.s_addr); }   // network order
+      uint16_t  remotePort()                    { return ntohs(_From.sin_port); }
+      int       beginPacket(IPAddress IP, uint16_t Port) {
+        if ( _Fd < 0 ) return 0;
+        _To = {};
+        _To.sin_family = AF_INET;
+        _To.sin_port = htons(Port);
+        _To.sin_addr.s_addr = (uint32_t)IP;
+        _OutLen = 0;
+        return  1; }
+      size_t    write(const uint8_t* Buf, size_t Len) {
+        size_t  n = Len < sizeof(_Out)-_OutLen ? Len : sizeof(_Out)-_OutLen;
+        memcpy(_Out+_OutLen, Buf, n);
+        _OutLen += n;
+        return  n; }
+      int       endPacket() {
+        return  _Fd >= 0 && sendto(_Fd, _Out, _OutLen, 0, (sockaddr*)&_To, sizeof(_To)) == (ssize_t)_OutLen; }
+    private:
+      int       _Fd = -1;
+      sockaddr_in _From = {}, _To = {};
+      uint8_t   _In[1472], _Out[1472];      // one datagram each way
+      size_t    _InLen = 0, _InPos = 0, _OutLen = 0;
+  };
+
+#endif  //WifiNetNativeWiFiUdp_h
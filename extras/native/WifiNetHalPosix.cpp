@@ -0,0 +1,315 @@
+/*
+ * WifiNetHalPosix.cpp Linux/POSIX bindings of <WifiNetHal> and the host side of the Arduino compatibility headers
+ * Created by Sachi Gerlitz
+ *
+ */
+#include  "WifiNetHalPosix.h"
+#include  "ESP8266WiFi.h"
+#include  "EEPROM.h"
+#include  "WifiNetPmk.h"
+#include  <stdarg.h>
+
+// **************************************************************************************** //
+PosixClock::PosixClock(bool Virtual) : _Virtual(Virtual), _VirtualMs(0), _EpochOffset(0) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  _StartMs = (uint64_t)ts.tv_sec*1000 + ts.tv_nsec/1000000;
+}   // end of PosixClock
+
+uint32_t  PosixClock::millis() {
+  if ( _Virtual ) return  (uint32_t)_VirtualMs;
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return  (uint32_t)((uint64_t)ts.tv_sec*1000 + ts.tv_nsec/1000000 - _StartMs);
+}   // end of millis
+
+void  PosixClock::delay(uint32_t Ms) {
+  if ( _Virtual ) { _VirtualMs += Ms; return; }
+  struct timespec ts = { (time_t)(Ms/1000), (long)(Ms%1000)*1000000L };
+  nanosleep(&ts, nullptr);
+}   // end of delay
+
+time_t  PosixClock::now() {
+  return  _EpochOffset ? (time_t)(millis()/1000 + _EpochOffset) : (time_t)(millis()/1000);
+}   // end of now
+
+void  PosixClock::setNow(time_t Epoch) {
+  _EpochOffset = (int64_t)Epoch - millis()/1000;
+}   // end of setNow
+
+// **************************************************************************************** //
+PosixRadio::PosixRadio(WifiNetClock* Clock) : _Clock(Clock) {}
+
+bool  PosixRadio::begin(const char* Ssid, const char* Pass, uint8_t Channel, const uint8_t* Bssid) {
+  /*
+    * join the AP named <Ssid> (on <Bssid> when pinned); failure shows in <status> after the association time
+    * <Pass> of 64 chars is the hex PSK as on the SDK, a passphrase costs the key derivation time first
+    */
+  bool  psk = strlen(Pass)==2*PmkLength;
+  Begins++;
+  _AP = nullptr;
+  _Fail = WL_NO_SSID_AVAIL;
+  _BeginAt = _Clock->millis() + ( Channel ? 0 : _ScanMs ) + ( psk ? 0 : _DeriveMs );  // unpinned join scans all channels first
+  for ( auto& A : _APs ) {
+    if ( A.Ssid!=Ssid ) continue;
+    if ( Channel && Bssid && ( A.Channel!=Channel || memcmp(A.Bssid,Bssid,6)!=0 ) ) continue;
+    _AP = &A;
+    if ( psk ) {
+      uint8_t pmk[PmkLength];
+      char    hex[2*PmkLength+1];
+      WifiNetPmk::derive(A.Pass.c_str(), A.Ssid.c_str(), pmk);
+      WifiNetPmk::toHex(pmk, hex);
+      _Fail = ( strcmp(hex,Pass)==0 ) ? 0 : WL_WRONG_PASSWORD;
+    } else {
+      _Fail = ( A.Pass==Pass ) ? 0 : WL_WRONG_PASSWORD;
+    }
+    break;
+  }
+  return  true;
+}   // end of begin
+
+void  PosixRadio::disconnect() {
+  _AP = nullptr;
+  _Fail = 0;
+}   // end of disconnect
+
+void  PosixRadio::dropLink() {
+  _AP = nullptr;
+  _Fail = WL_CONNECTION_LOST;
+}   // end of dropLink
+
+bool  PosixRadio::config(uint32_t IP, uint32_t Gateway, uint32_t Mask, uint32_t Dns) {
+  _StaticIP = IP; _StaticGateway = Gateway; _StaticMask = Mask; _StaticDns = Dns;
+  return  true;
+}   // end of config
+
+bool  PosixRadio::up() {
+  if ( !_AP || _Fail ) return  false;
+  return  (int32_t)(_Clock->millis() - _BeginAt) >= (int32_t)(_AssocMs + ( _StaticIP ? 0 : _DhcpMs ));
+}   // end of up
+
+uint8_t PosixRadio::status() {
+  if ( up() ) return  WL_CONNECTED;
+  if ( _Fail && (int32_t)(_Clock->millis() - _BeginAt) >= (int32_t)_AssocMs ) return  _Fail;
+  return  ( _AP || _Fail ) ? WL_DISCONNECTED : WL_IDLE_STATUS;
+}   // end of status
+
+uint32_t  PosixRadio::localIP()     { return up() ? ( _StaticIP ? _StaticIP : _AP->IP ) : 0; }
+uint32_t  PosixRadio::gatewayIP()   { return up() ? ( _StaticIP ? _StaticGateway : _AP->Gateway ) : 0; }
+uint32_t  PosixRadio::subnetMask()  { return up() ? ( _StaticIP ? _StaticMask : _AP->Mask ) : 0; }
+uint32_t  PosixRadio::dnsIP()       { return up() ? ( _StaticIP ? _StaticDns : _AP->Dns ) : 0; }
+int32_t   PosixRadio::RSSI()        { return up() ? _AP->Rssi : 31; }
+uint8_t   PosixRadio::channel()     { return _AP ? _AP->Channel : 0; }
+const uint8_t* PosixRadio::BSSID()  { static const uint8_t none[6] = {0}; return _AP ? _AP->Bssid : none; }
+
+bool  PosixRadio::scanResult(uint8_t Index, const char** Ssid, int32_t* Rssi, uint8_t* Channel, const uint8_t** Bssid) {
+  if ( Index >= _APs.size() ) return  false;
+  const SimAP& A = _APs[Index];
+  *Ssid = A.Ssid.c_str(); *Rssi = A.Rssi; *Channel = A.Channel; *Bssid = A.Bssid;
+  return  true;
+}   // end of scanResult
+
+// **************************************************************************************** //
+PosixStore::PosixStore(const char* Path, size_t Size) : _Path(Path ? Path : ""), _Image(Size, 0xFF) {
+  if ( _Path.empty() ) return;
+  FILE* f = fopen(_Path.c_str(), "rb");
+  if ( !f ) return;                                 // erased flash on first run
+  size_t n = fread(_Image.data(), 1, _Image.size(), f);
+  (void)n;
+  fclose(f);
+}   // end of PosixStore
+
+bool  PosixStore::commit() {
+  Commits++;
+  if ( _Path.empty() ) return  true;
+  FILE* f = fopen(_Path.c_str(), "wb");
+  if ( !f ) return  false;
+  bool  ok = fwrite(_Image.data(), 1, _Image.size(), f) == _Image.size();
+  return  fclose(f)==0 && ok;
+}   // end of commit
+
+// **************************************************************************************** //
+PosixFlash::PosixFlash(uint32_t Sectors) : SectorErases(Sectors, 0), _Image(Sectors*4096, 0xFF) {}
+
+size_t  PosixFlash::budget(size_t Len) {
+  /*
+    * bytes of an operation of <Len> bytes done before power is lost
+    */
+  if ( _Lost ) return  0;
+  if ( _Tear < 0 || (int64_t)Len < _Tear ) {
+    if ( _Tear >= 0 ) _Tear -= Len;
+    return  Len;
+  }
+  size_t  done = _Tear;
+  _Tear = -1;
+  _Lost = true;
+  return  done;
+}   // end of budget
+
+bool  PosixFlash::eraseSector(uint32_t Sector) {
+  if ( Sector >= SectorErases.size() || _Lost ) return  false;
+  Erases++;
+  SectorErases[Sector]++;
+  size_t  done = budget(4096);
+  memset(_Image.data()+Sector*4096, 0xFF, done);
+  return  done==4096;
+}   // end of eraseSector
+
+bool  PosixFlash::write(uint32_t Address, const uint32_t* Data, size_t Len) {
+  /*
+    * NOR program: bits go from 1 to 0 only
+    */
+  if ( (Address & 3) || (Len & 3) || Address+Len > _Image.size() ) return  false;
+  size_t  done = budget(Len);
+  const uint8_t* d = (const uint8_t*)Data;
+  for ( size_t i=0; i<done; i++ ) _Image[Address+i] &= d[i];
+  return  done==Len;
+}   // end of write
+
+bool  PosixFlash::read(uint32_t Address, uint32_t* Data, size_t Len) {
+  if ( (Address & 3) || Address+Len > _Image.size() ) return  false;
+  memcpy(Data, _Image.data()+Address, Len);
+  return  true;
+}   // end of read
+
+// **************************************************************************************** //
+static PosixClock   DefClock;
+static PosixRadio   DefRadio(&DefClock);
+static PosixStore   DefStore;
+static PosixLog     DefLog;
+static PosixFlash   DefFlash;
+static WifiNetHal   Host = { &DefRadio, &DefStore, &DefClock, &DefLog, &DefFlash };
+
+void  WifiNetHostInstall(const WifiNetHal& Hal)   { Host = Hal; }
+WifiNetHal& WifiNetHost()                         { return Host; }
+
+HardwareSerial    Serial;
+ESP8266WiFiClass  WiFi;
+EspClass          ESP;
+EEPROMClass       EEPROM;
+
+unsigned long millis()          { WiFi.poll(); return Host.Clock->millis(); }
+unsigned long micros()          { return Host.Clock->millis()*1000UL; }
+void  delay(unsigned long Ms)   { Host.Clock->delay(Ms); WiFi.poll(); }
+void  yield()                   { WiFi.poll(); }
+long  random(long Max)          { return Max>0 ? rand()%Max : 0; }
+long  random(long Min, long Max){ return Max>Min ? Min+rand()%(Max-Min) : Min; }
+void  randomSeed(unsigned long Seed)  { srand(Seed); }
+
+bool  EspClass::flashEraseSector(uint32_t Sector)  { return ( Host.Flash ? Host.Flash : &DefFlash )->eraseSector(Sector); }
+bool  EspClass::flashWrite(uint32_t Address, const uint32_t* Data, size_t Len) {
+  return  ( Host.Flash ? Host.Flash : &DefFlash )->write(Address, Data, Len); }
+bool  EspClass::flashRead(uint32_t Address, uint32_t* Data, size_t Len) {
+  return  ( Host.Flash ? Host.Flash : &DefFlash )->read(Address, Data, Len); }
+
+size_t  HardwareSerial::write(const uint8_t* Buf, size_t Len) { return Host.Log->write(Buf, Len); }
+
+size_t  Print::printf(const char* Format, ...) {
+  char    buf[256];
+  va_list ap;
+  va_start(ap, Format);
+  int n = vsnprintf(buf, sizeof(buf), Format, ap);
+  va_end(ap);
+  return  n>0 ? print(buf) : 0;
+}   // end of printf
+
+// **************************************************************************************** //
+enum  { EvKindConnected=0, EvKindDisconnected, EvKindAuth, EvKindGotIP };
+
+WiFiEventHandler  ESP8266WiFiClass::add(uint8_t Kind, std::function<void()> Fire) {
+  WiFiEventHandler H = std::make_shared<WiFiEventHandlerOpaque>();
+  H->Fire = Fire;
+  H->Kind = Kind;
+  _Handlers.push_back(H);
+  return  H;
+}   // end of add
+
+WiFiEventHandler  ESP8266WiFiClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> Handler) {
+  return  add(EvKindConnected, [Handler]() {
+    WiFiEventStationModeConnected E;
+    E.ssid = ""; memcpy(E.bssid, WifiNetHost().Radio->BSSID(), 6); E.channel = WifiNetHost().Radio->channel();
+    Handler(E); });
+}
+WiFiEventHandler  ESP8266WiFiClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> Handler) {
+  return  add(EvKindDisconnected, [Handler]() {
+    WiFiEventStationModeDisconnected E;
+    memset(E.bssid, 0, 6); E.reason = 8;                  // ASSOC_LEAVE
+    Handler(E); });
+}
+WiFiEventHandler  ESP8266WiFiClass::onStationModeAuthModeChanged(std::function<void(const WiFiEventStationModeAuthModeChanged&)> Handler) {
+  return  add(EvKindAuth, [Handler]() { WiFiEventStationModeAuthModeChanged E = { 0, 0 }; Handler(E); });
+}
+WiFiEventHandler  ESP8266WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> Handler) {
+  return  add(EvKindGotIP, [Handler]() {
+    WiFiEventStationModeGotIP E;
+    E.ip = IPAddress(WifiNetHost().Radio->localIP()); E.mask = IPAddress(WifiNetHost().Radio->subnetMask());
+    E.gw = IPAddress(WifiNetHost().Radio->gatewayIP());
+    Handler(E); });
+}
+
+wl_status_t ESP8266WiFiClass::status() {
+  poll();
+  return  (wl_status_t)WifiNetHost().Radio->status();
+}   // end of status
+
+void  ESP8266WiFiClass::poll() {
+  /*
+    * the SDK raises station events from its own task; on a host they are raised here on radio status change
+    */
+  static bool busy=false;
+  if ( busy ) return;
+  busy = true;
+  uint8_t s = WifiNetHost().Radio->status();
+  if ( s != _LastStatus ) {
+    bool  wasUp = _LastStatus==WL_CONNECTED;
+    _LastStatus = s;
+    for ( size_t i=0; i<_Handlers.size(); i++ ) {
+      WiFiEventHandler H = _Handlers[i].lock();
+      if ( !H ) continue;
+      if ( s==WL_CONNECTED && ( H->Kind==EvKindConnected ) ) H->Fire();
+      if ( wasUp && H->Kind==EvKindDisconnected ) H->Fire();
+    }
+    for ( size_t i=0; i<_Handlers.size() && s==WL_CONNECTED; i++ ) {   // got IP after connected
+      WiFiEventHandler H = _Handlers[i].lock();
+      if ( H && H->Kind==EvKindGotIP ) H->Fire();
+    }
+  }
+  busy = false;
+}   // end of poll
+
+// **************************************************************************************** //
+static bool     SntpOn=false;
+static uint8_t  SntpLoss=0;                         // lost replies [%]
+static uint32_t SntpRtt=40;                         // reply time[mS]
+
+void  WifiNetHostSntp(uint8_t LossPercent, uint32_t RttMs) {
+  SntpOn = false;
+  SntpLoss = LossPercent;
+  SntpRtt = RttMs;
+}   // end of WifiNetHostSntp
+
+void  configTime(int, int, const char*, const char*, const char*) { SntpOn = true; }
+
+bool  getLocalTime(struct tm* Info, uint32_t TimeOutMs) {
+  /*
+    * host SNTP: until the clock is set every query after <configTime> costs one request round-trip
+    * a lost reply costs <TimeOutMs>; a reply sets the binding clock from the host wall clock
+    */
+  if ( SntpOn && Host.Clock->now() < 1577836800 ) {
+    if ( (uint32_t)(rand()%100) < SntpLoss ) {
+      delay(TimeOutMs);
+      return  false;
+    }
+    delay(SntpRtt);
+    Host.Clock->setNow(time(nullptr));
+  }
+  time_t  now = Host.Clock->now();
+  if ( now < 1577836800 ) return  false;
+  localtime_r(&now, Info);
+  return  true;
+}   // end of getLocalTime
+
+int   WifiNetHostSetTime(const struct timeval* Tv, const void*) {
+  Host.Clock->setNow(Tv->tv_sec);
+  return  0;
+}   // end of WifiNetHostSetTime
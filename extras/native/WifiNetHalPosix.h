@@ -0,0 +1,125 @@
+#pragma once
+/*
+ * WifiNetHalPosix.h Linux/POSIX bindings of <WifiNetHal> for WifiNet native build
+ * Created by Sachi Gerlitz
+ *
+ * PosixRadio   - simulated access points with association and DHCP latency
+ * PosixStore   - EEPROM image kept in a file
+ * PosixFlash   - NOR flash sectors in RAM with erase counters and power loss (torn write / erase) injection
+ * PosixClock   - virtual (delay advances time at once, for desktop speed runs) or real monotonic clock
+ * PosixLog     - stdout / stderr
+ * SNTP         - <configTime>/<getLocalTime> stand-in with reply loss and round-trip time (<WifiNetHostSntp>),
+ *                <settimeofday> sets the binding clock
+ * install a set by <WifiNetHostInstall> before <WifiNet::begin>; a default set (file "wifinet_eeprom.bin") is used otherwise
+ */
+#ifndef WifiNetHalPosix_h
+  #define WifiNetHalPosix_h
+
+  #include  "Arduino.h"
+  #include  <vector>
+  #include  <string>
+
+  class PosixClock : public WifiNetClock {
+    public:
+      PosixClock(bool Virtual=true);
+      uint32_t  millis();
+      void      delay(uint32_t Ms);
+      time_t    now();
+      void      setNow(time_t Epoch);
+      void      advance(uint32_t Ms)            { _VirtualMs += Ms; }
+    private:
+      bool      _Virtual;
+      uint64_t  _VirtualMs;
+      uint64_t  _StartMs;
+      int64_t   _EpochOffset;                   // wall clock = <millis>/1000 + offset, 0 - not set
+  };
+
+  struct  SimAP {                               // one simulated access point
+    std::string Ssid;
+    std::string Pass;
+    uint8_t     Bssid[6];
+    uint8_t     Channel;
+    int32_t     Rssi;
+    uint32_t    IP, Gateway, Mask, Dns;         // lease handed out by DHCP
+  };
+  class PosixRadio : public WifiNetRadio {
+    public:
+      PosixRadio(WifiNetClock* Clock);
+      void      addAP(const SimAP& AP)          { _APs.push_back(AP); }
+      void      clearAPs()                      { _APs.clear(); }
+      void      setLatency(uint32_t AssocMs, uint32_t DhcpMs, uint32_t ScanMs=1500) { _AssocMs=AssocMs; _DhcpMs=DhcpMs; _ScanMs=ScanMs; }
+      void      setKeyDerivation(uint32_t Ms)   { _DeriveMs = Ms; }   // PBKDF2 time of a passphrase join
+      void      dropLink();                     // link lost (AP gone)
+      bool      begin(const char* Ssid, const char* Pass, uint8_t Channel, const uint8_t* Bssid);
+      void      disconnect();
+      bool      config(uint32_t IP, uint32_t Gateway, uint32_t Mask, uint32_t Dns);
+      uint8_t   status();
+      uint32_t  localIP();
+      uint32_t  gatewayIP();
+      uint32_t  subnetMask();
+      uint32_t  dnsIP();
+      int32_t   RSSI();
+      uint8_t   channel();
+      const uint8_t* BSSID();
+      int8_t    scanNetworks()                  { return _APs.size(); }
+      bool      scanResult(uint8_t Index, const char** Ssid, int32_t* Rssi, uint8_t* Channel, const uint8_t** Bssid);
+      bool      softAP(const char*)             { _SoftAP=true; return true; }
+      uint32_t  softAPIP()                      { return _SoftAP ? 0x0104A8C0 : 0; }    // 192.168.4.1
+      uint32_t  Begins = 0;                     // <begin> calls
+    private:
+      WifiNetClock* _Clock;
+      std::vector<SimAP> _APs;
+      const SimAP* _AP = nullptr;               // AP being joined / joined
+      uint8_t   _Fail = 0;                      // <wl_status_t> failure of current attempt, 0 none
+      uint32_t  _BeginAt = 0;
+      uint32_t  _AssocMs = 300;
+      uint32_t  _DhcpMs = 700;
+      uint32_t  _ScanMs = 1500;                 // added to unpinned (channel 0) joins
+      uint32_t  _DeriveMs = 0;                  // added to passphrase (not PSK) joins
+      uint32_t  _StaticIP = 0, _StaticGateway = 0, _StaticMask = 0, _StaticDns = 0;
+      bool      _SoftAP = false;
+      bool      up();
+  };
+
+  class PosixStore : public WifiNetStore {
+    public:
+      PosixStore(const char* Path="wifinet_eeprom.bin", size_t Size=4096); // nullptr path - RAM only
+      size_t    size()                          { return _Image.size(); }
+      uint8_t*  data()                          { return _Image.data(); }
+      bool      commit();
+      uint32_t  Commits = 0;
+    private:
+      std::string _Path;
+      std::vector<uint8_t> _Image;
+  };
+
+  class PosixFlash : public WifiNetFlash {
+    public:
+      PosixFlash(uint32_t Sectors=16);
+      bool      eraseSector(uint32_t Sector);
+      bool      write(uint32_t Address, const uint32_t* Data, size_t Len);
+      bool      read(uint32_t Address, uint32_t* Data, size_t Len);
+      void      tearAfter(uint32_t Bytes)       { _Tear = Bytes; }    // power lost after <Bytes> more bytes programmed or erased
+      void      powerUp()                       { _Tear = -1; _Lost = false; }
+      bool      lost()                          { return _Lost; }
+      uint32_t  Erases = 0;
+      std::vector<uint32_t> SectorErases;       // erase cycles of each sector
+    private:
+      std::vector<uint8_t> _Image;
+      int64_t   _Tear = -1;                     // -1 - no power loss armed
+      bool      _Lost = false;                  // power is off, every write / erase fails until <powerUp>
+      size_t    budget(size_t Len);
+  };
+
+  class PosixLog : public WifiNetLog {
+    public:
+      PosixLog(FILE* Out=stdout) : _Out(Out) {}
+      size_t    write(const uint8_t* Buf, size_t Len)   { return _Out ? fwrite(Buf, 1, Len, _Out) : Len; }
+    private:
+      FILE*     _Out;                           // nullptr - discard
+  };
+
+  void  WifiNetHostInstall(const WifiNetHal& Hal);
+  void  WifiNetHostSntp(uint8_t LossPercent, uint32_t RttMs);     // SNTP stand-in, also clears <configTime>
+
+#endif  //WifiNetHalPosix_h
@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""
+gzassets.py build the gzip compressed static assets of WifiNet library (src/WifiNetAssets.h, <_GZASSETS>)
+Created by Sachi Gerlitz
+
+reads extras/assets, fills the credential form with the action and field names of src/WifiNetConfig.h,
+compresses every asset (gzip level 9, no time stamp, so the output only changes with the content) and writes
+the PROGMEM blobs with their ETag (content hash) to src/WifiNetAssets.h
+an asset gzip does not make smaller is kept as is and served without <Content-Encoding>
+
+usage:  python3 extras/tools/gzassets.py            regenerate src/WifiNetAssets.h
+        python3 extras/tools/gzassets.py --check    exit 1 when src/WifiNetAssets.h is not up to date
+"""
+import gzip
+import hashlib
+import os
+import re
+import sys
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..'))
+ASSETS = os.path.join(ROOT, 'extras', 'assets')
+CONFIG = os.path.join(ROOT, 'src', 'WifiNetConfig.h')
+OUTPUT = os.path.join(ROOT, 'src', 'WifiNetAssets.h')
+
+CSS_PATH = '/wifinet.css'
+FORM_PATH = '/wifinet/cred'
+PRIO_FIELD = "<BR><BR>Priority (0-255):<input type='text' name='@PRIO@'>"
+
+# name, source, URL path, content type, variants: (#if condition of the variant or None for #else, priority field)
+MANIFEST = [
+    ('AssetCss',  'wifinet.css', CSS_PATH,  'text/css',  [(None, False)]),
+    ('AssetForm', 'cred.html',   FORM_PATH, 'text/html', [('CredSlots>1', True), (None, False)]),
+]
+
+
+def config_phrases():
+    """form action and field names as set in WifiNetConfig.h"""
+    text = open(CONFIG).read()
+    def phrase(name):
+        m = re.search(r'static const char ' + name + r'\[\]\s*=\s*"([^"]*)"', text)
+        if not m:
+            sys.exit('gzassets: %s not found in %s' % (name, CONFIG))
+        return m.group(1)
+    return {'ACTION': phrase('CredSettingTrigger').lstrip('/'), 'SSID': phrase('SSID_Phrase'),
+            'PASS': phrase('PSWD_Phrase'), 'PRIO': phrase('PRIO_Phrase'), 'CSS': CSS_PATH}
+
+
+def fill(text, phrases, prio):
+    text = text.replace('@PRIO@', PRIO_FIELD if prio else '')
+    for key, value in phrases.items():
+        text = text.replace('@' + key + '@', value)
+    return text
+
+
+def blob(name, data):
+    rows = []
+    for i in range(0, len(data), 16):
+        rows.append('    ' + ','.join('0x%02x' % b for b in data[i:i+16]) + ',')
+    return '  static const uint8_t %sData[] PROGMEM = {\n%s\n  };\n' % (name, '\n'.join(rows))
+
+
+def indent(text):
+    return ''.join('  ' + line for line in text.splitlines(True))
+
+
+def variants(phrases):
+    """every asset variant: name, path, path macro, content type, condition, variants of the asset, raw and served
+    bytes, gzip"""
+    for name, source, path, ctype, options in MANIFEST:
+        text = open(os.path.join(ASSETS, source), encoding='utf-8').read()
+        macro = 'AssetCssPath' if path == CSS_PATH else 'AssetFormPath'
+        for cond, prio in options:
+            raw = fill(text, phrases, prio).encode()
+            gz = gzip.compress(raw, compresslevel=9, mtime=0)
+            zipped = len(gz) < len(raw)
+            yield name, path, macro, ctype, cond, len(options), raw, gz if zipped else raw, zipped
+
+
+def generate():
+    phrases = config_phrases()
+    out = ['/*\n',
+           ' * WifiNetAssets.h gzip compressed static assets of WifiNet library <_GZASSETS>\n',
+           ' * generated by extras/tools/gzassets.py from extras/assets - do not edit, run the tool again\n',
+           ' * (no #pragma once: WifiNet.cpp includes it again for the blobs)\n',
+           ' *\n']
+    for name, path, macro, ctype, cond, count, raw, data, zipped in variants(phrases):
+        out.append(' * %-10s %-14s %-12s %5d bytes, %5d served%s\n' % (name, path, cond or '', len(raw), len(data),
+                   ' gzip' if zipped else ' (gzip is not smaller)'))
+    out += [' */\n',
+            '#ifndef WifiNetAssets_h\n',
+            '  #define WifiNetAssets_h\n\n',
+            '  #define AssetCssPath      "%s"\n' % CSS_PATH,
+            '  #define AssetFormPath     "%s"\n' % FORM_PATH,
+            '  #define AssetFormAction   "%s"          // form action and field names in <AssetForm>\n' % phrases['ACTION'],
+            '  #define AssetFormSsid     "%s"\n' % phrases['SSID'],
+            '  #define AssetFormPass     "%s"\n' % phrases['PASS'],
+            '  #define AssetFormPrio     "%s"\n' % phrases['PRIO'],
+            '#endif  //WifiNetAssets_h\n\n',
+            '// the blobs, in the one translation unit that defines <WifiNetAssetData>\n',
+            '#if defined(WifiNetAssetData) && !defined(WifiNetAssetData_h)\n',
+            '  #define WifiNetAssetData_h\n']
+    for name, path, macro, ctype, cond, count, raw, data, zipped in variants(phrases):
+        etag = '\\"%s\\"' % hashlib.sha1(raw).hexdigest()[:16]
+        body = blob(name, data)
+        body += '  static const WifiNetAsset %s = { %s, "%s", "%s", %sData, sizeof(%sData), %s };\n' % (
+            name, macro, ctype, etag, name, name, 'true' if zipped else 'false')
+        if count == 1:
+            out.append(body)
+            continue
+        out.append('  #if %s\n' % cond if cond else '  #else\n')
+        out.append(indent(body))
+        if not cond:
+            out.append('  #endif\n')
+    out.append('#endif  //WifiNetAssetData\n')
+    return ''.join(out)
+
+
+def main():
+    text = generate()
+    if '--check' in sys.argv[1:]:
+        current = open(OUTPUT).read() if os.path.exists(OUTPUT) else ''
+        if current != text:
+            sys.exit('gzassets: %s is out of date, run extras/tools/gzassets.py' % os.path.relpath(OUTPUT, ROOT))
+        return
+    with open(OUTPUT, 'w') as f:
+        f.write(text)
+    print('gzassets: wrote %s' % os.path.relpath(OUTPUT, ROOT))
+
+
+if __name__ == '__main__':
+    main()
@@ -13,14 +13,38 @@
  * methods:       begin; startWiFi; WiFiTimeOut; IsWifiConnected; WiFiCodePrint; GetWWWTime; 
  *                startOTAWifiServer; whileWait4Wifi; fetchCredFromEEPROM; UpdateWifiCredentials; 
  *                ClearEEPROMwifiCredentials; KeepCredentialsEEPROM; KeepChaBssidEEPROM; ServiceOTACred;
- *                SimpleUtilityPage; storeIPaddress; fetchIPaddress; CompareAndKeepIP; IsItNewIPaddress; getVersion;
+ *                SimpleUtilityPage; SendUtilityPage; RegisterPage; storeIPaddress; fetchIPaddress; CompareAndKeepIP; IsItNewIPaddress; getVersion;
+ *                onWifiConnected; StationGotIP; StationDisconnected; StationAuthChanged;
+ *                storeLease; fetchLease; ClearLease; fetchCredSlot; KeepCredSlot; FindCredSlot; AddCredSlot;
+ *                UpdateCredSlot; SelectCredSlot; setReconnectPolicy; ReconnectDelay; NextWakeIn;
+ *                SaveRTCsnapshot; fetchRTCsnapshot; StartAttempt; MarkPhase; AttemptCount; getAttempt; PhaseStats;
+ *                StationConnected; getStats; RegisterMetrics; ServiceMetrics; State;
+ *                TxBegin; TxWrite; TxCommit; ServiceEEPROM; KeepPmk; fetchPmk; Passphrase; RegisterAssets; ServiceAsset;
+ *                Pool; RegisterStatus; ServiceStatus; PostCommand; ServiceCommands; Admit; RegisterProvisioning;
+ *                ServiceDNS; Dns; StartNTP; ServiceNTP; Sntp;
+ *                state: methods changing <ManageWifi> work in place on the instance state (<State>) and return a
+ *                reference to it; their by value forms (<M> in, copy out) are kept for compatibility
  *                
  * EEPROM allocation
  * 
  * 0000 -> 0074 0x0000 -> 0x004A    credentials record
  * 0075 -> 0092 0x004B -> 0x005A    IP string (15 chars+0x00) referred by <EEPROMipAddress>
  * 0092 -> 0099 0x005B -> 0x0063    spare
- * 0100 ->      0x0064 ->           Application's records
+ * 0100 ->      0x0064 ->           Application's data from <EEPROMappAddress> (typed records of <WifiNetRecords> start at <WifiNetAppStart>)
+ * 0100 -> 0127 0x0064 -> 0x007F    DHCP lease record (28 bytes) referred by <EEPROMleaseAddress>, only for <_LEASECACHE>
+ * 0128 ->      0x0080 ->           credential slots (<CredSlots>*84 bytes) referred by <EEPROMslotsAddress>, only for <CredSlots> > 1
+ *                                  cached PMK record (40 bytes) after the slots, referred by <EEPROMpmkAddress>, only for <_PMKCACHE>
+ *
+ * the lease, slots and PMK records take bytes which up to version 0.2 belonged to the application (0x0064 on): an
+ * application enabling them moves its data to <WifiNetAppStart> or above and sets <EEPROMappAddress> to the new start,
+ * the build fails while the records end above <EEPROMappAddress>. <begin> checks the EEPROM size covers the records
+ *
+ * writes go to the EEPROM image only where bytes change; writers inside <TxBegin>...<TxCommit> share one commit,
+ * which <_DEFERCOMMIT> moves out of web requests and the connect path to <ServiceEEPROM> in loop()
+ *
+ * with <_JOURNALSTORE> the library records above (<Codes4Record>) live in the flash journal <WifiNetJournal>:
+ * <begin> loads them to the EEPROM image (records found only in EEPROM move to the journal once), the methods
+ * keep reading and writing the image and each change is appended to the journal instead of an EEPROM commit
  *
  */
 
@@ -32,17 +56,34 @@
                                   // https://github.com/esp8266/Arduino/blob/master/libraries/ESP8266WiFi/src/ESP8266WiFi.h
 #include  "ESPAsyncTCP.h"
 #include  "EEPROM.h"
+#include  <new>                   // placement of handler contexts in <WifiNetPool> slabs
+#ifdef  _SETDEEPSLEEP
+  #include  <sys/time.h>              // clock restore from RTC snapshot
+#endif  //_SETDEEPSLEEP
+#if _JOURNALSTORE==1 && defined(ARDUINO_ARCH_ESP8266)
+  extern "C" uint32_t _FS_end;        // linker symbols: end of the file system, the EEPROM sector
+  extern "C" uint32_t _EEPROM_start;
+#endif  //_JOURNALSTORE
+#if _JOURNALSTORE==1 && defined(ARDUINO_ARCH_ESP8266) && JournalFirstSector==0
+  #define JournalBase   ( ((uint32_t)&_EEPROM_start - 0x40200000)/JournalSectorSize - JournalSectors )
+#else
+  #define JournalBase   JournalFirstSector
+#endif  //_JOURNALSTORE
+#if _LEASECACHE==1
+  #include  "lwip/etharp.h"           // ARP conflict probe of cached lease
+#endif  //_LEASECACHE
+#if _LEASECACHE==1 || defined(_SETDEEPSLEEP)
+  #include  "lwip/dhcp.h"             // lease time offered by DHCP server
+#endif  //_LEASECACHE _SETDEEPSLEEP
+#if _GZASSETS==1
+  #define   WifiNetAssetData          // the asset blobs are kept in this translation unit
+  #include  "WifiNetAssets.h"
+#endif  //_GZASSETS
 
 TimePack  _SysClock;                // clock data
 Clock     _RunClock(_SysClock);     // clock instance
 Utilities _RunUtil(_SysClock);      // Utilities instance
 
-#ifdef  SETDEEPSLEEP
-  #define   ConnTimeOutRep  60      // 60 repeats ( 100*60= 6 seconds for deep-sleep)
-#else
-  #define   ConnTimeOutRep  120     // 120 repeats ( 100*120= 12 seconds for regular)
-#endif  //SETDEEPSLEEP
-
 // Local WiFi credentials
 const uint8_t LipA=192, LipB=168, LipC=7, LipD=60;      // local static IP
 
@@ -50,19 +91,262 @@ IPAddress   PreGateway(LipA,LipB,1,1);
 IPAddress   PreSubnet(255,255,255,0);
 IPAddress   Pre_local_IP(LipA,LipB,LipC,LipD);      // local IP
 IPAddress   Gateway, Subnet;  //, primaryDNS, seconderyDNS;
+const time_t  EpochValid = 1577836800;                // 1-I-2020, lower epochs mean clock not set
+static const uint16_t ConnHistBounds[ConnHistBuckets] = { 250, 500, 1000, 2000, 4000, 8000 };  // [mS]
+
+// **************************************************************************************** //
+struct  ChunkCursor {               // position of a line-by-line chunked response
+  uint16_t  Line;                   // next line to send
+  size_t    LineStart;              // response offset of <Line>
+};
+typedef int (*LineRender)(uint16_t Line, const void* Ctx, char* Out, size_t Cap);   // returns length, -1 past last line
+
+// **************************************************************************************** //
+static size_t StreamLines(LineRender Render, const void* Ctx, ChunkCursor& C, uint8_t* Buf, size_t MaxLen, size_t Index) {
+  /*
+    * chunked response filler: renders one line at a time into a small stack buffer and copies it to <Buf>
+    * <C> resumes where the previous chunk stopped (mid-line too), so lines are never rescanned
+    * returns bytes written, 0 once all lines were sent
+    */
+  char    line[112];
+  size_t  out=0;
+  if ( Index < C.LineStart ) { C.Line=0; C.LineStart=0; }   // restart from top (not expected)
+  while ( out < MaxLen ) {
+    int len = Render(C.Line, Ctx, line, sizeof(line));
+    if ( len < 0 ) break;                                   // all sent
+    if ( len > (int)sizeof(line)-1 ) len = sizeof(line)-1;  // truncated line
+    size_t  from = Index+out-C.LineStart;                   // already sent part of the line
+    if ( from < (size_t)len ) {
+      size_t  n = len-from;
+      if ( n > MaxLen-out ) n = MaxLen-out;
+      memcpy(Buf+out, line+from, n);
+      out += n;
+      if ( from+n < (size_t)len ) break;                    // chunk full mid-line
+    }
+    C.LineStart += len;
+    C.Line++;
+  }   // end of line loop
+  return  out;
+}     // end of StreamLines
+
+#if _LEASECACHE==1
+// **************************************************************************************** //
+static uint8_t  crc8(const uint8_t* Data, size_t Len) {
+  /*
+    * CRC-8 (polynomial 0x31, init 0xFF) for small EEPROM records (the lease record)
+    */
+  uint8_t crc = 0xFF;
+  while ( Len-- ) {
+    crc ^= *Data++;
+    for ( uint8_t b=0; b<8; b++ ) crc = ( crc & 0x80 ) ? (crc << 1) ^ 0x31 : (crc << 1);
+  }
+  return  crc;
+}     // end of crc8
+#endif  //_LEASECACHE
+
+// **************************************************************************************** //
+static uint32_t crc32(const uint8_t* Data, size_t Len) {
+  /*
+    * CRC-32 (IEEE, reflected) for RTC memory snapshot
+    */
+  uint32_t crc = 0xFFFFFFFF;
+  while ( Len-- ) {
+    crc ^= *Data++;
+    for ( uint8_t b=0; b<8; b++ ) crc = ( crc & 1 ) ? (crc >> 1) ^ 0xEDB88320 : (crc >> 1);
+  }
+  return  ~crc;
+}     // end of crc32
+
+// **************************************************************************************** //
+static bool WriteChanged(uint16_t Address, const void* Data, uint16_t Len) {
+  /*
+    * copy <Data> to the EEPROM image at <Address>, writing only the bytes which differ
+    * returns  1 when the image changed (a commit is needed)
+    */
+  const uint8_t*  d = (const uint8_t*)Data;
+  if ( Address+Len > EEPROM.length() || memcmp(EEPROM.getConstDataPtr()+Address, d, Len)==0 ) return  false;
+  for ( uint16_t i=0; i<Len; i++ ) {
+    if ( EEPROM.read(Address+i) != d[i] ) EEPROM.write(Address+i, d[i]);
+  }
+  return  true;
+}     // end of WriteChanged
+
+// **************************************************************************************** //
+static void CopyString(char* Dst, const uint8_t* Src, uint8_t Max) {
+  /*
+    * copy the string at <Src> (ends at 0x00 or after <Max> chars) to <Dst>, which holds <Max>+1 chars
+    */
+  uint8_t   n = 0;
+  for ( ; n<Max && Src[n]; n++ ) Dst[n] = Src[n];   // one pass, terminated once
+  Dst[n] = '\0';
+}     // end of CopyString
+
+#if CredSlots>1
+// **************************************************************************************** //
+static long NumberParam(AsyncWebServerRequest* request, const char* Name, long Default, long Min, long Max) {
+  /*
+    * request parameter <Name> as a number within <Min>...<Max>
+    * returns  <Default> when the field is missing, empty or not a number
+    */
+  if ( !request->hasParam(Name) ) return  Default;
+  const char* p = request->getParam(Name)->value().c_str();
+  char*   end;
+  long    v = strtol(p, &end, 10);
+  if ( end==p || *end ) return  Default;
+  return  constrain(v, Min, Max);
+}     // end of NumberParam
+#endif  //CredSlots
+
+#if _JOURNALSTORE==1
+// **************************************************************************************** //
+static bool RecordSpan(uint8_t Key, uint16_t* Address, uint16_t* Len) {
+  /*
+    * EEPROM image span of library record <Key> <Codes4Record>
+    * returns  0 for records not in use by this configuration (their bytes belong to the application)
+    */
+  switch ( Key ) {
+    case RecCred:   *Address = 0;                   *Len = EEPROMipAddress;       return  true;
+    case RecIP:     *Address = EEPROMipAddress;     *Len = 16;                    return  true;
+    case RecLease:  *Address = EEPROMleaseAddress;  *Len = sizeof(LeaseRecord);   return  _LEASECACHE==1;
+    case RecPmk:    *Address = EEPROMpmkAddress;    *Len = sizeof(PmkRecord);     return  _PMKCACHE==1;
+    default:
+      if ( Key < RecSlot || Key >= RecSlot+CredSlots || CredSlots<2 ) return  false;
+      *Address = EEPROMslotsAddress + (Key-RecSlot)*sizeof(CredSlot);
+      *Len = sizeof(CredSlot);
+      return  true;
+  }   // end of switch
+}     // end of RecordSpan
+  #define RecordKeys  ( RecPmk + (_PMKCACHE==1) )                     // library record keys in use
+  static_assert(RecordKeys <= JournalKeys, "more library records than <JournalKeys>");
+  static_assert(sizeof(CredSlot) <= JournalMaxRecord && EEPROMipAddress <= JournalMaxRecord, "record exceeds <JournalMaxRecord>");
+
+// **************************************************************************************** //
+static bool JournalFits(uint32_t First) {
+  /*
+    * journal sectors <First>...+<JournalSectors>-1 lie between the end of the file system and the EEPROM sector
+    * returns  0 when they overlap the file system, the sketch / OTA area or the EEPROM (journal not mounted)
+    */
+  #if defined(ARDUINO_ARCH_ESP8266)
+    uint32_t  fsEnd = ((uint32_t)&_FS_end - 0x40200000 + JournalSectorSize-1)/JournalSectorSize;
+    uint32_t  eeprom = ((uint32_t)&_EEPROM_start - 0x40200000)/JournalSectorSize;
+    return  First >= fsEnd && First+JournalSectors <= eeprom;
+  #else
+    (void)First;
+    return  true;                                   // host flash binding
+  #endif  //ARDUINO_ARCH_ESP8266
+}     // end of JournalFits
+#endif  //_JOURNALSTORE
+
+#if _LEASECACHE==1 || defined(_SETDEEPSLEEP)
+// **************************************************************************************** //
+static uint32_t OfferedLease() {
+  /*
+    * lease time[S] of the DHCP grant in use, <LeaseDefaultTime> when the server's is unknown; capped so that it
+    * counts in <millis> (about 24 days)
+    */
+  struct dhcp* D = netif_dhcp_data(netif_default);
+  uint32_t  t = ( D && D->offered_t0_lease ) ? D->offered_t0_lease : LeaseDefaultTime;
+  return  t < 0x1FFFFF ? t : 0x1FFFFF;
+}     // end of OfferedLease
+#endif  //_LEASECACHE _SETDEEPSLEEP
+
+// **************************************************************************************** //
+// utility page parts, joined into the templates at compile time (see WifiNetPage.h)
+#define S_Form    "<form method='get' action='" TplAction
+#define S_Form1   "'>&nbsp;&nbsp;&nbsp;&nbsp;Network SSID:<input type='text' name='" TplSsidName
+#define S_Form2   "'><BR><BR>Network password:<input type='text' name='" TplPswdName
+#define S_FormP   "'><BR><BR>Priority (0-255):<input type='text' name='" TplPrioName
+#define S_Form3   "'>&nbsp;<input type='submit' value='Enter'></form>"
+#define Msg1      "<h1>SSID and code obtaine are:</h1>"
+#define Msg2      "<h1>System is about to boot. Bye bye</h1>"
+
+WifiNetPageDef(PageFeedBack, TplHead "<h1>" TplFeedBack "</h1>" TplTail);        // <option> 0, 1, 2
+#if CredSlots>1
+  WifiNetPageDef(PageCredForm, TplHead S_Form S_Form1 S_Form2 S_FormP S_Form3 TplTail);   // <option> 3
+#else
+  WifiNetPageDef(PageCredForm, TplHead S_Form S_Form1 S_Form2 S_Form3 TplTail);
+#endif  //CredSlots
+WifiNetPageDef(PageCredAck, TplHead Msg1 "<h1>" TplSsid " " TplPass "</h1>" Msg2 TplTail);   // <option> 4
+WifiNetPageDef(PageEmpty, TplHead TplTail);                                       // <option> 5 and unregistered
+static_assert(PageOptions >= 6, "<PageOptions> below the library pages");
+static_assert(PageOwnLen >= 16+SSIDlength+1+PASSlength+1, "<PageOwnLen> does not hold time stamp, SSID and password");
 
 // **************************************************************************************** //
 WifiNet::WifiNet(ManageWifi M) {
     _LM = M;
+    _ConnectedCB = nullptr;
+    #if _WIFINTPON==1 && _SNTPCLIENT==1
+      _NtpDone = nullptr;
+    #endif  //_SNTPCLIENT
+    _EvFlags = 0;
+    _EvReason = 0;
+    _LeaseState = LeaseNone;
+    _LeaseProbeTime = 0;
+    _LeaseIP = 0;
+    _LeaseRenewMs = 0;
+    _LeaseGrantMs = 0;
+    _LeaseEndMs = 0;
+    _FastWake = false;
+    _RcCustom = nullptr;
+    _RcPolicy = ReconnectPolicyDefault;
+    _RcBase = ReconnectBase;
+    _RcCap = ReconnectCap;
+    _RcMaxAttempts = ReconnectMaxAttempts;
+    _RcAttempt = 0;
+    _RcWaiting = false;
+    _RcNextAttempt = 0;
+    _RTCepoch = 0;
+    _RTCoffsetMs = 0;
+    _RingHead = 0;
+    _RingCount = 0;
+    _TxDepth = 0;
+    _TxDirty = false;
+    _TxKeys = 0;
+    #if _JOURNALSTORE==1
+      _JournalOn = false;
+    #endif  //_JOURNALSTORE
+    _CommitPending = false;
+    #if _PMKCACHE==1
+      _PmkDue = false;
+    #endif  //_PMKCACHE
+    for ( uint8_t i=0; i<PageOptions; i++ ) _Pages[i] = i<3 ? &PageFeedBack : i==3 ? &PageCredForm : i==4 ? &PageCredAck : &PageEmpty;
+    _CommitDue = 0;
+    memset(&_Stats, 0, sizeof(_Stats));
 }     // end of WifiNet 
 
 // **************************************************************************************** //
-ManageWifi WifiNet::begin(ManageWifi M){
+ManageWifi& WifiNet::begin(){
   #if _LOGGME==1
     static const char Mname[] PROGMEM = "WifiNet::begin:";
     static const char L0[] PROGMEM = "WifiNet started. Version is ";
+    #if _JOURNALSTORE==1
+      static const char E0[] PROGMEM = "Journal not mounted, sectors outside file system end...EEPROM, records kept in EEPROM. 1st sector ";
+    #endif  //_JOURNALSTORE
+    static const char E1[] PROGMEM = "EEPROM too small for the library records, EEPROM.begin() size at least ";
   #endif  //_LOGGME
-  ManageWifi _M=M;
+  ManageWifi& _M = _LM;                 // works in place on the instance state
+
+  if ( EEPROM.length() < WifiNetAppStart ) {  // records past the end are neither read nor written
+    #if _LOGGME==1
+      _RunUtil.InfoStamp(_SysClock,Mname,E1,1,0); Serial.print(WifiNetAppStart); Serial.print(F(" -END\n"));
+    #endif  //_LOGGME
+  }   // end of size check
+
+  #if _JOURNALSTORE==1                  // journal records to the EEPROM image, EEPROM only records move to the journal
+    _JournalOn = JournalFits(JournalBase) && _Journal.begin(JournalBase, JournalSectors);
+    if ( _JournalOn ) {
+      uint8_t*  image = EEPROM.getDataPtr();
+      for ( uint8_t k=0; k<RecordKeys; k++ ) {
+        uint16_t  address, len;
+        if ( !RecordSpan(k, &address, &len) || _Journal.read(k, image+address, len) >= 0 ) continue;
+        if ( image[address] != 0xFF ) _Journal.write(k, image+address, len);   // set in EEPROM (not erased)
+      }   // end of records
+    } else {                            // sectors not free for the journal: records stay in EEPROM
+      #if _LOGGME==1
+        _RunUtil.InfoStamp(_SysClock,Mname,E0,1,0); Serial.print(JournalBase); Serial.print(F(" -END\n"));
+      #endif  //_LOGGME
+    }   // end of journal mount
+  #endif  //_JOURNALSTORE
 
   Gateway       = PreGateway;
   Subnet        = PreSubnet;
@@ -78,10 +362,21 @@ ManageWifi WifiNet::begin(ManageWifi M){
   _M.activeTimeEvent = 0;
   _M.HowLongItTook = 0;
   _M.RefreshTimeSet = false;
-  strcpy_P(&_M.DeviceIP[0],NO_IP_Set);
+  _M.StaticDynamicIP = false;
+  _M.DeviceIP = 0U;                     // reads as <NO_IP_Set>
   _M.uploadedFileLen = 0;               // init length of OTA elegant Server uploaded file
   _M.uploadFileRady = false;            // init OTA elegant Server uploaded file complete flag
-  _M.previousIP =  Pre_local_IP;        // default value
+  _M.previousIP = Pre_local_IP;         // default value
+  #if _WIFIEVENTS==1                    // register station event handlers (SDK context, keep them short)
+    _EvConnh = WiFi.onStationModeConnected([this](const WiFiEventStationModeConnected& E) {
+      StationConnected(E.channel); });
+    _EvGotIPh = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP& E) {
+      StationGotIP(E.ip, E.mask, E.gw); });
+    _EvDisconnh = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected& E) {
+      StationDisconnected(E.reason); });
+    _EvAuthh = WiFi.onStationModeAuthModeChanged([this](const WiFiEventStationModeAuthModeChanged& E) {
+      StationAuthChanged(E.oldMode, E.newMode); });
+  #endif  //_WIFIEVENTS
   #if _LOGGME==1
     _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(getVersion()); Serial.print(F(" -END\n"));
   #endif  //_LOGGME
@@ -90,30 +385,94 @@ ManageWifi WifiNet::begin(ManageWifi M){
 }     // end of begin
 
 // **************************************************************************************** //
-ManageWifi  WifiNet::startWiFi(TimePack  _SysClock, ManageWifi M) {
+ManageWifi& WifiNet::startWiFi(TimePack  _SysClock) {
   /*
     * Procedure to connect to the WiFi network as a station by variety of credentials options
     */
   static const char Mname[] PROGMEM = "startWiFi:";
   static const char L0[] PROGMEM = "Connecting to";
   static const char L1[] PROGMEM = "WiFichannel=";
+  #if defined(_SETDEEPSLEEP) && (_LOGGME==1)
+    static const char L2[] PROGMEM = "Fast wake from RTC snapshot to";
+  #endif  //_SETDEEPSLEEP
   static const char L3[] PROGMEM = "Not configured!";
   static const char L4[] PROGMEM = "Partially configured.";
   static const char L5[] PROGMEM = "Fully configured.";
   //static const char E0[] PROGMEM = "ERROR CredStat=";
   static const char E1[] PROGMEM = "ERROR failed to configure static IP required";
-  ManageWifi _M=M;
+  ManageWifi& _M = _LM;                 // works in place on the instance state
+
+  #ifdef  _SETDEEPSLEEP                 // wake from deep sleep: reconnect by RTC snapshot, no scan, DHCP or EEPROM
+    RTCsnapshot Snap;
+    if ( fetchRTCsnapshot(&Snap) ) {
+      int32_t   left = (int32_t)(Snap.LeaseLeft - (Snap.OffsetMs+millis())/1000);  // [S] of the lease after the sleep
+      WiFi.persistent(false);           // SDK config is not rewritten to flash on every wake
+      WiFi.mode(WIFI_STA);
+      _FastWake = true;
+      _M.StaticDynamicIP = _STATICIP==1 || ( Snap.LeaseLeft && left > 0 );
+      if ( _M.StaticDynamicIP ) {       // lease still valid: no DHCP
+        WiFi.config(IPAddress(Snap.IP),IPAddress(Snap.Gateway),IPAddress(Snap.Mask),IPAddress(Snap.Dns));
+        #if _STATICIP==0
+          _LeaseState = LeaseInUse;     // lease was in use before sleep, no probe and no rewrite
+          _LeaseEndMs = millis() + left*1000UL;
+          _LeaseRenewMs = millis() + left/2*1000UL;   // DHCP takes over half way (as T1)
+        #endif  //_STATICIP
+      } else {                          // lease over (or unknown): the address comes from DHCP
+        WiFi.config(0U,0U,0U);
+        _LeaseState = LeaseNone;
+      }   // end of lease check
+      strcpy(_M.Ssid,Snap.Ssid);
+      strcpy(_M.Password,Snap.Password);
+      memcpy(_M.WiFiBSsid,Snap.Bssid,6);
+      _M.WiFichannel = Snap.Channel;
+      _M.CredStat = Snap.CredStat<=2 ? Snap.CredStat : 0;  // 2 bit field: a stray value reads as not programmed
+      _RTCepoch = Snap.Epoch;           // clock for <GetWWWTime>
+      _RTCoffsetMs = Snap.OffsetMs;
+      _RcAttempt = 0;
+      _RcWaiting = false;
+      _M.ledIndicationCode = LedWifiSearch;
+      _M.TimeMeasured = _RunClock.StartStopwatch();
+      _M.WiFiStatus = Trying_Connect;
+      StartAttempt();
+      WiFi.begin(_M.Ssid, Passphrase(), _M.WiFichannel, _M.WiFiBSsid, true );
+      MarkPhase(PhBegin);
+      #if _LOGGME==1
+        _RunUtil.InfoStamp(_SysClock,Mname,L2,1,0); Serial.print(_M.Ssid); Serial.print(F(" IP "));
+        if ( _M.StaticDynamicIP ) Serial.print(IPAddress(Snap.IP));
+        else                      Serial.print(F("by DHCP"));
+        Serial.print(F(" -END\n"));
+      #endif  //_LOGGME
+      _M.activeTimeEvent = 1;           // set connection timer - renewable <WIFICONNECT>
+      return  _M;
+    } // end of fast wake
+  #endif  //_SETDEEPSLEEP
 
   // Set WiFi to station mode and disconnect from an AP if it was previously connected
+  _FastWake = false;
+  StartAttempt();
   WiFi.mode(WIFI_STA);
+  #if _WIFIEVENTS==1
+    bool  wasConnected = WiFi.isConnected();
+    _EvFlags = 0;
+  #endif  //_WIFIEVENTS
   WiFi.disconnect();
   _M.WiFiStatus = Not_Connected;        // WiFi not connected
   _M.ledIndicationCode = LedWifiSearch; // indicate search for WiFi network
-  delay(500);
+  #if _WIFIEVENTS==1                    // wait for link down only if it was up (bounded by <WiFiDisconnectWait>)
+    unsigned long waitStart = millis();
+    while ( wasConnected && !(_EvFlags & EvDisconnected) && millis()-waitStart < WiFiDisconnectWait ) delay(10);
+    _EvFlags = 0;                       // clear events latched by the previous link
+  #else
+    delay(500);
+  #endif  //_WIFIEVENTS
+  MarkPhase(PhDisconnect);
 
   //KeepCredentialsEEPROM("Sachi","Kalisher46apt7");
   // fetch credentials
-  _M = fetchCredFromEEPROM(_SysClock,_M); // get credentials from EEPROM
+  fetchCredFromEEPROM(_SysClock);         // get credentials from EEPROM
+  #if CredSlots>1
+    SelectCredSlot(_SysClock);             // best known network out of a single scan
+  #endif  //CredSlots
   #if _LOGGME==1
     _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(_M.Ssid); Serial.print(F(" (Password ")); Serial.print(_M.Password); 
     Serial.print(F(") Credenial status ")); 
@@ -126,22 +485,47 @@ ManageWifi  WifiNet::startWiFi(TimePack  _SysClock, ManageWifi M) {
     Serial.print(F(" ("));Serial.print(_M.CredStat); Serial.print(F(") -END\n"));
   #endif  //_LOGGME
   
+  #if (_LEASECACHE==1) && (_STATICIP==0)  // reuse the last lease granted by this AP, skip the DHCP round-trip
+    LeaseRecord Lease;
+    if ( _LeaseState != LeaseNone ) WiFi.config(0U,0U,0U);   // back to DHCP before deciding again
+    _LeaseState = LeaseNone;
+    _M.StaticDynamicIP = false;
+    if ( _M.CredStat==2 && fetchLease(&Lease) && memcmp(Lease.Bssid,_M.WiFiBSsid,6)==0 ) {
+      if ( WiFi.config(IPAddress(Lease.IP),IPAddress(Lease.Gateway),IPAddress(Lease.Mask),IPAddress(Lease.Dns)) ) {
+        uint32_t  left = Lease.Expiry - (uint32_t)time(nullptr);   // [S], fetched leases have a dated expiry
+        _LeaseState = LeaseApplied;         // to be probed for conflict once the link is up
+        _LeaseIP = Lease.IP;
+        left = left < 0x1FFFFF ? left : 0x1FFFFF;
+        _LeaseEndMs = millis() + left*1000UL;
+        _LeaseRenewMs = millis() + left/2*1000UL;   // DHCP takes over half way (as T1)
+        _M.StaticDynamicIP = true;
+      }
+    } // end of lease check
+  #endif  //_LEASECACHE
+
   // connect
   _M.TimeMeasured = _RunClock.StartStopwatch();
   _M.WiFiStatus=Trying_Connect;         // trying to connect to WiFi 
+  _RcAttempt = 0;
+  _RcWaiting = false;
+  #if ReconnectStartJitter>0            // spread the 1st attempt of a fleet powered up together (see <WiFiTimeOut>)
+    _RcNextAttempt = millis()+random(ReconnectStartJitter+1);
+    _RcWaiting = true;
+  #else
   switch ( _M.CredStat ) {
     case 0:                             // credentials are not set - dummy call or default
-      WiFi.begin(_M.Ssid, _M.Password);
-      break;
     case 1:                             // partial credential exists
-      WiFi.begin(_M.Ssid, _M.Password);
+      if ( _M.WiFichannel )             // AP located by credential slot selection
+        WiFi.begin(_M.Ssid, Passphrase(), _M.WiFichannel, _M.WiFiBSsid, true );
+      else
+        WiFi.begin(_M.Ssid, Passphrase());
       break;
     case 2:                             // full credentials exists
       #if _LOGGME==1
         _RunUtil.InfoStamp(_SysClock,Mname,L1,1,0);  Serial.print(_M.WiFichannel); Serial.print(F(" WiFiBSsid="));
         for ( int i=0; i<6; i++ ){ Serial.print(_M.WiFiBSsid[i],HEX); Serial.print(F(":")); } Serial.print(F(" -END\n"));
       #endif  //_LOGGME
-      WiFi.begin(_M.Ssid, _M.Password, _M.WiFichannel, _M.WiFiBSsid, true );  // https://arduino-esp8266.readthedocs.io/en/latest/esp8266wifi/station-class.html#begin 
+      WiFi.begin(_M.Ssid, Passphrase(), _M.WiFichannel, _M.WiFiBSsid, true );  // https://arduino-esp8266.readthedocs.io/en/latest/esp8266wifi/station-class.html#begin 
       break;
     default:
       // error
@@ -149,6 +533,8 @@ ManageWifi  WifiNet::startWiFi(TimePack  _SysClock, ManageWifi M) {
       _M.WiFiStatus=Not_Connected;                       // WiFi not connected
       break;
   }   // end of begin switch
+  MarkPhase(PhBegin);
+  #endif  //ReconnectStartJitter
 
   // establish connection
   _M.activeTimeEvent = 1;                    // set connection timer - renewable <WIFICONNECT>
@@ -156,7 +542,7 @@ ManageWifi  WifiNet::startWiFi(TimePack  _SysClock, ManageWifi M) {
 } // end of startWiFi
 
 // **************************************************************************************** //
-ManageWifi  WifiNet::WiFiTimeOut(TimePack  _SysClock, ManageWifi M){
+ManageWifi& WifiNet::WiFiTimeOut(TimePack  _SysClock){
   /*
     * Method to address end of wifi connect time out
     */
@@ -164,8 +550,12 @@ ManageWifi  WifiNet::WiFiTimeOut(TimePack  _SysClock, ManageWifi M){
   static const char L0[] PROGMEM = "Connection timeout.";
   static const char L1[] PROGMEM = "Setting up Soft Access Point.";
   static const char L2[] PROGMEM = "WiFi connection lost. Trying more";
+  static const char L3[] PROGMEM = "Connection timeout. Retry ";
   static const char E0[] PROGMEM = "Error! Wrong wifi status code=";
-  ManageWifi _M=M;
+  #if defined(_SETDEEPSLEEP) && (_LOGGME==1)
+    static const char L4[] PROGMEM = "RTC snapshot did not reconnect, regular connect (scan, DHCP)";
+  #endif  //_SETDEEPSLEEP
+  ManageWifi& _M = _LM;                 // works in place on the instance state
   #ifdef OLEDON
     char  OLEDbuf[10];
     char  OLEDbuf1[10];
@@ -174,8 +564,8 @@ ManageWifi  WifiNet::WiFiTimeOut(TimePack  _SysClock, ManageWifi M){
     static const char OLEDmsg2[] PROGMEM = "TimOut";
   #endif //OLEDON
     
-  // check if WiFi connected (skip if waiting for credentials, all is async)
-  if ( _M.WiFiStatus != Configure_OTA ) _M = IsWifiConnected(_SysClock,_M); 
+  // check if WiFi connected (skip if waiting for credentials, all is async; or radio idle between windows)
+  if ( _M.WiFiStatus != Configure_OTA && !_RcWaiting ) IsWifiConnected(_SysClock); 
   whileWait4Wifi(_M);                                 // print while waiting
 
   switch ( _M.WiFiStatus ) {
@@ -190,6 +580,7 @@ ManageWifi  WifiNet::WiFiTimeOut(TimePack  _SysClock, ManageWifi M){
       break;
 
     case  Connection_lost:                            // WiFi accidential lost - wait
+      _Stats.Reconnects++;
       _M.HowLongItTook = 1;                           // keep timeout timer
       _M.activeTimeEvent = 1;                         // set connection timer for renew
       _RunUtil.InfoStamp(_SysClock,Mname,L2,1,1); 
@@ -199,6 +590,48 @@ ManageWifi  WifiNet::WiFiTimeOut(TimePack  _SysClock, ManageWifi M){
 
     case  Trying_Connect:                             // Not connected - check timeout
       _M.ledIndicationCode = LedWifiSearch;
+      if ( _RcWaiting ) {                             // wait between connection windows
+        _M.activeTimeEvent = 1;                       // set connection timer for renew
+        if ( (long)(millis()-_RcNextAttempt) >= 0 ) { // start next window
+          _RcWaiting = false;
+          _M.HowLongItTook = 0;
+          if ( _RcAttempt ) StartAttempt();           // retry is a new attempt (1st one started by <startWiFi>)
+          if ( _M.WiFichannel ) WiFi.begin(_M.Ssid, Passphrase(), _M.WiFichannel, _M.WiFiBSsid, true );
+          else                  WiFi.begin(_M.Ssid, Passphrase());
+          MarkPhase(PhBegin);
+        }
+        break;
+      }   // end of wait
+      #ifdef  _SETDEEPSLEEP
+        if ( _M.HowLongItTook >= ConnTimeOutRep && _FastWake ) {   // snapshot window over: the regular path once
+          #if _LOGGME==1
+            Serial.println();     // terminate wait line
+            _RunUtil.InfoStamp(_SysClock,Mname,L4,1,1);
+          #endif  //_LOGGME
+          _FastWake = false;
+          SaveRTCsnapshot(_M, 0);                     // not connected: the snapshot is invalidated
+          WiFi.config(0U,0U,0U);                      // drop the snapshot address
+          _LeaseState = LeaseNone;
+          _M.StaticDynamicIP = false;
+          _M.HowLongItTook = 0;
+          startWiFi(_SysClock);                       // EEPROM credentials (and scan), DHCP
+          break;
+        }   // end of fast wake window
+      #endif  //_SETDEEPSLEEP
+      if ( _M.HowLongItTook >= ConnTimeOutRep && _RcAttempt < _RcMaxAttempts ) {   // window over, back off and retry
+        uint32_t  wait = ReconnectDelay(_RcAttempt);
+        _RcAttempt++;
+        WiFi.disconnect();                            // keep radio off the AP while waiting
+        _RcNextAttempt = millis()+wait;
+        _RcWaiting = true;
+        _M.HowLongItTook = 0;
+        _M.activeTimeEvent = 1;                       // set connection timer for renew
+        #if _LOGGME==1
+          Serial.println();     // terminate wait line
+          _RunUtil.InfoStamp(_SysClock,Mname,L3,1,0); Serial.print(_RcAttempt); Serial.print(F(" in ")); Serial.print(wait); Serial.print(F("mS -END\n"));
+        #endif  //_LOGGME
+        break;
+      }   // end of back off
       if ( _M.HowLongItTook >= ConnTimeOutRep ) {     // apply timeout for connection
         #if  _OTAWIFICONFIG==1
           _M.activeTimeEvent = 1;                     // set connection timer for renew
@@ -211,7 +644,7 @@ ManageWifi  WifiNet::WiFiTimeOut(TimePack  _SysClock, ManageWifi M){
             printOLED ( "Start OTA","TimOut",2);
           #endif //OLEDON
           _M.ledIndicationCode = LedAPSearch;         // indicate AP mode seaarch for client
-          _M = startOTAWifiServer(_SysClock, _M);     // start soft access point
+          startOTAWifiServer(_SysClock);              // start soft access point
         #endif  //_OTAWIFICONFIG
         _M.HowLongItTook = 0;                         // reset counter to avoid overflow
       }                                               // end of tries check
@@ -233,7 +666,7 @@ ManageWifi  WifiNet::WiFiTimeOut(TimePack  _SysClock, ManageWifi M){
 }     // end of WiFiTimeOut
 
 // **************************************************************************************** //
-ManageWifi WifiNet::IsWifiConnected(TimePack  _SysClock, ManageWifi M){
+ManageWifi& WifiNet::IsWifiConnected(TimePack  _SysClock){
   /*
     * method to check until connected to WiFi network, it is called after <WIFICONNECT> event is due
     *  - if not connected, activate timeout for OTA credenial setting
@@ -247,12 +680,62 @@ ManageWifi WifiNet::IsWifiConnected(TimePack  _SysClock, ManageWifi M){
   //static const char L1[] PROGMEM = "Waiting for connection";
   static const char L2[] PROGMEM = "Connected to network.";
   static const char G2[] PROGMEM = "IP Address:";
-  ManageWifi _M=M;
+  #if (_LEASECACHE==1) && (_STATICIP==0) && (_LOGGME==1)
+    static const char E1[] PROGMEM = "Cached lease IP is in use by another host, back to DHCP. IP ";
+  #endif  //(_LEASECACHE==1) && (_STATICIP==0) && (_LOGGME==1)
+  ManageWifi& _M = _LM;                 // works in place on the instance state
   // https://www.arduino.cc/en/Reference/WiFiStatus
-  if (WiFi.status() != WL_CONNECTED) {      // continue the wait period, reneu the timer
+  #if _WIFIEVENTS==1                        // latched got-IP event, WiFi status as fallback
+    bool  linkUp = ( _EvFlags & EvGotIP ) || WiFi.status()==WL_CONNECTED;
+  #else
+    bool  linkUp = WiFi.status()==WL_CONNECTED;
+    if ( linkUp ) MarkPhase(PhGotIP);
+  #endif  //_WIFIEVENTS
+  #if (_LEASECACHE==1) && (_STATICIP==0)    // ARP conflict probe of the cached lease before using it
+    if ( linkUp && ( _LeaseState==LeaseApplied || _LeaseState==LeaseProbing ) ) {
+      ip4_addr_t  probeIP;
+      ip4_addr_set_u32(&probeIP, _LeaseIP);
+      linkUp = false;                       // hold the connection until the probe is over
+      if ( _LeaseState==LeaseApplied ) {    // 1st tick with link: ask who holds the cached IP
+        etharp_request(netif_default, &probeIP);
+        _LeaseProbeTime = millis();
+        _LeaseState = LeaseProbing;
+      } else if ( millis()-_LeaseProbeTime >= ARPprobeWait ) {
+        struct eth_addr*  ethRet;
+        const ip4_addr_t* ipRet;
+        if ( etharp_find_addr(netif_default, &probeIP, &ethRet, &ipRet) >= 0 &&
+             memcmp(ethRet->addr, netif_default->hwaddr, 6) != 0 ) {
+                                            // IP held by another host - drop the lease, reconnect by DHCP
+          #if _LOGGME==1
+            _RunUtil.InfoStamp(_SysClock,Mname,E1,1,0); Serial.print(IPAddress(_LeaseIP)); Serial.print(F(" -END\n"));
+          #endif  //_LOGGME
+          ClearLease(_SysClock);
+          _LeaseState = LeaseNone;
+          _M.StaticDynamicIP = false;
+          #if _WIFIEVENTS==1
+            _EvFlags &= ~EvGotIP;
+          #endif  //_WIFIEVENTS
+          WiFi.disconnect();
+          WiFi.config(0U,0U,0U);
+          WiFi.begin(_M.Ssid, Passphrase(), _M.WiFichannel, _M.WiFiBSsid, true);
+        } else {
+          _LeaseState = LeaseInUse;         // no conflict
+          MarkPhase(PhStaticIP);
+          linkUp = true;
+        }   // end of conflict check
+      }   // end of probe state
+    }   // end of lease probe
+  #endif  //_LEASECACHE
+  if ( !linkUp ) {                          // continue the wait period, reneu the timer
                                             //------------------------------------------
     _M.activeTimeEvent = 1;                 // re start connection timer <WIFICONNECT>
     if ( WiFi.status()==WL_CONNECTION_LOST ) _M.WiFiStatus=Connection_lost;
+    #if _WIFIEVENTS==1
+      if ( _EvFlags & EvAuthChanged ) {     // AP changed its security, restart the wait
+        _EvFlags &= ~EvAuthChanged;
+        _M.WiFiStatus=Connection_lost;
+      }
+    #endif  //_WIFIEVENTS
     _M.HowLongItTook++;
     
   } else {                                  // successul connection to WiFi 
@@ -273,6 +756,7 @@ ManageWifi WifiNet::IsWifiConnected(TimePack  _SysClock, ManageWifi M){
       } else {
         // successful Static IP
         _M.StaticDynamicIP = true;
+        MarkPhase(PhStaticIP);
       }   // end of IP configuration
     #endif  //_STATICIP
 
@@ -284,18 +768,38 @@ ManageWifi WifiNet::IsWifiConnected(TimePack  _SysClock, ManageWifi M){
                                                 // update credentials
     memcpy( _M.WiFiBSsid, WiFi.BSSID(), 6 );    // keep 6 bytes of BSSID (AP's MAC address)
     _M.WiFichannel=WiFi.channel();              // keep channel
-    _M = UpdateWifiCredentials(_SysClock,_M);
+    TxBegin();                                  // credential, slot and lease updates share one commit
+    UpdateWifiCredentials(_SysClock);
+    #if _PMKCACHE==1
+      _PmkDue = true;                           // key of the network joined, derived by <ServiceEEPROM> in loop()
+    #endif  //_PMKCACHE
+    #if CredSlots>1
+      UpdateCredSlot(_SysClock,_M);             // keep AP and recency of the network's slot
+    #endif  //CredSlots
+    MarkPhase(PhCredUpdate);
                                                 // connection status
     _M.WiFiStatus = Connected;                  // WiFi connected
-    WiFi.localIP().toString().toCharArray(&_M.DeviceIP[0], 17);   // keep char version of IP
-    _M.previousIP =  WiFi.localIP();            // keep IP
+    _M.DeviceIP = (uint32_t)WiFi.localIP();     // keep IP, formatted when displayed
+    _M.previousIP = _M.DeviceIP.Addr;           // keep IP
+    #if (_LEASECACHE==1 || defined(_SETDEEPSLEEP)) && (_STATICIP==0)
+      if ( _LeaseState != LeaseInUse ) {          // new lease granted by DHCP
+        _LeaseGrantMs = millis();
+        _LeaseEndMs = _LeaseGrantMs + OfferedLease()*1000UL;
+        #if _LEASECACHE==1
+          storeLease(_SysClock,_M.WiFiBSsid);
+        #endif  //_LEASECACHE
+      }
+    #endif  //_LEASECACHE _SETDEEPSLEEP
+    TxCommit(true);
     #if   _DEBUGON==1
-      _RunUtil.InfoStamp(_SysClock,Mname,G2,0,0); Serial.print(WiFi.localIP()); Serial.print(F(" Actual IP ")); Serial.print(_M.DeviceIP); 
+      _RunUtil.InfoStamp(_SysClock,Mname,G2,0,0); Serial.print(WiFi.localIP()); Serial.print(F(" Actual IP ")); Serial.print(_M.DeviceIP.text()); 
       if (_M.StaticDynamicIP) Serial.print(F(" Dynamic IP"));
       else                    Serial.print(F(" Static IP"));
       Serial.print(F(" - END\n"));
     #endif  //_DEBUGON
     _M.HowLongItTook = 0;                        // clear retry counter
+    _RcAttempt = 0;                              // clear reconnect policy
+    _FastWake = false;
     _M.TimeMeasured = _RunClock.StartStopwatch();// start measuring for NTP
   }   // end of check for connection
 
@@ -314,15 +818,12 @@ void  WifiNet::WiFiCodePrint(uint8_t Index) {
   static const char   code_str_4[] PROGMEM = "Client connected as AP (OTA)";
   static const char   code_str_5[] PROGMEM = "WiFi connection lost";
   static const char*  code_str_tab[] PROGMEM = { code_str_0, code_str_1, code_str_2, code_str_3, code_str_4, code_str_5 };
-  char* buf=new char[80]; // Temp buffer
-  strcpy_P(buf,(char*)pgm_read_dword(&(code_str_tab[Index])));
-  Serial.print(buf);
-  delete [] buf;              // release buffer
+  Serial.print(FPSTR((const char*)pgm_read_ptr(&(code_str_tab[Index]))));   // straight from flash
 }   // end of WiFiCodePrint
 
 #if  _WIFINTPON==1
   // **************************************************************************************** //
-  TimePack  WifiNet::GetWWWTime (TimePack  SysClock, ManageWifi M) {
+  TimePack  WifiNet::GetWWWTime (TimePack  SysClock, const ManageWifi& M) {
     /*
       * https://github.com/arduino-libraries/NTPClient
       * https://www.timeanddate.com/worldclock/linking.html
@@ -351,20 +852,49 @@ void  WifiNet::WiFiCodePrint(uint8_t Index) {
     #if _LOGGME==200
       static const char G0[] PROGMEM = "Starts";
     #endif  //_LOGGME
-    static const char E0[] PROGMEM = "Failed to update time.";
-    static const char L0[] PROGMEM = "GMT time=";
     static const char L1[] PROGMEM = "Local time=";
     static const char L2[] PROGMEM = "Time to acquire network time is ";
-    const char *NTPserver1="pool.ntp.org";
-    const char *NTPserver2="time.nist.gov";
-    const char *NTPserver3="time.google.com";
+    #if _SNTPCLIENT==0                      // configTime() of the core SNTP
+      static const char E0[] PROGMEM = "Failed to update time.";
+      static const char L0[] PROGMEM = "GMT time=";
+      const char *NTPserver1="pool.ntp.org";
+      const char *NTPserver2="time.nist.gov";
+      const char *NTPserver3="time.google.com";
+    #endif  //_SNTPCLIENT
     struct tm timeinfo;
     TimePack  _SysClock = SysClock;
     
     _SysClock.IsTimeSet = true;             // temporary flag
+    #ifdef  _SETDEEPSLEEP
+      if ( _SysClock.NTPbeginOnce && _RTCepoch ) {  // woke from deep sleep: clock by RTC snapshot, skip the NTP wait
+        timeval tv = { (time_t)(_RTCepoch + (_RTCoffsetMs+millis())/1000), 0 };
+        #if _SNTPCLIENT==1
+          if ( !_Sntp.active() ) StartNTP(_NtpDone);  // rounds keep syncing in background
+        #else
+          configTime(0, 0, NTPserver1, NTPserver2, NTPserver3); // SNTP keeps syncing in background
+        #endif  //_SNTPCLIENT
+        settimeofday(&tv, nullptr);
+        _Stats.NTPsyncTime = millis();
+        _SysClock.NTPbeginOnce=false;
+        _RTCepoch = 0;
+      }
+    #endif  //_SETDEEPSLEEP
     #if _LOGGME==200
       _RunUtil.InfoStamp(_SysClock,Mname,G0,1,1); 
     #endif  //_LOGGME
+    #if _SNTPCLIENT==1                      // no wait: the rounds run by <ServiceNTP>, here the clock is read
+      if ( !_Sntp.active() ) StartNTP(_NtpDone);
+      _SysClock.NTPbeginOnce=false;
+      ServiceNTP();
+      if ( !_Stats.NTPsyncTime ) {          // no round synced (or RTC snapshot) yet
+        _SysClock.IsTimeSet = false;
+        return  _SysClock;
+      }
+      time_t  now = _Sntp.synced() ? _Sntp.now(millis()) : time(nullptr);
+      setenv("TZ","IST-2IDT,M3.4.4/26,M10.5.0",1);
+      tzset();
+      localtime_r(&now, &timeinfo);
+    #else
     if ( _SysClock.NTPbeginOnce ) {         // perform only after reset
       #if _DEBUGON==200
         _RunUtil.InfoStamp(_SysClock,Mname,nullptr,0,0); Serial.print("1st entry _SysClock.NTPbeginOnce="); Serial.print(_SysClock.NTPbeginOnce); 
@@ -404,6 +934,7 @@ void  WifiNet::WiFiCodePrint(uint8_t Index) {
       _SysClock.IsTimeSet = false;
     }   // end of time test 2
     if (!_SysClock.IsTimeSet) return _SysClock; // failure on test 2
+    #endif  //_SNTPCLIENT
     
     #if _LOGGME==1
       static const char daysOfTheWeek[7][12] PROGMEM = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
@@ -422,6 +953,10 @@ void  WifiNet::WiFiCodePrint(uint8_t Index) {
     _SysClock.clockMonth = timeinfo.tm_mon+1;
     _SysClock.clockDay  = timeinfo.tm_mday;
     _SysClock.clockWeekDay = timeinfo.tm_wday;  // Sunday=0... Saturday=6
+    #if _SNTPCLIENT==0                      // <ServiceNTP> marks the synced rounds
+      MarkPhase(PhNTPsync);
+      _Stats.NTPsyncTime = millis();
+    #endif  //_SNTPCLIENT
     
         return _SysClock;
 
@@ -429,20 +964,27 @@ void  WifiNet::WiFiCodePrint(uint8_t Index) {
 #endif  //_WIFINTPON
 
 // **************************************************************************************** //
-ManageWifi  WifiNet::startOTAWifiServer(TimePack  _SysClock, ManageWifi M){
+ManageWifi& WifiNet::startOTAWifiServer(TimePack  _SysClock){
   /*
     * method to initiate OTA Async web server over SAP to obtaine network credentials
     */
   static const char Mname[] PROGMEM = "startOTAWifiServer:";
   static const char L0[] PROGMEM = "Soft AP started=";
-  ManageWifi _M=M;
+  ManageWifi& _M = _LM;                 // works in place on the instance state
 
   // set sot access point, initiate timer and wait for client to connect to SAP and provide configuration
   // https://github.com/esp8266/Arduino/blob/master/doc/esp8266wifi/soft-access-point-class.rst
   bool  SAP=WiFi.softAP(SoftAccPntSSID);
+  _Stats.SoftAPentries++;
+  #if _CAPTIVEDNS==1
+    _Dns.begin(WiFi.softAPIP());            // every name to the soft AP, the phone opens the form by itself
+  #endif  //_CAPTIVEDNS
 
   #if _LOGGME==1
     _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(SAP); Serial.print(F(" Soft Access Point IP=")); Serial.print(WiFi.softAPIP()); 
+    #if _CAPTIVEDNS==1
+      Serial.print(F(" DNS=")); Serial.print(_Dns.active());
+    #endif  //_CAPTIVEDNS
     Serial.print(F(" -END\n"));
   #endif  //_LOGGME
   _M.WiFiStatus=Configure_OTA;              // AP (OTA)configured as server, waiting for client to connect
@@ -450,7 +992,7 @@ ManageWifi  WifiNet::startOTAWifiServer(TimePack  _SysClock, ManageWifi M){
 }   // end of startOTAWifiServer
   
 // **************************************************************************************** //
-void  WifiNet::whileWait4Wifi(ManageWifi M){
+void  WifiNet::whileWait4Wifi(const ManageWifi& M){
   /*
     * method to indicate wait period once waiting for client toconnect to the wifi network
     * it counts to 20 (aprox 2 Sec) then prints wait pattern by status
@@ -510,7 +1052,7 @@ void  WifiNet::whileWait4Wifi(ManageWifi M){
 }     // end of whileWait4Wifi
 
 // **************************************************************************************** //
-ManageWifi   WifiNet::fetchCredFromEEPROM(TimePack _SysClock, ManageWifi M){
+ManageWifi& WifiNet::fetchCredFromEEPROM(TimePack _SysClock){
   /*
     * Procedure to fetch credentials from EEPROM and load <ssid> <password> <bssid> <channel>
     * <M.CredStat>  2 for pre programmed EEPROM with all parameters
@@ -533,15 +1075,17 @@ ManageWifi   WifiNet::fetchCredFromEEPROM(TimePack _SysClock, ManageWifi M){
   static const char L3[] PROGMEM = "Not configured!";
   static const char L4[] PROGMEM = "Partially configured.";
   static const char L5[] PROGMEM = "Fully configured.";
-  ManageWifi _M=M;
+  ManageWifi& _M = _LM;                 // works in place on the instance state
   
   // 1. reset EEPROM to config by firmware code
   #ifdef  CLEAREEPROM                
     ClearEEPROMwifiCredentials();
   #endif  //CLEAREEPROM
-  // 2. check integrity of previous write to EEPROM
-  if ( char(EEPROM.read(0))=='*' )      { _M.CredStat=2;      // for fully programmed EEPROM
-  } else if (char(EEPROM.read(0))=='+') { _M.CredStat=1;      // for partially programmed EEPROM
+  // 2. check integrity of previous write to EEPROM; the record is decoded from one view of the image
+  const uint8_t*  rec = EEPROM.getConstDataPtr();
+  if ( EEPROM.length() < SSIDlength+PASSlength+1+6+1+1 ) { _M.CredStat=0;  // image too short for the record
+  } else if ( rec[0]=='*' )             { _M.CredStat=2;      // for fully programmed EEPROM
+  } else if ( rec[0]=='+' )             { _M.CredStat=1;      // for partially programmed EEPROM
   } else                                { _M.CredStat=0;      // EEPROM was NOT pre-programmed
   } // end integrity check
   #if _LOGGME==1
@@ -555,34 +1099,22 @@ ManageWifi   WifiNet::fetchCredFromEEPROM(TimePack _SysClock, ManageWifi M){
     Serial.print(F(" -END\n"));
   #endif  //_LOGGME
 
+  if ( _M.CredStat !=2 ) _M.WiFichannel = 0;   // BSSID and channel unknown
   if ( _M.CredStat !=0 ) {                // fetch credenial (if EEPROM programmed)
-    // 3. read SSID configuration from EEPROM: byte[1] to [SSIDlength]
-    for (uint8_t i=1; i <= SSIDlength; ++i) { 
-      _M.Ssid[i-1]=char(EEPROM.read(i)); 
-      _M.Ssid[i]='\0';      // set termination
-      //Serial.print(F(" i ")); Serial.print(i);Serial.print(F(" S(i-1) ")); Serial.print(Ssid[i-1],HEX); Serial.print(F(" i ")); Serial.println(Ssid[i],HEX);
-      }
-    // 4. read PASSWORD configuration from EEPROM: byte[SSIDlength+1] to [SSIDlength+PASSlength]
-    for (uint8_t i=0; i < PASSlength; ++i) { 
-      _M.Password[i] = char(EEPROM.read(SSIDlength+i)); 
-      _M.Password[i+1]='\0'; 
-      }
+    // 3. read SSID configuration from EEPROM: byte[1] to [SSIDlength-1]
+    CopyString(_M.Ssid, rec+1, SSIDlength-1);
+    // 4. read PASSWORD configuration from EEPROM: byte[SSIDlength] to [SSIDlength+PASSlength-1]
+    CopyString(_M.Password, rec+SSIDlength, PASSlength);
     #if _LOGGME==1
       _RunUtil.InfoStamp(_SysClock,Mname,L1,1,0); Serial.print(_M.Ssid); Serial.print(F(" PW:")); Serial.print(_M.Password); Serial.print(F(" -END\n"));
     #endif  //_LOGGME
     // 5. read BSSID and channel configuration from EEPROM: byte[SSIDlength+PASSlength+1] to [SSIDlength+PASSlength+7] and [SSIDlength+PASSlength+8]
     if ( _M.CredStat==2 ) {
+      memcpy(_M.WiFiBSsid, rec+SSIDlength+PASSlength+1, 6);
+      _M.WiFichannel = rec[SSIDlength+PASSlength+1+6+1];
       #if _LOGGME==1
         _RunUtil.InfoStamp(_SysClock,Mname,L2,1,0);
-      #endif  //_LOGGME
-      for (uint8_t i = 0; i < 6 ; ++i) { 
-        _M.WiFiBSsid[i] = byte(EEPROM.read(SSIDlength+PASSlength+1+i)); 
-        #if _LOGGME==1
-          Serial.print(_M.WiFiBSsid[i],HEX); Serial.print(F(":"));
-        #endif  //_LOGGME
-      }
-      _M.WiFichannel = byte(EEPROM.read(SSIDlength+PASSlength+1+6+1));
-      #if _LOGGME==1
+        for (uint8_t i = 0; i < 6 ; ++i) { Serial.print(_M.WiFiBSsid[i],HEX); Serial.print(F(":")); }
         Serial.print(F(" EEPROM Ch:")); Serial.print(_M.WiFichannel); Serial.print(F(" -END\n"));
       #endif  //_LOGGME
     } // end of BSSID and Ch fetch
@@ -592,16 +1124,18 @@ ManageWifi   WifiNet::fetchCredFromEEPROM(TimePack _SysClock, ManageWifi M){
 }   // end of fetchCredFromEEPROM
   
 // **************************************************************************************** //
-  ManageWifi  WifiNet::UpdateWifiCredentials(TimePack _SysClock, ManageWifi M){
+  ManageWifi& WifiNet::UpdateWifiCredentials(TimePack _SysClock){
   /*
     * metod to store credentials in EEPROM by current credential status (avoid accessive rewrites)
     */
   //static const char Mname[] PROGMEM = "UpdateWifiCredentials:";
-  ManageWifi _M=M;
+  ManageWifi& _M = _LM;                 // works in place on the instance state
   switch  (_M.CredStat) {
     case  0:        // credentials not set at all
+      TxBegin();                                // both parts in one commit
       KeepCredentialsEEPROM( _SysClock,_M.Ssid,_M.Password );
       KeepChaBssidEEPROM( _SysClock,_M.WiFiBSsid,_M.WiFichannel );
+      TxCommit();
       break;
     case  1:        // complete missing credentials
       KeepChaBssidEEPROM( _SysClock,_M.WiFiBSsid,_M.WiFichannel );
@@ -621,8 +1155,17 @@ bool  WifiNet::ClearEEPROMwifiCredentials(TimePack _SysClock) {
     */
   static const char Mname[] PROGMEM = "ClearEEPROMwifiCredentials:";
   static const char L0[] PROGMEM = "Writing to EEPROM completed:";
+  TxBegin();
   for (uint8_t i = 0; i < SSIDlength+PASSlength+6+1+2; ++i) EEPROM.write(i, '?');
-  EEPROM.commit();
+  CommitRecord(RecCred);
+  #if CredSlots>1
+    for (uint8_t i = 0; i < CredSlots; ++i) { EEPROM.write(EEPROMslotsAddress+i*sizeof(CredSlot), '?'); CommitRecord(RecSlot+i); }
+  #endif  //CredSlots
+  #if _PMKCACHE==1
+    EEPROM.write(EEPROMpmkAddress, '?');
+    CommitRecord(RecPmk);
+  #endif  //_PMKCACHE
+  TxCommit();
   #if _LOGGME==1
     _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); 
     for (uint8_t i = 0; i < SSIDlength+PASSlength+1 ; ++i) { Serial.print(char(EEPROM.read(i))); }
@@ -651,33 +1194,34 @@ bool  WifiNet::KeepCredentialsEEPROM ( TimePack  _SysClock, char* id, char* psw
     *               '*' - all set
     */
   bool    returnFlag;
-  char*   pntr;
+  uint8_t rec[SSIDlength+PASSlength+1];         // record up to the BSSID, built in RAM and written where it differs
 
   // 0. check input
   if ( strlen(id) > 0 && strlen(psw) > 0) {
     #if _LOGGME==1
       _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(id); Serial.print(F(" Pass: ")); Serial.print(psw); Serial.print(F(" -END\n"));
     #endif //_LOGGME
-    for (uint8_t i = 0; i < SSIDlength+PASSlength+1; ++i) // clear EEPROM record
-      { EEPROM.write(i,0x00); }
+    memset(rec, 0x00, sizeof(rec));
     
     // 1. store ssid
-    pntr = id;
     #if _LOGGME==1
-      _RunUtil.InfoStamp(_SysClock,Mname,L1,1,0); Serial.print(pntr);
+      _RunUtil.InfoStamp(_SysClock,Mname,L1,1,0); Serial.print(id);
     #endif //_LOGGME
-    for (uint8_t i = 0; i < strlen(id); ++i) {EEPROM.write( i+1, *pntr++); } // end of writing SSID
+    memcpy(rec+1, id, strlen(id) < SSIDlength-1 ? strlen(id) : SSIDlength-1);
       
     // 2. store passowd
-    pntr = psw;
     #if _LOGGME==1
       Serial.print(F(" Pass: ")); Serial.print(psw);
     #endif  //_LOGGME
-    for (uint8_t i = 0; i <strlen(psw); ++i) {EEPROM.write( SSIDlength+i, *pntr++ );} // end of writing pw
+    memcpy(rec+SSIDlength, psw, strlen(psw) < PASSlength ? strlen(psw) : PASSlength);
     
-    // 3. indicate store completed
-    EEPROM.write( 0, '+' );
-    EEPROM.commit();
+    // 3. indicate store completed: a complete record of the same credentials keeps its BSSID and channel
+    const uint8_t*  old = EEPROM.getConstDataPtr();
+    rec[0] = ( EEPROM.length() >= sizeof(rec) && old[0]=='*' && memcmp(old+1, rec+1, sizeof(rec)-1)==0 ) ? '*' : '+';
+    if ( WriteChanged(0, rec, sizeof(rec)) ) CommitRecord(RecCred);
+    #if _PMKCACHE==1
+      _PmkDue = true;                           // derive the key once in loop(), not in the handler nor on every boot
+    #endif  //_PMKCACHE
     #if _LOGGME==1
       Serial.print(F(" -END\n"));
     #endif  //_LOGGME
@@ -710,30 +1254,28 @@ bool  WifiNet::KeepChaBssidEEPROM (TimePack _SysClock, uint8_t Bssid[], uint8_t
   static const char Mname[] PROGMEM = "KeepChaBssidEEPROM:";
   static const char L0[] PROGMEM = "writing EEPROM BSSID:";
   bool    returnFlag;
+  bool    changed;
+  uint8_t marker = '*';
   
   // 1. store Bssid
   #if _LOGGME==1
     _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); 
+    for (uint8_t i = 0; i < 6 ; ++i ) { Serial.print(Bssid[i],HEX);Serial.print(F(":")); }
   #endif //_LOGGME
-  for (uint8_t i = 0; i < 6 ; ++i ) {
-    EEPROM.write( SSIDlength+PASSlength+1+i, byte(Bssid[i]));
-    #if _LOGGME==1
-      Serial.print(Bssid[i],HEX);Serial.print(F(":"));
-    #endif  //_LOGGME
-  } // end of writing BSSID
+  changed = WriteChanged(SSIDlength+PASSlength+1, Bssid, 6);
     
   // 2. store channel
   #if LOGGME==1
     Serial.print(F(" Channel: "));
   #endif  //_LOGGME
-  EEPROM.write( SSIDlength+PASSlength+1+6+1 , byte(Channel) );
+  changed |= WriteChanged(SSIDlength+PASSlength+1+6+1, &Channel, 1);
   #if _LOGGME==1
     Serial.print(Channel);
   #endif  //_LOGGME
         
   // 3. indicate store completed
-  EEPROM.write( 0, '*' );
-  EEPROM.commit();
+  changed |= WriteChanged(0, &marker, 1);
+  if ( changed ) CommitRecord(RecCred);
   #if _LOGGME==1
     Serial.print(F(" -END\n"));
   #endif  //_LOGGME
@@ -744,13 +1286,15 @@ bool  WifiNet::KeepChaBssidEEPROM (TimePack _SysClock, uint8_t Bssid[], uint8_t
 }     // end of KeepChaBssidEEPROM
 
 // **************************************************************************************** //
-ManageWifi WifiNet::ServiceOTACred(AsyncWebServerRequest *request, TimePack _SysClock, ManageWifi M) {
+ManageWifi& WifiNet::ServiceOTACred(AsyncWebServerRequest *request, TimePack _SysClock) {
   /*
     * Async server handler to deal with credential inputs (called from <IoTWEBserver.on>)
     * if both SSID and password are set (<OTACredStat> should be 3):
     * - respond to client
     * - store the SSID and password
     * - set <M.activeTimeEvent> to 4, to reset the system by calling method
+    * with <_CMDQUEUE> the handler does not touch the instance state: the credentials are posted as <CmdStoreCred>,
+    * stored and the reset set by <ServiceCommands> in loop(); a full queue is answered by 503
     */
   static const char  Mname[] PROGMEM ="ServiceCred/setting:";  // setting of credenials (input)
   static const char L0[] PROGMEM = "Credentials received <";
@@ -759,23 +1303,38 @@ ManageWifi WifiNet::ServiceOTACred(AsyncWebServerRequest *request, TimePack _Sys
   static const char L3[] PROGMEM = "Input is incomplete.<br> Try again!";
   static const char E0[] PROGMEM = "Credential input is incomplete. OTACredStat=";
   static const char E1[] PROGMEM = "Program error. OTACredStat=";
-  ManageWifi _M = M;
+  ManageWifi& _M = _LM;                 // works in place on the instance state
   
   uint8_t OTACredStat=0;
   uint8_t option;
+  #if _CMDQUEUE==1
+    static const char L4[] PROGMEM = "Busy.<br> Try again!";
+    WifiNetCommand  C;                              // input goes to the command, not to the state
+    memset(&C, 0, sizeof(C));
+    char*   ssid = C.Ssid;
+    char*   pswd = C.Password;
+  #else
+    char*   ssid = _M.Ssid;
+    char*   pswd = _M.Password;
+  #endif  //_CMDQUEUE
+  #if CredSlots>1
+    uint8_t Priority;                               // slot priority (optional field)
+    int16_t Slot;                                   // slot to replace (optional field), -1 by SSID
+    Priority = NumberParam(request, PRIO_Phrase, SlotDefaultPriority, 0, 255);   // empty field keeps the default
+    Slot = NumberParam(request, SLOT_Phrase, -1, -1, CredSlots-1);
+  #endif  //CredSlots
 
   if (request->hasParam(SSID_Phrase)) {             // check for SSID field
-      request->getParam(SSID_Phrase)->value().toCharArray(_M.Ssid,SSIDlength);
-      if ( _M.Ssid[0] != 0x00 ) OTACredStat+=1;     // check for empty parameter
+      request->getParam(SSID_Phrase)->value().toCharArray(ssid,SSIDlength);
+      if ( ssid[0] != 0x00 ) OTACredStat+=1;        // check for empty parameter
   } // end SSID
   
   if (request->hasParam(PSWD_Phrase)) {             // check for pasword field
-      request->getParam(PSWD_Phrase)->value().toCharArray(_M.Password,PASSlength);;
-      if ( _M.Password[0] != 0x00 ) OTACredStat+=2; // check for empty parameter
+      request->getParam(PSWD_Phrase)->value().toCharArray(pswd,PASSlength);;
+      if ( pswd[0] != 0x00 ) OTACredStat+=2;        // check for empty parameter
   } // end password
 
   // respond to client
-  char* buf = new char[1000];                         // Temp buffer
   switch ( OTACredStat ) {
     case  0:                                          // no input at all
     case  1:                                          // only SSID
@@ -784,37 +1343,337 @@ ManageWifi WifiNet::ServiceOTACred(AsyncWebServerRequest *request, TimePack _Sys
         _RunUtil.InfoStamp(_SysClock,Mname,E0,1,0); Serial.print(OTACredStat); Serial.print(F(" -END\n"));
       #endif //_LOGGME
       option = 2;                                     // for feedback form
-      buf=SimpleUtilityPage(_SysClock,_M,buf,option,L2,L3,nullptr);
-      request->send(200,_TextHTML,buf);
+      SendUtilityPage(request,_SysClock,option,L2,L3);
       break;
     case  3:                                          // input complete
       #if _LOGGME==1
-        _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(_M.Ssid); Serial.print(F("> -<")); 
-        Serial.print(_M.Password); Serial.print(F("> (OTACredStat=")); Serial.print(OTACredStat); Serial.print(F(") -END\n"));
+        _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(ssid); Serial.print(F("> -<")); 
+        Serial.print(pswd); Serial.print(F("> (OTACredStat=")); Serial.print(OTACredStat); Serial.print(F(") -END\n"));
       #endif //_LOGGME
+      #if _CMDQUEUE==1                                // stored by <ServiceCommands>
+        C.Code = CmdStoreCred;
+        #if CredSlots>1
+          C.Priority = Priority;
+          C.Slot = Slot;
+        #endif  //CredSlots
+        if ( !PostCommand(C) ) {
+          SendUtilityPage(request,_SysClock,2,L2,L4,503);
+          break;
+        }
+      #else
                                                       // store credential in EEPROM
+      TxBegin();                                      // one commit, deferred out of the request <_DEFERCOMMIT>
       KeepCredentialsEEPROM( _SysClock,_M.Ssid,_M.Password );
-      _M = fetchCredFromEEPROM(_SysClock, _M);        // test read EEPROM
+      #if CredSlots>1
+        AddCredSlot( _SysClock,_M.Ssid,_M.Password,Priority,Slot );   // add or replace the network's slot
+      #endif  //CredSlots
+      TxCommit(true);
+      fetchCredFromEEPROM(_SysClock);                 // test read EEPROM
       _M.activeTimeEvent = 4;                         // set event to reset the platform
+      #endif  //_CMDQUEUE
       #if _LOGGME==1
         _RunUtil.InfoStamp(_SysClock,Mname,L1,1,1);
       #endif //_LOGGME
       option = 2;                                     // for feedback form
-      buf=SimpleUtilityPage(_SysClock,_M,buf,option,L2,L1,nullptr);
-      request->send(200,_TextHTML,buf);
+      SendUtilityPage(request,_SysClock,option,L2,L1);
       break;
     default:                                          // program error
       _RunUtil.InfoStamp(_SysClock,Mname,E1,1,0); Serial.print(OTACredStat); Serial.print(F(") -END\n"));
       break;
 
   }   // end of cred status switch  
-  delete [] buf;                                      // release buffer
 
     return  _M;
 }   // end of ServiceOTACred
 
 // **************************************************************************************** //
-char*  WifiNet::SimpleUtilityPage(TimePack _SysClock, ManageWifi M, char* buf, uint8_t option, 
+void  WifiNet::RegisterProvisioning(AsyncWebServer* Server, TimePack& SysClock, bool Root) {
+  /*
+    * method to register the provisioning handlers, each behind <Admit>:
+    * <ProvisionFormPath> (and '/' with <Root>) - credential form, <AssetForm> from flash with <_GZASSETS>
+    * <CredSettingTrigger>                     - <ServiceOTACred>
+    * with <_CAPTIVEDNS> the OS connectivity probe URLs - 302 to the form
+    * <SysClock> is the application's clock, read when a page is stamped
+    */
+  ArRequestHandlerFunction  Form = [this, &SysClock](AsyncWebServerRequest *request) {
+    if ( !Admit(request) ) return;
+    #if _GZASSETS==1
+      ServiceAsset(request, AssetForm);
+    #else
+      static const char Title[] PROGMEM = "Credential input form";
+      SendUtilityPage(request, SysClock, 3, Title, "");
+    #endif  //_GZASSETS
+  };
+  Server->on(ProvisionFormPath, HTTP_GET, Form);
+  if ( Root ) Server->on("/", HTTP_GET, Form);
+  Server->on(CredSettingTrigger, HTTP_GET, [this, &SysClock](AsyncWebServerRequest *request) {
+    if ( Admit(request) ) ServiceOTACred(request, SysClock); });
+  #if _CAPTIVEDNS==1                                // connectivity probes of the OS, resolved to us by <ServiceDNS>
+    static const char* const Probes[] = { "/generate_204", "/gen_204",          // Android
+                                          "/hotspot-detect.html", "/library/test/success.html",   // Apple
+                                          "/connecttest.txt", "/ncsi.txt", "/redirect",          // Windows
+                                          "/canonical.html", "/success.txt" };                  // Firefox
+    for ( const char* Probe : Probes )
+      Server->on(Probe, HTTP_GET, [this](AsyncWebServerRequest *request) {
+        if ( !Admit(request) ) return;
+        char  Url[40];                              // not the expected answer: the OS opens the form
+        IPText  AP;
+        AP = (uint32_t)WiFi.softAPIP();
+        snprintf_P(Url, sizeof(Url), PSTR("http://%s" ProvisionFormPath), AP.text().Txt);
+        request->redirect(Url); });
+  #endif  //_CAPTIVEDNS
+}   // end of RegisterProvisioning
+
+#if _CMDQUEUE==1
+  // **************************************************************************************** //
+  bool  WifiNet::PostCommand(uint8_t Code) {
+    /*
+      * method for a web handler to post command <Code> (<Codes4Command>) without arguments
+      * returns  0 queue full (<CommandQueueLen>), the command is dropped
+      */
+    WifiNetCommand  C;
+    memset(&C, 0, sizeof(C));
+    C.Code = Code;
+    return  _Commands.post(C);
+  }   // end of PostCommand
+
+  bool  WifiNet::PostCommand(const WifiNetCommand& C) {
+    return  _Commands.post(C);
+  }   // end of PostCommand
+
+  // **************************************************************************************** //
+  uint8_t  WifiNet::ServiceCommands(TimePack _SysClock) {
+    /*
+      * method to run the commands posted by web handlers, to be called from loop(): the only place they change
+      * the instance state, so a handler never races the connection logic
+      * returns  number of commands run
+      */
+    static const char Mname[] PROGMEM = "ServiceCommands:";
+    static const char E0[] PROGMEM = "Unknown command ";
+    WifiNetCommand  C;
+    uint8_t   n=0;
+    while ( _Commands.take(C) ) {
+      n++;
+      switch ( C.Code ) {
+        case  CmdStoreCred:                         // credentials of <ServiceOTACred>
+          strncpy(_LM.Ssid, C.Ssid, SSIDlength);
+          strncpy(_LM.Password, C.Password, PASSlength);
+          TxBegin();                                // one commit for both records
+          KeepCredentialsEEPROM(_SysClock, _LM.Ssid, _LM.Password);
+          #if CredSlots>1
+            AddCredSlot(_SysClock, _LM.Ssid, _LM.Password, C.Priority, C.Slot);
+          #endif  //CredSlots
+          TxCommit(true);
+          fetchCredFromEEPROM(_SysClock);           // test read EEPROM
+          _LM.activeTimeEvent = 4;                  // set event to reset the platform
+          break;
+        case  CmdReset:
+          _LM.activeTimeEvent = 4;
+          break;
+        case  CmdErase:
+          ClearEEPROMwifiCredentials(_SysClock);
+          break;
+        case  CmdRescan:
+          startWiFi(_SysClock);
+          break;
+        default:
+          _RunUtil.InfoStamp(_SysClock,Mname,E0,1,0); Serial.print(C.Code); Serial.print(F(" -END\n"));
+          break;
+      }   // end of command switch
+    }   // end of queue
+    return  n;
+  }   // end of ServiceCommands
+#endif  //_CMDQUEUE
+
+#if _WIFINTPON==1 && _SNTPCLIENT==1
+  // **************************************************************************************** //
+  bool  WifiNet::StartNTP(NTPdoneCB Done, const char* const Servers[], uint8_t Count) {
+    /*
+      * method to start the SNTP rounds (<WifiNetSntp>) of <Count> <Servers>, <NTPservers> by default;
+      * <Done> is called at the end of every round. the rounds run by <ServiceNTP> in loop()
+      * returns  0 no socket
+      */
+    static const char* const Default[] = { NTPservers };
+    _NtpDone = Done;
+    if ( !Servers ) {
+      Servers = Default;
+      Count = sizeof(Default)/sizeof(Default[0]);
+    }
+    return  _Sntp.begin(Servers, Count);
+  }   // end of StartNTP
+
+  // **************************************************************************************** //
+  uint8_t  WifiNet::ServiceNTP() {
+    /*
+      * method to run the SNTP client, to be called from loop(), it never waits: a synced round sets the
+      * system clock and the <PhNTPsync> mark, then <Done> of <StartNTP> gets the result of a completed round
+      * returns  <Codes4Sntp>
+      */
+    #if _LOGGME==1
+      static const char Mname[] PROGMEM = "ServiceNTP:";
+      static const char E0[] PROGMEM = "SNTP round failed, ";
+    #endif  //_LOGGME
+    uint32_t  now = millis();
+    uint8_t   r = _Sntp.service(now);
+    #if _LOGGME==1
+      if ( r == SntpFailed ) {
+        _RunUtil.InfoStamp(_SysClock,Mname,E0,1,0); Serial.print(_Sntp.Failed); Serial.print(F(" failed rounds, "));
+        Serial.print(_Sntp.KissOfDeath); Serial.print(F(" kiss of death -END\n"));
+      }
+    #endif  //_LOGGME
+    if ( r == SntpSynced ) {
+      int64_t ms = _Sntp.nowMs(now);
+      timeval tv = { (time_t)(ms/1000), (long)(ms%1000)*1000 };
+      settimeofday(&tv, nullptr);
+      MarkPhase(PhNTPsync);
+      _Stats.NTPsyncTime = now;
+    }
+    if ( r != SntpIdle && _NtpDone ) _NtpDone(r == SntpSynced, _Sntp.now(now), _Sntp.Delay);
+    return  r;
+  }   // end of ServiceNTP
+
+  WifiNetSntp&  WifiNet::Sntp() {
+    return  _Sntp;
+  }   // end of Sntp
+#endif  //_SNTPCLIENT
+
+#if _CAPTIVEDNS==1
+  // **************************************************************************************** //
+  uint8_t  WifiNet::ServiceDNS() {
+    /*
+      * method to answer the captive portal DNS queries (<WifiNetDns>), to be called from loop(); answers only
+      * while the soft AP waits for credentials and stops the responder once the status leaves those states
+      * returns  number of queries answered
+      */
+    if ( _LM.WiFiStatus != Configure_OTA && _LM.WiFiStatus != Client_Connect_OTA ) {
+      _Dns.stop();
+      return  0;
+    }
+    return  _Dns.service();
+  }   // end of ServiceDNS
+
+  WifiNetDns&  WifiNet::Dns() {
+    return  _Dns;
+  }   // end of Dns
+#endif  //_CAPTIVEDNS
+
+// **************************************************************************************** //
+static void UtilityPage(WifiNetPage& P, const WifiNetTemplate& T, TimePack _SysClock, const ManageWifi& M,
+                        const char* PageTitleName, const char* FeedBack){
+  /*
+    * set the values of the utility page of template <T> in <P>
+    * the time stamp, SSID / password, title and feedback (those the template uses) are copied to <P>;
+    * the rest is referred to: instance state and library constants, which outlive the page
+    */
+  char  stamp[16];
+  memset(stamp, 0, sizeof(stamp));
+  _RunUtil.TimestampToString(_SysClock,stamp);         // get current time
+  P.begin(T);
+  P.keep(SlotStamp, stamp);
+  P.set(SlotWhoAmI, M.WhoAmI);                          // platform name
+  P.set(SlotVersion, M.Version);                        // version
+  P.set(SlotAction, CredSettingTrigger+1);              // 'action' field (without '/')
+  P.set(SlotSsidName, SSID_Phrase);                     // input field names
+  P.set(SlotPswdName, PSWD_Phrase);
+  P.set(SlotPrioName, PRIO_Phrase);
+  if ( P.uses(SlotSsid) ) P.keep(SlotSsid, M.Ssid);     // credential input acknowledge
+  if ( P.uses(SlotPass) ) P.keep(SlotPass, M.Password);
+  if ( P.uses(SlotTitle) ) P.keep(SlotTitle, PageTitleName);        // page title name
+  if ( P.uses(SlotFeedBack) ) P.keep(SlotFeedBack, FeedBack);       // message from application
+}     // end of UtilityPage
+
+// **************************************************************************************** //
+bool  WifiNet::RegisterPage(uint8_t option, const WifiNetTemplate& Page){
+  /*
+    * method to set the template of utility page <option> (see <SimpleUtilityPage>): the application adds pages
+    * beyond the library ones (5 < <option> < <PageOptions>) or replaces them. Declared by <WifiNetPageDef>
+    * returns  0 <option> out of range
+    */
+  if ( option >= PageOptions ) return  false;
+  _Pages[option] = &Page;
+  return  true;
+}     // end of RegisterPage
+
+#if _GZASSETS==1
+// **************************************************************************************** //
+bool  WifiNet::RegisterAssets(AsyncWebServer* Server){
+  /*
+    * method to register the handlers of the constant assets (style sheet <AssetCssPath>, credential form
+    * <AssetFormPath>) built by extras/tools/gzassets.py. The form is left out when its action or field names
+    * differ from WifiNetConfig.h (tool not run after a change)
+    * returns  0 credential form not registered
+    */
+  #if _LOGGME==1
+    static const char Mname[] PROGMEM = "RegisterAssets:";
+    static const char E0[] PROGMEM = "credential form asset does not match WifiNetConfig.h, run gzassets.py";
+  #endif  //_LOGGME
+  Server->on(AssetCss.Path, HTTP_GET, [this](AsyncWebServerRequest *request) { if ( Admit(request) ) ServiceAsset(request, AssetCss); });
+  bool  match = !strcmp(CredSettingTrigger+1, AssetFormAction) && !strcmp(SSID_Phrase, AssetFormSsid) &&
+                !strcmp(PSWD_Phrase, AssetFormPass) && (CredSlots<=1 || !strcmp(PRIO_Phrase, AssetFormPrio));
+  if ( !match ) {
+    #if _LOGGME==1
+      _RunUtil.InfoStamp(_SysClock,Mname,E0,1,1);
+    #endif  //_LOGGME
+    return  false;
+  }
+  Server->on(AssetForm.Path, HTTP_GET, [this](AsyncWebServerRequest *request) { if ( Admit(request) ) ServiceAsset(request, AssetForm); });
+  return  true;
+}     // end of RegisterAssets
+
+// **************************************************************************************** //
+void  WifiNet::ServiceAsset(AsyncWebServerRequest *request, const WifiNetAsset& Asset){
+  /*
+    * Async server handler of a constant asset: 304 when the client holds the same content (If-None-Match
+    * carries the ETag), otherwise the blob is sent from flash as is (gzip compressed, no copy, no rendering)
+    * Cache-Control no-cache: the client asks every time, a firmware with other content answers 200
+    */
+  auto  match = request->hasHeader(F("If-None-Match")) ? request->getHeader(F("If-None-Match")) : nullptr;
+  AsyncWebServerResponse* response;
+  if ( match && (strstr(match->value().c_str(), Asset.ETag) || !strcmp(match->value().c_str(), "*")) ) {
+    response = request->beginResponse(304);
+  } else {
+    response = request->beginResponse_P(200, Asset.Type, Asset.Data, Asset.Len);
+    if ( Asset.Gzip ) response->addHeader(F("Content-Encoding"), F("gzip"));
+  }
+  response->addHeader(F("ETag"), Asset.ETag);
+  response->addHeader(F("Cache-Control"), F("no-cache"));
+  request->send(response);
+}     // end of ServiceAsset
+#endif  //_GZASSETS
+
+// **************************************************************************************** //
+size_t  WifiNet::SendUtilityPage(AsyncWebServerRequest *request, TimePack _SysClock, uint8_t option, 
+                        const char* PageTitleName, const char* FeedBack, int Code,
+                        const char* const AppValues[], uint8_t AppCount){
+  /*
+    * method to answer <request> by the utility page of <option> (see <SimpleUtilityPage>), streamed as a chunked
+    * response straight from the template: no page buffer, the page context lives in a slab of <Pool> until the
+    * request is gone (no heap block per request); with the pool exhausted the request gets 503
+    * <PageTitleName>, <FeedBack> and <AppValues> (fill <TplApp0>..) are copied into the page context (RAM or PROGMEM),
+    * cut to the room left in <PageOwnLen>; they may go away once the method returns
+    * returns the page length[bytes], 0 refused
+    */
+  static_assert(sizeof(WifiNetPage) <= PoolSlabSize, "<PoolSlabSize> too small for <WifiNetPage>");
+  void*   slab = _Pool.borrow(request);
+  if ( !slab ) {
+    _Pool.refuse(request);
+    return  0;
+  }
+  WifiNetPage* P = new (slab) WifiNetPage;
+  UtilityPage(*P, option<PageOptions ? *_Pages[option] : PageEmpty, _SysClock, _LM, PageTitleName, FeedBack);
+  for ( uint8_t i=0; i<AppCount && i<PageAppSlots; i++ ) P->keep(SlotApp+i, AppValues[i]);
+  size_t  len = P->length();
+  AsyncWebServerResponse* response = request->beginChunkedResponse(_TextHTML,
+    [P](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+      if ( index==0 && P->sent() ) P->rewind();         // restart (not expected)
+      return  P->render(buf, maxLen); });
+  response->setCode(Code);
+  request->send(response);
+  return  len;
+}     // end of SendUtilityPage
+
+// **************************************************************************************** //
+char*  WifiNet::SimpleUtilityPage(TimePack _SysClock, const ManageWifi& M, char* buf, uint8_t option, 
                         const char* PageTitleName, const char* FeedBack, const char* insert_action){
   /*
     * method to create htmp page to be used in a simple applications, set by <option>
@@ -824,6 +1683,7 @@ char*  WifiNet::SimpleUtilityPage(TimePack _SysClock, ManageWifi M, char* buf, u
     *           - 3 Credentials input form
     *           - 4 Credential input acknowledge
     *           - 5 TBD
+    *           - 6.. pages of the application <RegisterPage>
     *
     * format:
     * line 0:     whoamI+version+00:00:00   (current time)
@@ -834,95 +1694,26 @@ char*  WifiNet::SimpleUtilityPage(TimePack _SysClock, ManageWifi M, char* buf, u
     *                 <insert_action> defines the action (without /)
     *                 <SSID_Phrase> <PSWD_Phrase> define the field names for the input
     *                 http://192.168.4.1/setting?SSID=Sachi&Pass=Kalisher46apt7 (eg. setting, SSID, Pass)
+    * the page is written whole to <buf> (no length check); web handlers should use <SendUtilityPage> instead
     */
-  // color picker https://htmlcolorcodes.com/color-picker/
   //static const char Mname[] PROGMEM = "CreateCredForm:";
-  static const char S_Title[] PROGMEM = "<html><head><title>ESP8266 Utilities</title>";
-  static const char S_Style[] PROGMEM = "<style>body {background-color: #9DCDF4; font-family: Arial, Helvetica, Sans-Serif; Color: blue;}</style></head>\n"; //#E6E6FA #33A4FF
-  static const char Body_H[]  PROGMEM = "<body>";
-  static const char Body_E[]  PROGMEM = "</body></html>";
-  static const char S_H1[]    PROGMEM = "<h1>";
-  static const char S_H1E[]   PROGMEM = "</h1>";
-  static const char S_H2[]    PROGMEM = "<h2>";
-  static const char S_H2E[]   PROGMEM = "</h2>";
-  static const char S_Form[]  PROGMEM = "<form method='get' action='";
-  static const char S_Form1[] PROGMEM = "'>&nbsp;&nbsp;&nbsp;&nbsp;Network SSID:<input type='text' name='";
-  static const char S_Form2[] PROGMEM = "'><BR><BR>Network password:<input type='text' name='";
-  static const char S_Form3[] PROGMEM = "'>&nbsp;<input type='submit' value='Enter'></form>";
-  static const char Msg1[]    PROGMEM = "<h1>SSID and code obtaine are:</h1>";
-  static const char Msg2[]    PROGMEM = "<h1>System is about to boot. Bye bye</h1>";
-
-  char*  actionWOslash;
-  char* action = new char[15];                          // Temp buffer to hold action and time stamp
-  
-  strcpy_P(buf,S_Title);                                // title and style
-  strcat_P(buf,S_Style);
-  strcat_P(buf,Body_H);                                 // body
-
-  strcat_P(buf,S_H2);                                   // Line 0 
-  strcat  (buf,M.WhoAmI);                               // platform name
-  strcat_P(buf,_G3);                                    // ' '
-  strcat  (buf,M.Version);                              // version
-  strcat_P(buf,_G3);
-  strcat  (buf,_RunUtil.TimestampToString(_SysClock,action));// get current time
-  strcat_P(buf,S_H2E);
-
-  strcat_P(buf,S_H1);                                   // Line 1 
-  strcat_P(buf,PageTitleName);                          // page title name
-  strcat_P(buf,S_H1E);
-
-  strcpy (action,CredSettingTrigger);
-  actionWOslash=action+1;                               // temp hold action w/o'/'
-
-  switch ( option ) {                                   // line 2
-    case  0:                                            // default root
-    case  1:                                            // error 404
-    case  2:                                            // message from application
-      strcat_P(buf,S_H1);
-      strcat_P(buf,FeedBack);                           // message from application
-      strcat_P(buf,S_H1E);
-      break;
-    case  3:                                            // credential input form
-      strcat_P(buf,S_Form);
-      strcat_P(buf,actionWOslash);                      // insert 'action' field
-      strcat_P(buf,S_Form1);
-      strcat_P(buf,SSID_Phrase);                        // insert SSID field name
-      strcat_P(buf,S_Form2);
-      strcat_P(buf,PSWD_Phrase);                        // insert pasword field name
-      strcat_P(buf,S_Form3);
-      break;
-    case  4:                                            // credential input acknowledge
-      strcat_P(buf,Msg1);                               // SSID and PW header
-      strcat_P(buf,S_H1);
-      strcat  (buf,M.Ssid);                             // print SSID
-      strcat_P(buf,_G3);
-      strcat  (buf,M.Password);                         // print passcode
-      strcat_P(buf,S_H1E);
-      strcat_P(buf,Msg2);                               // bye bye
-      break;
-    case  5:                                            // do nothing
-    default:
-      break;
-  }
-  strcat_P(buf,Body_E);
+  WifiNetPage P;
+  UtilityPage(P, option<PageOptions ? *_Pages[option] : PageEmpty, _SysClock, M, PageTitleName, FeedBack);
+  buf[P.render((uint8_t*)buf, (size_t)-1 >> 1)] = 0x00;
   #if _DEBUGON==250
     _RunUtil.InfoStamp(_SysClock,insert_action,nullptr,0,0); Serial.print(buf); Serial.print(F(" - END\n"));
   #endif //_DEBUGON
-      
-  delete [] action;                                     // release buffer
   return  buf;
 }     // end of SimpleUtilityPage
 
 // **************************************************************************************** //
-bool  WifiNet::storeIPaddress(TimePack _SysClock, char* IPstring, uint16_t EEPaddress){
+bool  WifiNet::storeIPaddress(TimePack _SysClock, const char* IPstring, uint16_t EEPaddress){
   /*
    * method to store IP address <IPstring> (up to 15 chars) at EEPROM starting address <EEPaddress>
    * returns  0 for write error or wrong input length
    *          1 stored OK
    */
   static const char Mname[] PROGMEM = "storeIPaddress:";
-  uint16_t  Address = EEPaddress;
-  char*     pntr = IPstring;
   if ( strlen(IPstring)>15 ) {                  // error, input too long
     #ifdef _LOGGME
       _RunUtil.InfoStamp(_SysClock,Mname,_G7,1,0); Serial.print(F("IP string too long="));
@@ -931,10 +1722,9 @@ bool  WifiNet::storeIPaddress(TimePack _SysClock, char* IPstring, uint16_t EEPad
     return  false;
   }   // end of length check
   
-  for ( uint8_t ii=0; ii<strlen(IPstring); ii++ ) EEPROM.write(Address++, *pntr++);
-  EEPROM.write(Address, 0x00);      // termination
+  if ( !WriteChanged(EEPaddress, IPstring, strlen(IPstring)+1) ) return  true;   // same string, with termination
 
-  if ( EEPROM.commit() ) {          // write OK
+  if ( EEPaddress==EEPROMipAddress ? CommitRecord(RecIP) : EEPROMcommit() ) {   // write OK
     return  true;
   } else {                          // write bad
     #ifdef _LOGGME
@@ -952,21 +1742,13 @@ char*  WifiNet::fetchIPaddress(char* buff, uint16_t EEPaddress){
    * returns a pointer to the IP string. For error returns null string
    */
   //static const char Mname[] PROGMEM = "fetchIPaddress:";
-  uint16_t  Address = EEPaddress;
-  char*     pbuf = buff;
-
-  for ( uint8_t ii=0; ii<15; ii++ ) {
-    *pbuf = EEPROM.read(Address++);
-    if ( *pbuf == 0x00 ) break;         // end of string
-    pbuf++;
-    *pbuf = 0x00;                       // last char NULL
-  }     // end of loop
-
-    return  buff;
+  if ( EEPaddress+16u > EEPROM.length() ) { buff[0] = 0x00; return  buff; }   // outside the image
+  CopyString(buff, EEPROM.getConstDataPtr()+EEPaddress, 15);
+  return  buff;
 }     // end of fetchIPaddress
 
 // **************************************************************************************** //
-bool    WifiNet::CompareAndKeepIP (TimePack _SysClock,ManageWifi M) {
+bool    WifiNet::CompareAndKeepIP (TimePack _SysClock, const ManageWifi& M) {
   /*
    * method to compare EEPROM kept IP address to current network IP address.
    * if equal     - returns   0
@@ -982,15 +1764,16 @@ bool    WifiNet::CompareAndKeepIP (TimePack _SysClock,ManageWifi M) {
   bool  comp;
   
   fetchIPaddress(buf,EEPROMipAddress);                            // fetch IP from EEPROM
-  comp = strcmp(buf,M.DeviceIP);                            // compare to current
+  IPChars  ip = M.DeviceIP.text();
+  comp = strcmp(buf,ip);                                          // compare to current
   #if _DEBUGON==1
-    _RunUtil.InfoStamp(_SysClock,Mname,L0,0,0); Serial.print(buf); Serial.print(F(" network IP:")); Serial.print(M.DeviceIP); 
+    _RunUtil.InfoStamp(_SysClock,Mname,L0,0,0); Serial.print(buf); Serial.print(F(" network IP:")); Serial.print(ip); 
     if ( comp )   Serial.print(F(" addresses are different."));
     else          Serial.print(F(" addresses are the same."));
     Serial.print(F(" -END\n"));
   #endif //_DEBUGON
   if ( comp ) {                                                   // keep the new address
-    storeIPaddress(_SysClock, M.DeviceIP, EEPROMipAddress);
+    storeIPaddress(_SysClock, ip, EEPROMipAddress);
     return    true;                                               // alert for change
   } else {
     return    false;                                              // all OK
@@ -998,17 +1781,17 @@ bool    WifiNet::CompareAndKeepIP (TimePack _SysClock,ManageWifi M) {
 }     // end of CompareAndKeepIP
 
 // **************************************************************************************** //
-bool    WifiNet::IsItNewIPaddress (ManageWifi M) {
+bool    WifiNet::IsItNewIPaddress () {
   /*
-   * method to compare current local IP to previous
+   * method to compare current local IP to previous (instance state)
    * returns  true  new IP
    *          false same IP or not connected
    * 
    */
   if ( WiFi.status() == WL_CONNECTED ) {
-    if ( M.previousIP == WiFi.localIP() ) return  false;    // same IP
+    if ( _LM.previousIP == WiFi.localIP() ) return  false;  // same IP
     else {                                                  // for new IP
-      M.previousIP = WiFi.localIP();                        // keep
+      _LM.previousIP = WiFi.localIP();                      // keep
       return  true;
     }            
   } else  return  false;                                    // Wifi not connected
@@ -1022,6 +1805,1016 @@ const   char* WifiNet::getVersion() {
     return  WifiNetVersion;
 }   // end of getVersion
 
+#if CredSlots>1
+  // **************************************************************************************** //
+  bool  WifiNet::fetchCredSlot(uint8_t Slot, CredSlot* S) {
+    /*
+     * method to fetch credential slot <Slot> from EEPROM to <S>
+     * returns  1 slot is set
+     *          0 slot is free (or out of range)
+     */
+    if ( Slot >= CredSlots ) return  false;
+    EEPROM.get(EEPROMslotsAddress+Slot*sizeof(CredSlot), *S);
+    S->Ssid[SSIDlength] = 0x00;                   // terminate strings of unset slots
+    S->Password[PASSlength] = 0x00;
+    return  S->Marker == '*';
+  }     // end of fetchCredSlot
+  
+  // **************************************************************************************** //
+  bool  WifiNet::KeepCredSlot(TimePack _SysClock, uint8_t Slot, CredSlot* S) {
+    /*
+     * method to store <S> in credential slot <Slot>
+     * returns  1 stored OK
+     *          0 out of range or write error
+     */
+    static const char Mname[] PROGMEM = "KeepCredSlot:";
+    if ( Slot >= CredSlots ) return  false;
+    S->Marker = '*';
+    EEPROM.put(EEPROMslotsAddress+Slot*sizeof(CredSlot), *S);
+    if ( CommitRecord(RecSlot+Slot) ) {          // write OK
+      #if _LOGGME==1
+        _RunUtil.InfoStamp(_SysClock,Mname,nullptr,1,0); Serial.print(F("slot ")); Serial.print(Slot); Serial.print(F(" SSID:")); 
+        Serial.print(S->Ssid); Serial.print(F(" priority ")); Serial.print(S->Priority); Serial.print(F(" -END\n"));
+      #endif  //_LOGGME
+      return  true;
+    } else {                          // write bad
+      #ifdef _LOGGME
+        _RunUtil.InfoStamp(_SysClock,Mname,_G7,1,0); Serial.print(F("slot could not be written to EEPROM - END\n"));
+      #endif //_LOGGME
+      return  false;
+    } // end of commit
+  }     // end of KeepCredSlot
+  
+  // **************************************************************************************** //
+  uint8_t WifiNet::FindCredSlot(const char* Ssid) {
+    /*
+     * method to find the slot for network <Ssid>:
+     * the slot already holding <Ssid>, else the 1st free slot, else the slot of lowest priority (least recent of equals)
+     */
+    CredSlot  S;
+    uint8_t   victim=0, victimPrio=255;
+    uint32_t  victimLast=0xFFFFFFFF;
+    int16_t   freeSlot=-1;
+    for ( uint8_t i=0; i<CredSlots; i++ ) {
+      if ( !fetchCredSlot(i,&S) ) { 
+        if ( freeSlot<0 ) freeSlot = i; 
+        continue; 
+      }
+      if ( strcmp(S.Ssid,Ssid)==0 ) return  i;    // same network
+      if ( S.Priority < victimPrio || ( S.Priority==victimPrio && S.LastSuccess < victimLast ) ) {
+        victim = i;
+        victimPrio = S.Priority;
+        victimLast = S.LastSuccess;
+      }
+    } // end of slot loop
+    return  ( freeSlot>=0 ) ? freeSlot : victim;
+  }     // end of FindCredSlot
+  
+  // **************************************************************************************** //
+  bool  WifiNet::AddCredSlot(TimePack _SysClock, const char* Ssid, const char* Psw, uint8_t Priority, int16_t Slot) {
+    /*
+     * method to add network <Ssid>/<Psw> with <Priority>, or replace its slot
+     * <Slot> -1 selects the slot by <FindCredSlot>, otherwise the given slot is replaced
+     * cached AP and recency are kept when the same network is updated
+     */
+    CredSlot  S;
+    uint8_t   target = ( Slot<0 ) ? FindCredSlot(Ssid) : Slot;
+    if ( strlen(Ssid)==0 || strlen(Ssid)>SSIDlength || strlen(Psw)>PASSlength ) return  false;
+    if ( !fetchCredSlot(target,&S) || strcmp(S.Ssid,Ssid)!=0 ) {   // new network in slot
+      memset(&S, 0, sizeof(S));
+    }
+    strcpy(S.Ssid,Ssid);
+    strcpy(S.Password,Psw);
+    S.Priority = Priority;
+    return  KeepCredSlot(_SysClock,target,&S);
+  }     // end of AddCredSlot
+  
+  // **************************************************************************************** //
+  bool  WifiNet::UpdateCredSlot(TimePack _SysClock, const ManageWifi& M) {
+    /*
+     * method to update the slot of the connected network <M.Ssid>: cached BSSID, channel and recency
+     * the network is added if it has no slot and a free slot exists
+     * EEPROM is written only if something changed
+     */
+    CredSlot  S;
+    uint32_t  maxLast=0;
+    int16_t   freeSlot=-1, own=-1;
+    for ( uint8_t i=0; i<CredSlots; i++ ) {
+      if ( !fetchCredSlot(i,&S) ) {
+        if ( freeSlot<0 ) freeSlot = i;
+        continue;
+      }
+      if ( S.LastSuccess > maxLast ) maxLast = S.LastSuccess;
+      if ( strcmp(S.Ssid,M.Ssid)==0 ) own = i;
+    } // end of slot loop
+    if ( own<0 ) {                                // unknown network
+      if ( freeSlot<0 ) return  false;            // don't evict configured networks
+      memset(&S, 0, sizeof(S));
+      strcpy(S.Ssid,M.Ssid);
+      strcpy(S.Password,M.Password);
+      S.Priority = SlotDefaultPriority;
+      own = freeSlot;
+    } else {
+      fetchCredSlot(own,&S);
+      if ( S.LastSuccess==maxLast && maxLast!=0 && S.Channel==M.WiFichannel && 
+           memcmp(S.Bssid,M.WiFiBSsid,6)==0 ) return  true;    // nothing changed
+    } // end of slot check
+    if ( S.LastSuccess!=maxLast || maxLast==0 ) S.LastSuccess = maxLast+1;
+    S.Channel = M.WiFichannel;
+    memcpy(S.Bssid,M.WiFiBSsid,6);
+    return  KeepCredSlot(_SysClock,own,&S);
+  }     // end of UpdateCredSlot
+  
+  // **************************************************************************************** //
+  ManageWifi& WifiNet::SelectCredSlot(TimePack _SysClock) {
+    /*
+     * method to select the network to connect to out of the credential slots
+     * - one slot set:    use it with its cached BSSID and channel, no scan
+     * - more slots set:  one scan, visible networks (RSSI >= <SlotMinRSSI>) are ranked by priority, then RSSI, then recency
+     * the selected network is loaded to <M>, <M.CredStat> is set against the EEPROM credentials record so
+     * <UpdateWifiCredentials> keeps the network actually connected to
+     * <M> is returned unchanged if no slot is set or no slot's network is visible
+     */
+    static const char Mname[] PROGMEM = "SelectCredSlot:";
+    CredSlot  S;
+    int16_t   best=-1;
+    uint8_t   nSet=0, bestPrio=0, bestCh=0;
+    uint8_t   bestBssid[6];
+    int32_t   bestRSSI=-127;
+    uint32_t  bestLast=0;
+    ManageWifi& _M = _LM;                 // works in place on the instance state
+  
+    for ( uint8_t i=0; i<CredSlots; i++ ) if ( fetchCredSlot(i,&S) ) { nSet++; best=i; }
+    if ( nSet==0 ) return  _M;                    // slots not in use
+    if ( nSet==1 ) {                              // single network, no need to scan
+      fetchCredSlot(best,&S);
+      bestCh = S.Channel;
+      memcpy(bestBssid,S.Bssid,6);
+    } else {                                      // rank out of a single scan
+      int8_t  nAP = WiFi.scanNetworks(false,false);
+      best = -1;
+      for ( uint8_t i=0; i<CredSlots; i++ ) {
+        if ( !fetchCredSlot(i,&S) ) continue;
+        for ( int8_t j=0; j<nAP; j++ ) {
+          int32_t rssi = WiFi.RSSI(j);
+          if ( rssi < SlotMinRSSI || strcmp(WiFi.SSID(j).c_str(),S.Ssid)!=0 ) continue;
+          if ( best<0 || S.Priority>bestPrio || ( S.Priority==bestPrio && 
+               ( rssi>bestRSSI || ( rssi==bestRSSI && S.LastSuccess>bestLast ) ) ) ) {
+            best = i;
+            bestPrio = S.Priority;
+            bestRSSI = rssi;
+            bestLast = S.LastSuccess;
+            bestCh = WiFi.channel(j);
+            memcpy(bestBssid,WiFi.BSSID(j),6);
+          }
+        } // end of scan results loop
+      } // end of slot loop
+      WiFi.scanDelete();
+      #if _LOGGME==1
+        _RunUtil.InfoStamp(_SysClock,Mname,nullptr,1,0); Serial.print(nAP); Serial.print(F(" APs, selected slot ")); 
+        Serial.print(best); Serial.print(F(" RSSI ")); Serial.print(bestRSSI); Serial.print(F(" -END\n"));
+      #endif  //_LOGGME
+      if ( best<0 ) return  _M;                   // no known network visible
+      fetchCredSlot(best,&S);
+    } // end of selection
+  
+    if ( _M.CredStat==0 || strcmp(S.Ssid,_M.Ssid)!=0 || strcmp(S.Password,_M.Password)!=0 ) {
+      _M.CredStat = 0;                            // other network than the EEPROM record: rewrite it on connection
+      _M.WiFichannel = 0;
+    } else if ( _M.CredStat==2 && bestCh!=0 && ( bestCh!=_M.WiFichannel || memcmp(bestBssid,_M.WiFiBSsid,6)!=0 ) ) {
+      _M.CredStat = 1;                            // same network, other AP: rewrite BSSID and channel
+    }
+    strcpy(_M.Ssid,S.Ssid);
+    strcpy(_M.Password,S.Password);
+    if ( bestCh ) {                               // AP known
+      _M.WiFichannel = bestCh;
+      memcpy(_M.WiFiBSsid,bestBssid,6);
+    }
+    return  _M;
+  }     // end of SelectCredSlot
+#endif  //CredSlots
+
+#if _LEASECACHE==1
+  // **************************************************************************************** //
+  bool  WifiNet::storeLease(TimePack _SysClock, uint8_t Bssid[]) {
+    /*
+     * method to keep the current DHCP lease (IP, gateway, mask, DNS, expiry, BSSID) at <EEPROMleaseAddress>, granted
+     * at <_LeaseGrantMs>. the record is not rewritten if the lease is the same and more than half of it is left.
+     * while the clock is not set the expiry can't be dated: the old record is dropped and <ServiceEEPROM> calls
+     * again once the clock is set (<LeaseToKeep>)
+     * returns  0 for write error
+     *          1 stored OK (or no need to store)
+     */
+    static const char Mname[] PROGMEM = "storeLease:";
+    LeaseRecord L, Old;
+    uint32_t    leaseTime = OfferedLease();
+    time_t      now = time(nullptr);
+  
+    _LeaseEndMs = _LeaseGrantMs + leaseTime*1000UL;
+    if ( now <= EpochValid ) {        // no date for the expiry, a record kept now could not be reused
+      _LeaseState = LeaseToKeep;
+      return  ClearLease(_SysClock);
+    }
+    _LeaseState = LeaseNone;
+    memset(&L, 0, sizeof(L));
+    L.Marker  = '#';
+    memcpy(L.Bssid, Bssid, 6);
+    L.IP      = WiFi.localIP();
+    L.Gateway = WiFi.gatewayIP();
+    L.Mask    = WiFi.subnetMask();
+    L.Dns     = WiFi.dnsIP(0);
+    L.Expiry  = now - (millis()-_LeaseGrantMs)/1000 + leaseTime;
+    if ( fetchLease(&Old) && memcmp(Old.Bssid, L.Bssid, offsetof(LeaseRecord,Expiry)-offsetof(LeaseRecord,Bssid))==0 &&
+         Old.Expiry > (uint32_t)now+leaseTime/2 ) return  true;   // same lease, avoid EEPROM wear
+    L.Crc = crc8((uint8_t*)&L, sizeof(L));
+    EEPROM.put(EEPROMleaseAddress, L);
+    if ( CommitRecord(RecLease) ) {          // write OK
+      return  true;
+    } else {                          // write bad
+      #ifdef _LOGGME
+        _RunUtil.InfoStamp(_SysClock,Mname,_G7,1,0); Serial.print(F("lease could not be written to EEPROM - END\n"));
+      #endif //_LOGGME
+      return  false;
+    } // end of commit
+  }     // end of storeLease
+  
+  // **************************************************************************************** //
+  bool  WifiNet::fetchLease(LeaseRecord* L) {
+    /*
+     * method to fetch the lease record from <EEPROMleaseAddress> to <L>
+     * returns  1 for valid lease: set, checksum OK and not expired
+     *          0 no valid lease, or its expiry can't be checked (clock not set)
+     */
+    uint8_t crc;
+    time_t  now = time(nullptr);
+  
+    EEPROM.get(EEPROMleaseAddress, *L);
+    if ( L->Marker != '#' ) return  false;
+    crc = L->Crc;
+    L->Crc = 0;
+    if ( crc8((uint8_t*)L, sizeof(LeaseRecord)) != crc ) return  false;
+    L->Crc = crc;
+    if ( now <= EpochValid || (uint32_t)now >= L->Expiry ) return  false;   // expired, or not known to be valid
+    return  true;
+  }     // end of fetchLease
+  
+  // **************************************************************************************** //
+  bool  WifiNet::ClearLease(TimePack _SysClock) {
+    /*
+     * method to invalidate the lease record
+     */
+    if ( EEPROM.read(EEPROMleaseAddress) == '?' ) return  true;
+    EEPROM.write(EEPROMleaseAddress, '?');
+    return  CommitRecord(RecLease);
+  }     // end of ClearLease
+#endif  //_LEASECACHE
+
+#if _PMKCACHE==1
+  // **************************************************************************************** //
+  static uint32_t PmkCrc(const char* Ssid, const char* Psw, const uint8_t* Pmk) {
+    uint8_t   buf[SSIDlength+1+PASSlength+1+PmkLength];
+    uint8_t   s = strnlen(Ssid, SSIDlength), p = strnlen(Psw, PASSlength);
+    memcpy(buf, Ssid, s);
+    buf[s] = 0x00;
+    memcpy(buf+s+1, Psw, p);
+    buf[s+1+p] = 0x00;
+    memcpy(buf+s+1+p+1, Pmk, PmkLength);
+    return  crc32(buf, s+1+p+1+PmkLength);
+  }     // end of PmkCrc
+
+  // **************************************************************************************** //
+  bool  WifiNet::KeepPmk(TimePack _SysClock, const char* Ssid, const char* Psw) {
+    /*
+     * method to derive the WPA2 key of <Ssid> <Psw> and keep it at <EEPROMpmkAddress>; nothing is done when
+     * the record already holds the key of these credentials
+     * returns  0 for write error
+     */
+    static const char Mname[] PROGMEM = "KeepPmk:";
+    PmkRecord R;
+
+    if ( fetchPmk(Ssid, Psw, nullptr) ) return  true;
+    #if _LOGGME==1
+      uint32_t  t0 = millis();
+    #endif  //_LOGGME
+    memset(&R, 0, sizeof(R));
+    R.Marker = '%';
+    WifiNetPmk::derive(Psw, Ssid, R.Pmk);
+    R.Crc = PmkCrc(Ssid, Psw, R.Pmk);
+    EEPROM.put(EEPROMpmkAddress, R);
+    #if _LOGGME==1
+      _RunUtil.InfoStamp(_SysClock,Mname,"",1,0); Serial.print(F("key of ")); Serial.print(Ssid); Serial.print(F(" derived in "));
+      Serial.print(millis()-t0); Serial.print(F("mS -END\n"));
+    #endif  //_LOGGME
+    if ( CommitRecord(RecPmk) ) return  true;
+    #if _LOGGME==1
+      _RunUtil.InfoStamp(_SysClock,Mname,_G7,1,0); Serial.print(F("key could not be written to EEPROM - END\n"));
+    #endif //_LOGGME
+    return  false;
+  }     // end of KeepPmk
+
+  // **************************************************************************************** //
+  bool  WifiNet::fetchPmk(const char* Ssid, const char* Psw, char* Hex) {
+    /*
+     * method to fetch the key kept for <Ssid> <Psw> as 64 hex chars to <Hex> (65 chars, nullptr - check only)
+     * returns  1 the record holds the key of these credentials
+     */
+    PmkRecord R;
+
+    if ( EEPROMpmkAddress+sizeof(R) > EEPROM.length() ) return  false;
+    EEPROM.get(EEPROMpmkAddress, R);
+    if ( R.Marker != '%' || R.Crc != PmkCrc(Ssid, Psw, R.Pmk) ) return  false;
+    if ( Hex ) WifiNetPmk::toHex(R.Pmk, Hex);
+    return  true;
+  }     // end of fetchPmk
+#endif  //_PMKCACHE
+
+// **************************************************************************************** //
+const char* WifiNet::Passphrase() {
+  /*
+    * password handed to <WiFi.begin>: the kept key (64 hex chars, taken as the PSK by the SDK) when it belongs
+    * to the credentials in use <_PMKCACHE>, the password otherwise
+    */
+  #if _PMKCACHE==1
+    if ( fetchPmk(_LM.Ssid, _LM.Password, _Psk) ) return  _Psk;
+  #endif  //_PMKCACHE
+  return  _LM.Password;
+}     // end of Passphrase
+
+#ifdef  _SETDEEPSLEEP
+  static_assert(sizeof(RTCsnapshot)%4==0 && sizeof(RTCsnapshot)<=512-RTCsnapOffset*4, "RTC snapshot doesn't fit RTC user memory");
+  // **************************************************************************************** //
+  bool  WifiNet::SaveRTCsnapshot(const ManageWifi& M, uint32_t SleepMs) {
+    /*
+     * method to keep the connection snapshot in RTC user memory, call it just before <ESP.deepSleep(SleepMs*1000)>
+     * the next wake reconnects by it (<startWiFi>) and restores the clock (<GetWWWTime>); the address is reused
+     * while its lease lasts (<LeaseLeft> less the sleep), DHCP gives it otherwise
+     * returns  1 snapshot kept
+     *          0 not connected or RTC memory write failure (next wake takes the regular path)
+     */
+    RTCsnapshot R;
+    timeval     tv;
+  
+    if ( M.WiFiStatus != Connected ) {
+      R.Crc = 0;                              // invalidate
+      ESP.rtcUserMemoryWrite(RTCsnapOffset, &R.Crc, sizeof(R.Crc));
+      return  false;
+    }
+    memset(&R, 0, sizeof(R));
+    R.IP       = WiFi.localIP();
+    R.Gateway  = WiFi.gatewayIP();
+    R.Mask     = WiFi.subnetMask();
+    R.Dns      = WiFi.dnsIP(0);
+    memcpy(R.Bssid,M.WiFiBSsid,6);
+    R.Channel  = M.WiFichannel;
+    R.CredStat = M.CredStat;
+    strcpy(R.Ssid,M.Ssid);
+    strcpy(R.Password,M.Password);
+    if ( _LeaseEndMs && (long)(_LeaseEndMs-millis()) > 0 ) R.LeaseLeft = (_LeaseEndMs-millis())/1000;
+    R.OffsetMs = SleepMs;
+    gettimeofday(&tv, nullptr);
+    if ( tv.tv_sec > EpochValid ) {           // clock set
+      R.Epoch    = tv.tv_sec;
+      R.OffsetMs += tv.tv_usec/1000;
+    }
+    R.Crc = crc32((uint8_t*)&R+sizeof(R.Crc), sizeof(R)-sizeof(R.Crc));
+    return  ESP.rtcUserMemoryWrite(RTCsnapOffset, (uint32_t*)&R, sizeof(R));
+  }     // end of SaveRTCsnapshot
+  
+  // **************************************************************************************** //
+  bool  WifiNet::fetchRTCsnapshot(RTCsnapshot* R) {
+    /*
+     * method to fetch the connection snapshot from RTC user memory
+     * returns  1 valid snapshot and wake from deep sleep
+     *          0 other reset reason, or snapshot invalid
+     */
+    if ( ESP.getResetInfoPtr()->reason != REASON_DEEP_SLEEP_AWAKE ) return  false;
+    if ( !ESP.rtcUserMemoryRead(RTCsnapOffset, (uint32_t*)R, sizeof(RTCsnapshot)) ) return  false;
+    return  R->Crc == crc32((uint8_t*)R+sizeof(R->Crc), sizeof(RTCsnapshot)-sizeof(R->Crc));
+  }     // end of fetchRTCsnapshot
+#endif  //_SETDEEPSLEEP
+
+// **************************************************************************************** //
+void  WifiNet::setReconnectPolicy(uint8_t Policy, uint32_t Base, uint32_t Cap, uint8_t MaxAttempts) {
+    /*
+     * method to set the reconnect policy <Codes4Reconnect>: wait[mS] between connection windows
+     * <Base> and <Cap> in mS, <MaxAttempts> retries after the 1st window before starting the soft AP
+     */
+    _RcPolicy = Policy;
+    _RcBase = Base;
+    _RcCap = Cap;
+    _RcMaxAttempts = MaxAttempts;
+}   // end of setReconnectPolicy
+
+// **************************************************************************************** //
+void  WifiNet::setReconnectPolicy(ReconnectPolicyCB Policy, uint8_t MaxAttempts) {
+    /*
+     * method to set a user reconnect policy (called with attempt, <ReconnectBase>, <ReconnectCap>)
+     */
+    _RcCustom = Policy;
+    _RcPolicy = ReconnectCustom;
+    _RcMaxAttempts = MaxAttempts;
+}   // end of setReconnectPolicy
+
+// **************************************************************************************** //
+uint32_t  WifiNet::ReconnectDelay(uint8_t Attempt) {
+  /*
+    * method to compute the wait[mS] before connection window <Attempt>+1 by the reconnect policy
+    */
+  uint32_t  expo = ( Attempt<31 && _RcBase <= (_RcCap >> Attempt) ) ? _RcBase << Attempt : _RcCap;
+  switch ( _RcPolicy ) {
+    case  ReconnectExpJitter:                 // full jitter
+      return  random(expo+1);
+    case  ReconnectCapped:
+      return  expo;
+    case  ReconnectCustom:
+      if ( _RcCustom ) return  _RcCustom(Attempt,_RcBase,_RcCap);
+      return  _RcBase;
+    case  ReconnectFixed:
+    default:
+      return  _RcBase;
+  }   // end of policy switch
+}   // end of ReconnectDelay
+
+// **************************************************************************************** //
+unsigned long WifiNet::NextWakeIn() {
+  /*
+    * method to return the time[mS] until <WiFiTimeOut> has to be called again (the application may sleep meanwhile)
+    */
+  if ( _RcWaiting ) {                         // between connection windows
+    long  left = (long)(_RcNextAttempt-millis());
+    return  ( left>0 ) ? left : 0;
+  }
+  return  ReconnectTick;                      // connection window runs on timer ticks
+}   // end of NextWakeIn
+
+// **************************************************************************************** //
+void  WifiNet::StartAttempt() {
+  /*
+    * method to open a new connection attempt in the ring of recent attempts
+    */
+  _RingHead = ( _RingCount==0 ) ? 0 : (_RingHead+1) % ConnRingSize;
+  if ( _RingCount < ConnRingSize ) _RingCount++;
+  _Ring[_RingHead].Start = millis();
+  for ( uint8_t i=0; i<PhaseCount; i++ ) _Ring[_RingHead].Phase[i] = 0xFFFF;
+  _Stats.Attempts++;
+}   // end of StartAttempt
+
+// **************************************************************************************** //
+void  WifiNet::MarkPhase(uint8_t Phase) {
+  /*
+    * method to time stamp the end of <Phase> <Codes4ConnPhase> in the current attempt (1st stamp is kept)
+    */
+  if ( _RingCount==0 || Phase>=PhaseCount || _Ring[_RingHead].Phase[Phase]!=0xFFFF ) return;
+  uint32_t  took = millis()-_Ring[_RingHead].Start;
+  _Ring[_RingHead].Phase[Phase] = ( took<0xFFFE ) ? took : 0xFFFE;
+  if ( Phase==PhGotIP ) {                           // connect latency histogram
+    uint8_t b=0;
+    while ( b<ConnHistBuckets && took>ConnHistBounds[b] ) b++;
+    _Stats.ConnHist[b]++;
+    _Stats.ConnSumMs += took;
+  }
+}   // end of MarkPhase
+
+// **************************************************************************************** //
+uint8_t WifiNet::AttemptCount() {
+  /*
+    * method to return the number of attempts kept in the ring
+    */
+  return  _RingCount;
+}   // end of AttemptCount
+
+// **************************************************************************************** //
+bool  WifiNet::getAttempt(uint8_t Back, ConnAttempt* A) {
+  /*
+    * method to copy attempt <Back> to <A> (0 - current/latest attempt, 1 - the one before...)
+    * returns 0 if not kept
+    */
+  if ( Back >= _RingCount ) return  false;
+  *A = _Ring[(_RingHead+ConnRingSize-Back) % ConnRingSize];
+  return  true;
+}   // end of getAttempt
+
+// **************************************************************************************** //
+bool  WifiNet::PhaseStats(uint8_t Phase, uint16_t* Min, uint16_t* Median, uint16_t* P95) {
+  /*
+    * method to summarize <Phase> over the kept attempts that reached it: min, median and 95th percentile [mS]
+    * returns 0 if no kept attempt reached <Phase>
+    */
+  uint16_t  v[ConnRingSize];
+  uint8_t   n=0;
+  if ( Phase>=PhaseCount ) return  false;
+  for ( uint8_t i=0; i<_RingCount; i++ ) {          // collect and insertion sort
+    uint16_t  t = _Ring[i].Phase[Phase];
+    if ( t==0xFFFF ) continue;
+    uint8_t   j = n++;
+    while ( j>0 && v[j-1]>t ) { v[j] = v[j-1]; j--; }
+    v[j] = t;
+  }   // end of collect
+  if ( n==0 ) return  false;
+  *Min    = v[0];
+  *Median = v[(n-1)/2];
+  *P95    = v[(n*95+99)/100-1];                     // nearest rank
+  return  true;
+}   // end of PhaseStats
+
+// **************************************************************************************** //
+IPChars IPText::text() const {
+  /*
+    * dotted text of the binary IP, <NO_IP_Set> for none; formatted into the returned value (reentrant)
+    */
+  IPChars t;
+  if ( !Addr ) strcpy_P(t.Txt, NO_IP_Set);
+  else    snprintf_P(t.Txt, sizeof(t.Txt), PSTR("%u.%u.%u.%u"), (unsigned)(Addr & 0xFF), (unsigned)((Addr>>8) & 0xFF),
+                     (unsigned)((Addr>>16) & 0xFF), (unsigned)(Addr>>24));
+  return  t;
+}   // end of IPText
+
+// **************************************************************************************** //
+bool  WifiNet::EEPROMcommit() {
+  /*
+    * method to commit EEPROM on behalf of the library (counted for metrics)
+    */
+  _Stats.EEPROMcommits++;
+  return  EEPROM.commit();
+}   // end of EEPROMcommit
+
+static_assert(RecPmk < 8*sizeof(uint32_t), "record keys <Codes4Record> exceed the <_TxKeys> bits, too many <CredSlots>");
+// **************************************************************************************** //
+bool  WifiNet::CommitRecord(uint8_t Key) {
+  /*
+    * method to make library record <Key> <Codes4Record> of the EEPROM image persistent: appended to the flash
+    * journal for <_JOURNALSTORE>, otherwise by an EEPROM commit. Inside a transaction it is only marked,
+    * the outermost <TxCommit> commits it
+    */
+  _TxKeys |= (1UL << Key);
+  if ( _TxDepth ) return  true;
+  return  FlushEEPROM();
+}   // end of CommitRecord
+
+// **************************************************************************************** //
+bool  WifiNet::FlushEEPROM() {
+  /*
+    * method to commit the marked library records and transaction writes
+    */
+  bool  ok = true;
+  #if _JOURNALSTORE==1
+    if ( _JournalOn ) {
+      for ( uint8_t k=0; k<RecordKeys; k++ ) {
+        uint16_t  address, len;
+        if ( (_TxKeys & (1UL << k)) && RecordSpan(k, &address, &len) ) ok &= _Journal.write(k, EEPROM.getConstDataPtr()+address, len);
+      }   // end of records
+      if ( _TxDirty ) ok &= EEPROMcommit();
+    } else if ( _TxKeys || _TxDirty ) ok = EEPROMcommit();    // journal not mounted
+  #else
+    if ( _TxKeys || _TxDirty ) ok = EEPROMcommit();
+  #endif  //_JOURNALSTORE
+  _TxKeys = 0;
+  _TxDirty = false;
+  _CommitPending = false;
+  return  ok;
+}   // end of FlushEEPROM
+
+// **************************************************************************************** //
+void  WifiNet::TxBegin() {
+  /*
+    * method to open an EEPROM transaction: library records and <TxWrite> writes up to the matching <TxCommit>
+    * share one commit; transactions nest, the outermost commits
+    */
+  _TxDepth++;
+}   // end of TxBegin
+
+// **************************************************************************************** //
+bool  WifiNet::TxWrite(uint16_t Address, const void* Data, uint16_t Len) {
+  /*
+    * method to write <Len> bytes of <Data> to the EEPROM image at <Address>, only the bytes which differ
+    * returns  1 when the image changed
+    */
+  bool  changed = WriteChanged(Address, Data, Len);
+  _TxDirty |= changed;
+  return  changed;
+}   // end of TxWrite
+
+// **************************************************************************************** //
+bool  WifiNet::TxCommit(bool Defer) {
+  /*
+    * method to close an EEPROM transaction; nothing is written when no byte changed
+    * <Defer> with <_DEFERCOMMIT>: the commit (a flash erase) is left to <ServiceEEPROM> once writes are
+    * quiet for <CommitIdleTime>, later writers join it
+    * returns  0 for write error
+    */
+  if ( _TxDepth ) _TxDepth--;
+  if ( _TxDepth || ( !_TxKeys && !_TxDirty ) ) return  true;
+  #if _DEFERCOMMIT==1
+    if ( Defer ) {
+      _CommitPending = true;
+      _CommitDue = millis() + CommitIdleTime;
+      return  true;
+    }
+  #else
+    (void)Defer;
+  #endif  //_DEFERCOMMIT
+  return  FlushEEPROM();
+}   // end of TxCommit
+
+// **************************************************************************************** //
+bool  WifiNet::ServiceEEPROM(bool Force) {
+  /*
+    * method to run a deferred commit, to be called from loop() (with <Force> before a restart)
+    * with <_PMKCACHE> it also derives the key of the stored credentials when they changed (PBKDF2, long),
+    * so web handlers and the connect path do not run it. with <_LEASECACHE> (or <_SETDEEPSLEEP>) it returns a
+    * cached lease in use to DHCP half way to its expiry (a static address is not renewed) and with <_LEASECACHE>
+    * keeps the DHCP lease once the clock is set
+    * returns  0 for write error
+    */
+  if ( _TxDepth ) return  true;
+  bool  ok = true;
+  #if (_LEASECACHE==1 || defined(_SETDEEPSLEEP)) && (_STATICIP==0)
+    if ( _LeaseState==LeaseInUse && (long)(millis()-_LeaseRenewMs) >= 0 ) {
+      WiFi.config(0U,0U,0U);            // DHCP client on, the address is renewed or replaced by the server
+      _LM.StaticDynamicIP = false;
+      _LeaseGrantMs = millis();
+      _LeaseEndMs = 0;                  // not known until the grant is kept
+      _LeaseState = LeaseToKeep;
+    }
+    #if _LEASECACHE==1
+      else if ( _LeaseState==LeaseToKeep && time(nullptr) > EpochValid && WiFi.status()==WL_CONNECTED &&
+                dhcp_supplied_address(netif_default) ) {
+        ok = storeLease(_SysClock, _LM.WiFiBSsid);
+      }   // end of lease
+    #endif  //_LEASECACHE
+  #endif  //_LEASECACHE _SETDEEPSLEEP
+  #if _PMKCACHE==1
+    if ( _PmkDue ) {
+      _PmkDue = false;
+      const uint8_t*  rec = EEPROM.getConstDataPtr();
+      if ( EEPROM.length() >= SSIDlength+PASSlength && ( rec[0]=='+' || rec[0]=='*' ) ) {
+        char  ssid[SSIDlength+1], psw[PASSlength+1];
+        CopyString(ssid, rec+1, SSIDlength-1);
+        CopyString(psw, rec+SSIDlength, PASSlength);
+        ok = KeepPmk(_SysClock, ssid, psw);     // nothing done when the key is kept already
+      }
+    }   // end of key derivation
+  #endif  //_PMKCACHE
+  if ( !_CommitPending ) return  ok;
+  if ( !Force && (long)(millis() - _CommitDue) < 0 ) return  ok;
+  return  FlushEEPROM() && ok;
+}   // end of ServiceEEPROM
+
+// **************************************************************************************** //
+const WifiNetStats& WifiNet::getStats() {
+    /*
+     * method to return the library counters
+     */
+    return  _Stats;
+}   // end of getStats
+
+// **************************************************************************************** //
+enum  MetricIndex { MtAttempts=0, MtReconnects, MtSoftAP, MtEEPROM, MtPoolExhausted, MtRateLimited, MtBusy, MtStatus, MtRSSI,
+                    MtChannel, MtHeap, MtMaxBlock, MtNTPage, MtUptime, MtPoolInUse, MtPoolHighWater, MetricCount };   // counters up to <MtBusy>
+struct  MetricsSnap {               // values of one scrape, fixed when the request arrives
+  long          Val[MetricCount];
+  unsigned long Hist[ConnHistBuckets+1];
+  unsigned long HistSum;
+  ChunkCursor   Cursor;
+};
+static const char MN0[]  PROGMEM = "wifinet_connect_attempts_total";
+static const char MN1[]  PROGMEM = "wifinet_reconnects_total";
+static const char MN2[]  PROGMEM = "wifinet_softap_entries_total";
+static const char MN3[]  PROGMEM = "wifinet_eeprom_commits_total";
+static const char MN4[]  PROGMEM = "wifinet_pool_exhausted_total";
+static const char MN5[]  PROGMEM = "wifinet_admit_rate_limited_total";
+static const char MN6[]  PROGMEM = "wifinet_admit_busy_total";
+static const char MN7[]  PROGMEM = "wifinet_status";
+static const char MN8[]  PROGMEM = "wifinet_rssi_dbm";
+static const char MN9[]  PROGMEM = "wifinet_channel";
+static const char MN10[] PROGMEM = "wifinet_free_heap_bytes";
+static const char MN11[] PROGMEM = "wifinet_max_free_block_bytes";
+static const char MN12[] PROGMEM = "wifinet_ntp_sync_age_seconds";
+static const char MN13[] PROGMEM = "wifinet_uptime_seconds";
+static const char MN14[] PROGMEM = "wifinet_pool_in_use";
+static const char MN15[] PROGMEM = "wifinet_pool_high_water";
+static const char MNH[]  PROGMEM = "wifinet_connect_latency_ms";
+static const char* const MetricName[MetricCount] PROGMEM = { MN0, MN1, MN2, MN3, MN4, MN5, MN6, MN7, MN8, MN9, MN10,
+                                                             MN11, MN12, MN13, MN14, MN15 };
+static const char MTcounter[] PROGMEM = "counter";
+static const char MTgauge[]   PROGMEM = "gauge";
+
+// **************************************************************************************** //
+static int  MetricLine(uint16_t Line, const void* Ctx, char* Out, size_t Cap) {
+  /*
+    * Prometheus text format renderer, line by line: 2 lines (TYPE, sample) per metric, then the latency histogram
+    */
+  const MetricsSnap*  S = (const MetricsSnap*)Ctx;
+  if ( Line < 2*MetricCount ) {                     // scalar metrics
+    uint8_t     m = Line/2;
+    const char* name = (const char*)pgm_read_ptr(&MetricName[m]);
+    if ( Line & 1 ) return  snprintf_P(Out, Cap, PSTR("%s %ld\n"), name, S->Val[m]);
+    return  snprintf_P(Out, Cap, PSTR("# TYPE %s %s\n"), name, m<=MtBusy ? MTcounter : MTgauge);
+  }
+  Line -= 2*MetricCount;
+  if ( Line == 0 ) return  snprintf_P(Out, Cap, PSTR("# TYPE %s histogram\n"), MNH);
+  Line--;
+  if ( Line <= ConnHistBuckets ) {                  // cumulative buckets
+    unsigned long cum=0;
+    for ( uint8_t b=0; b<=Line; b++ ) cum += S->Hist[b];
+    if ( Line == ConnHistBuckets ) return  snprintf_P(Out, Cap, PSTR("%s_bucket{le=\"+Inf\"} %lu\n"), MNH, cum);
+    return  snprintf_P(Out, Cap, PSTR("%s_bucket{le=\"%u\"} %lu\n"), MNH, ConnHistBounds[Line], cum);
+  }
+  Line -= ConnHistBuckets+1;
+  if ( Line == 0 ) return  snprintf_P(Out, Cap, PSTR("%s_sum %lu\n"), MNH, S->HistSum);
+  if ( Line == 1 ) {
+    unsigned long cnt=0;
+    for ( uint8_t b=0; b<=ConnHistBuckets; b++ ) cnt += S->Hist[b];
+    return  snprintf_P(Out, Cap, PSTR("%s_count %lu\n"), MNH, cnt);
+  }
+  return  -1;                                       // past last line
+}     // end of MetricLine
+
+// **************************************************************************************** //
+void  WifiNet::RegisterMetrics(AsyncWebServer* Server) {
+    /*
+     * method to register the Prometheus text metrics handler at <MetricsPath>
+     */
+    Server->on(MetricsPath, HTTP_GET, [this](AsyncWebServerRequest *request) { if ( Admit(request) ) ServiceMetrics(request); });
+}   // end of RegisterMetrics
+
+// **************************************************************************************** //
+void  WifiNet::ServiceMetrics(AsyncWebServerRequest *request) {
+  /*
+    * Async server handler serving counters and gauges in Prometheus text format (version 0.0.4)
+    * the values are taken once into a slab of <Pool>, then streamed as a chunked response line by line through a
+    * small stack buffer (no page buffer, no <String>, no heap block per scrape); with the pool exhausted 503
+    */
+  static_assert(sizeof(MetricsSnap) <= PoolSlabSize, "<PoolSlabSize> too small for <MetricsSnap>");
+  void*   slab = _Pool.borrow(request);
+  if ( !slab ) {
+    _Pool.refuse(request);
+    return;
+  }
+  MetricsSnap&  S = *new (slab) MetricsSnap;
+  bool        sta = WiFi.status()==WL_CONNECTED;
+  S.Val[MtAttempts]   = _Stats.Attempts;
+  S.Val[MtReconnects] = _Stats.Reconnects;
+  S.Val[MtSoftAP]     = _Stats.SoftAPentries;
+  S.Val[MtEEPROM]     = _Stats.EEPROMcommits;
+  S.Val[MtStatus]     = _LM.WiFiStatus;
+  S.Val[MtRSSI]       = sta ? WiFi.RSSI() : 0;
+  S.Val[MtChannel]    = WiFi.channel();
+  S.Val[MtHeap]       = ESP.getFreeHeap();
+  S.Val[MtMaxBlock]   = ESP.getMaxFreeBlockSize();
+  S.Val[MtNTPage]     = _Stats.NTPsyncTime ? (long)((millis()-_Stats.NTPsyncTime)/1000) : -1;
+  S.Val[MtUptime]     = millis()/1000;
+  S.Val[MtPoolExhausted] = _Pool.Exhausted;
+  S.Val[MtRateLimited] = _Admit.RateLimited;
+  S.Val[MtBusy]       = _Admit.Busy;
+  S.Val[MtPoolInUse]  = _Pool.InUse;
+  S.Val[MtPoolHighWater] = _Pool.HighWater;
+  for ( uint8_t b=0; b<=ConnHistBuckets; b++ ) S.Hist[b] = _Stats.ConnHist[b];
+  S.HistSum = _Stats.ConnSumMs;
+  S.Cursor.Line = 0;
+  S.Cursor.LineStart = 0;
+  request->send(request->beginChunkedResponse(F("text/plain; version=0.0.4"),
+    [&S](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+      return  StreamLines(MetricLine, &S, S.Cursor, buf, maxLen, index); }));
+}   // end of ServiceMetrics
+
+// **************************************************************************************** //
+WifiNetPool&  WifiNet::Pool() {
+    /*
+     * method to return the slab pool of the web handlers, for application handlers to borrow from
+     */
+    return  _Pool;
+}   // end of Pool
+
+// **************************************************************************************** //
+bool  WifiNet::Admit(AsyncWebServerRequest *request) {
+  /*
+    * admission of <request> to a handler (<WifiNetAdmit>): refused requests are answered here, by 503 when
+    * <AdmitInFlight> responses are streaming or 429 when the client is over its rate, both with Retry-After
+    * and no body; the registered handlers call it first, application handlers may too
+    * returns  0 refused, the request was answered
+    */
+  uint32_t  ip = request->client() ? (uint32_t)request->client()->remoteIP() : 0;
+  switch ( _Admit.check(ip, millis(), _Pool.InUse) ) {
+    case  AdmitOK:
+      return  true;
+    case  AdmitBusy:
+      _Pool.refuse(request);
+      return  false;
+    default: {
+      AsyncWebServerResponse* response = request->beginResponse(429);
+      response->addHeader(F("Retry-After"), F("1"));
+      request->send(response);
+      return  false;
+    }
+  }   // end of verdict switch
+}   // end of Admit
+
+// **************************************************************************************** //
+struct  StatusKey {                 // connection state of /status, the ETag is its CRC (no padding, see assert)
+  uint32_t      IP;                 // binary, network order, 0 none
+  uint32_t      ConnectMs;          // time to got-IP of the last attempt reaching it [mS], 0xFFFFFFFF none
+  uint8_t       Bssid[6];
+  uint8_t       Status;             // <Codes4WiFi>
+  uint8_t       Cred;
+  uint8_t       Channel;
+  uint8_t       NTPsynced;
+  uint8_t       Spare[2];
+};
+static_assert(sizeof(StatusKey)==20, "StatusKey has padding");
+struct  StatusSnap {                // values of one /status request, fixed when the request arrives
+  StatusKey     Key;
+  long          RSSI;               // [dBm], 0 not associated, not in the ETag (changes on every poll)
+  unsigned long Uptime;             // [S], not in the ETag
+  long          NTPage;             // [S], -1 never synced, not in the ETag
+  ChunkCursor   Cursor;
+};
+
+// **************************************************************************************** //
+static int  StatusLine(uint16_t Line, const void* Ctx, char* Out, size_t Cap) {
+  /*
+    * JSON renderer, one member per line; values are numbers, dotted IP and hex BSSID, so nothing needs escaping
+    */
+  const StatusSnap* S = (const StatusSnap*)Ctx;
+  const StatusKey&  K = S->Key;
+  const uint8_t*    ip = (const uint8_t*)&K.IP;
+  switch ( Line ) {
+    case 0:   return  snprintf_P(Out, Cap, PSTR("{\n\"wifi_status\":%u,\n"), K.Status);
+    case 1:   return  snprintf_P(Out, Cap, PSTR("\"cred_stat\":%u,\n"), K.Cred);
+    case 2:   if ( !K.IP ) return  snprintf_P(Out, Cap, PSTR("\"ip\":null,\n"));
+              return  snprintf_P(Out, Cap, PSTR("\"ip\":\"%u.%u.%u.%u\",\n"), ip[0], ip[1], ip[2], ip[3]);
+    case 3:   return  snprintf_P(Out, Cap, PSTR("\"bssid\":\"%02x:%02x:%02x:%02x:%02x:%02x\",\n"),
+                                 K.Bssid[0], K.Bssid[1], K.Bssid[2], K.Bssid[3], K.Bssid[4], K.Bssid[5]);
+    case 4:   if ( !S->RSSI ) return  snprintf_P(Out, Cap, PSTR("\"channel\":%u,\n\"rssi_dbm\":null,\n"), K.Channel);
+              return  snprintf_P(Out, Cap, PSTR("\"channel\":%u,\n\"rssi_dbm\":%ld,\n"), K.Channel, S->RSSI);
+    case 5:   return  snprintf_P(Out, Cap, PSTR("\"uptime_s\":%lu,\n"), S->Uptime);
+    case 6:   if ( K.ConnectMs==0xFFFFFFFF ) return  snprintf_P(Out, Cap, PSTR("\"connect_ms\":null,\n"));
+              return  snprintf_P(Out, Cap, PSTR("\"connect_ms\":%lu,\n"), (unsigned long)K.ConnectMs);
+    case 7:   if ( S->NTPage<0 ) return  snprintf_P(Out, Cap, PSTR("\"ntp_synced\":false,\n\"ntp_age_s\":null\n}\n"));
+              return  snprintf_P(Out, Cap, PSTR("\"ntp_synced\":true,\n\"ntp_age_s\":%ld\n}\n"), S->NTPage);
+  }
+  return  -1;                                       // past last line
+}     // end of StatusLine
+
+// **************************************************************************************** //
+void  WifiNet::RegisterStatus(AsyncWebServer* Server) {
+    /*
+     * method to register the JSON connection status handler at <StatusPath>
+     */
+    Server->on(StatusPath, HTTP_GET, [this](AsyncWebServerRequest *request) { if ( Admit(request) ) ServiceStatus(request); });
+}   // end of RegisterStatus
+
+// **************************************************************************************** //
+void  WifiNet::ServiceStatus(AsyncWebServerRequest *request) {
+  /*
+    * Async server handler serving the connection state as a JSON document, for pollers:
+    * {"wifi_status","cred_stat","ip","bssid","channel","rssi_dbm","uptime_s","connect_ms","ntp_synced","ntp_age_s"}
+    * the weak ETag is the CRC of the connection state (not of RSSI, uptime and NTP age, which move on every poll):
+    * a poller sending it back in If-None-Match gets 304 while the connection did not change, with no body
+    * the document is streamed line by line from a slab of <Pool> (no heap block, no <String>); pool exhausted 503
+    */
+  StatusSnap  S;
+  ConnAttempt A;
+  char        etag[16];
+  memset(&S.Key, 0, sizeof(S.Key));
+  S.Key.IP        = _LM.DeviceIP.Addr;
+  S.Key.ConnectMs = 0xFFFFFFFF;
+  for ( uint8_t b=0; getAttempt(b, &A); b++ )
+    if ( A.Phase[PhGotIP]!=0xFFFF ) { S.Key.ConnectMs = A.Phase[PhGotIP]; break; }
+  memcpy(S.Key.Bssid, _LM.WiFiBSsid, sizeof(S.Key.Bssid));
+  S.Key.Status    = _LM.WiFiStatus;
+  S.Key.Cred      = _LM.CredStat;
+  S.Key.Channel   = _LM.WiFichannel;
+  S.Key.NTPsynced = _Stats.NTPsyncTime!=0;
+  snprintf_P(etag, sizeof(etag), PSTR("W/\"%08lx\""), (unsigned long)crc32((const uint8_t*)&S.Key, sizeof(S.Key)));
+  AsyncWebHeader* match = request->getHeader(F("If-None-Match"));
+  if ( match && (strstr(match->value().c_str(), etag+2) || !strcmp(match->value().c_str(), "*")) ) {
+    AsyncWebServerResponse* response = request->beginResponse(304);   // state unchanged
+    response->addHeader(F("ETag"), etag);
+    request->send(response);
+    return;
+  }
+  static_assert(sizeof(StatusSnap) <= PoolSlabSize, "<PoolSlabSize> too small for <StatusSnap>");
+  void*   slab = _Pool.borrow(request);
+  if ( !slab ) {
+    _Pool.refuse(request);
+    return;
+  }
+  S.RSSI    = WiFi.status()==WL_CONNECTED ? WiFi.RSSI() : 0;
+  S.Uptime  = millis()/1000;
+  S.NTPage  = _Stats.NTPsyncTime ? (long)((millis()-_Stats.NTPsyncTime)/1000) : -1;
+  S.Cursor.Line = 0;
+  S.Cursor.LineStart = 0;
+  StatusSnap* P = new (slab) StatusSnap(S);
+  AsyncWebServerResponse* response = request->beginChunkedResponse(F("application/json"),
+    [P](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+      return  StreamLines(StatusLine, P, P->Cursor, buf, maxLen, index); });
+  response->addHeader(F("ETag"), etag);
+  response->addHeader(F("Cache-Control"), F("no-cache"));
+  request->send(response);
+}   // end of ServiceStatus
+
+// **************************************************************************************** //
+void  WifiNet::onWifiConnected(WifiConnectedCB CallBack) {
+    /*
+     * method to set the user callback, called as soon as the station got its IP (<_WIFIEVENTS>)
+     * the callback runs in the event context: keep it short, no blocking calls
+     */
+    _ConnectedCB = CallBack;
+}   // end of onWifiConnected
+
+// **************************************************************************************** //
+void  WifiNet::StationConnected(uint8_t Channel) {
+  /*
+    * station event: associated and authenticated to the AP
+    */
+  (void)Channel;
+  MarkPhase(PhAssocAuth);
+}   // end of StationConnected
+
+// **************************************************************************************** //
+void  WifiNet::StationGotIP(uint32_t IP, uint32_t Mask, uint32_t GW) {
+  /*
+    * station event: IP assigned to the station
+    * called by the ESP8266 event source (registered by <begin>) or by a mocked event source
+    * latches the event for <IsWifiConnected>, updates the instance state and calls the user callback
+    */
+  #if _LOGGME==1
+    static const char Mname[] PROGMEM = "StationGotIP:";
+    static const char L0[] PROGMEM = "IP assigned ";
+  #endif  //_LOGGME
+  MarkPhase(PhGotIP);
+  _EvFlags |= EvGotIP;
+  _EvFlags &= ~EvDisconnected;
+  Gateway = GW;
+  Subnet  = Mask;
+  _LM.WiFiStatus = Connected;
+  _LM.previousIP = IP;
+  _LM.DeviceIP = IP;                                          // formatted when displayed
+  #if _LOGGME==1
+    _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(_LM.DeviceIP.text()); Serial.print(F(" Time to IP: ")); 
+    Serial.print(_RunClock.ElapseStopwatch(_LM.TimeMeasured)); Serial.print(F("mS - END\n"));
+  #endif  //_LOGGME
+  if ( _ConnectedCB ) _ConnectedCB(_LM);
+}   // end of StationGotIP
+
+// **************************************************************************************** //
+void  WifiNet::StationDisconnected(uint8_t Reason) {
+  /*
+    * station event: disconnected from AP (<Reason> by SDK WIFI_DISCONNECT_REASON_*)
+    */
+  _EvFlags |= EvDisconnected;
+  _EvFlags &= ~EvGotIP;
+  _EvReason = Reason;
+  if ( _LM.WiFiStatus == Connected ) _LM.WiFiStatus = Connection_lost;
+}   // end of StationDisconnected
+
+// **************************************************************************************** //
+void  WifiNet::StationAuthChanged(uint8_t OldMode, uint8_t NewMode) {
+  /*
+    * station event: AP authentication mode changed, the SDK drops the link
+    */
+  #if _LOGGME==1
+    static const char Mname[] PROGMEM = "StationAuthChanged:";
+    static const char L0[] PROGMEM = "AP auth mode changed from ";
+    _RunUtil.InfoStamp(_SysClock,Mname,L0,1,0); Serial.print(OldMode); Serial.print(F(" to ")); Serial.print(NewMode); Serial.print(F(" -END\n"));
+  #else
+    (void)OldMode; (void)NewMode;
+  #endif  //_LOGGME
+  _EvFlags |= EvAuthChanged;
+}   // end of StationAuthChanged
+
+// **************************************************************************************** //
+ManageWifi& WifiNet::State() {
+    /*
+     * method to return the instance state, the one the in place methods work on
+     */
+    return  _LM;
+}   // end of State
+
+// **************************************************************************************** //
+// by value forms (compatibility): load <M> to the instance state, run the in place method, return a copy
+// **************************************************************************************** //
+ManageWifi  WifiNet::begin(ManageWifi M)                                    { _LM = M; return begin(); }
+ManageWifi  WifiNet::startWiFi(TimePack _SysClock, ManageWifi M)            { _LM = M; return startWiFi(_SysClock); }
+ManageWifi  WifiNet::WiFiTimeOut(TimePack _SysClock, ManageWifi M)          { _LM = M; return WiFiTimeOut(_SysClock); }
+ManageWifi  WifiNet::IsWifiConnected(TimePack _SysClock, ManageWifi M)      { _LM = M; return IsWifiConnected(_SysClock); }
+ManageWifi  WifiNet::startOTAWifiServer(TimePack _SysClock, ManageWifi M)   { _LM = M; return startOTAWifiServer(_SysClock); }
+ManageWifi  WifiNet::fetchCredFromEEPROM(TimePack _SysClock, ManageWifi M)  { _LM = M; return fetchCredFromEEPROM(_SysClock); }
+ManageWifi  WifiNet::UpdateWifiCredentials(TimePack _SysClock, ManageWifi M){ _LM = M; return UpdateWifiCredentials(_SysClock); }
+ManageWifi  WifiNet::ServiceOTACred(AsyncWebServerRequest *request, TimePack _SysClock, ManageWifi M) {
+  #if _CMDQUEUE==0
+    _LM = M;
+  #else
+    (void)M;                            // a queued handler does not load the state
+  #endif  //_CMDQUEUE
+  return  ServiceOTACred(request, _SysClock);
+}
+bool        WifiNet::IsItNewIPaddress(const ManageWifi& M)                  { _LM.previousIP = M.previousIP; return IsItNewIPaddress(); }
+#if CredSlots>1
+  ManageWifi  WifiNet::SelectCredSlot(TimePack _SysClock, ManageWifi M)     { _LM = M; return SelectCredSlot(_SysClock); }
+#endif  //CredSlots
+
 #ifdef  NONEED
 // **************************************************************************************** //
 /*
@@ -28,6 +28,25 @@
   #endif  //_DEBUGON
 
   #include  "Arduino.h"
+  #include  "ESP8266WiFi.h"             // for <WiFiEventHandler>
+  #include  "WifiNetPage.h"
+  #include  "WifiNetPool.h"
+  #include  "WifiNetAdmit.h"
+  #if _JOURNALSTORE==1
+    #include  "WifiNetJournal.h"
+  #endif  //_JOURNALSTORE
+  #if _PMKCACHE==1
+    #include  "WifiNetPmk.h"
+  #endif  //_PMKCACHE
+  #if _CMDQUEUE==1
+    #include  "WifiNetQueue.h"
+  #endif  //_CMDQUEUE
+  #if _CAPTIVEDNS==1
+    #include  "WifiNetDns.h"
+  #endif  //_CAPTIVEDNS
+  #if _WIFINTPON==1 && _SNTPCLIENT==1
+    #include  "WifiNetSntp.h"
+  #endif  //_SNTPCLIENT
   
   #ifndef SSIDlength
     #define     SSIDlength  32          // maximum SSID length stored in EEPROM
@@ -35,55 +54,284 @@
   #ifndef PASSlength
     #define     PASSlength  32          // maximum PW length stored in EEPROM
   #endif  //PASSlength
-  struct  ManageWifi {
-    IPAddress   previousIP;             // keeps the previous IP address
-    uint32_t    uploadedFileLen;        // length of OTA elegant Server uploaded file
-    unsigned long TimeMeasured;         // keeps the time to connection
-    uint8_t     WiFiStatus;             // status of WiFi connection:
-    uint8_t     WiFiBSsid[6];           // BSSid
-    uint8_t     WiFichannel;            // channel
-    uint8_t     CredStat;               // status of credentials, values by <Codes4WiFi> enup in .cpp
-    uint8_t     ledIndicationCode;      // led indication management
-    uint8_t     HowLongItTook;          // counter of connection retries
-    uint8_t     activeTimeEvent;        // semaphore from library to time event <ManageWifiEvents>:
+  struct  IPChars {                     // dotted text of an <IPText>, held by the caller (a temporary lives to the end of the statement)
+    char        Txt[18];
+    operator const char*() const { return Txt; }
+  };
+  struct  IPText {                      // binary IPv4 (network order) formatted only when read as text
+    uint32_t    Addr;
+    mutable IPChars Shown;              // text of the last <const char*> read, owned by this copy of the state
+    IPText&     operator=(uint32_t A) { Addr = A; return *this; }
+    IPChars     text() const;           // dotted text, <NO_IP_Set> for none
+    operator const char*() const { Shown = text(); return Shown; }  // as the former char DeviceIP[18]
+  };
+  struct  ManageWifi {                  // hot fields first, text last; no padding (see static_assert)
+    uint8_t     WiFiStatus : 3;         // status of WiFi connection, values by <Codes4WiFi>
+    uint8_t     CredStat : 2;           // status of credentials, values by <Codes4WiFi> enup in .cpp
+    bool        StaticDynamicIP : 1;    // set for static IP, reset for DNS address
+    bool        RefreshTimeSet : 1;     // flag to init time refresh
+    bool        uploadFileRady : 1;     // OTA elegant Server uploaded file completed
+    uint8_t     ledIndicationCode : 3;  // led indication management <Codes4Watchlamp>
+    uint8_t     activeTimeEvent : 3;    // semaphore from library to time event <ManageWifiEvents>:
                                         // 0-no action; 1- WIFICONNECT-On ; 2-InitAppPostWiFi-On, WIFICONNECT-Off;
                                         // 3-WIFICONNECT-Off; 4-reset system; 5-TBD;
-    bool        StaticDynamicIP;        // set for static IP, reset for DNS address
-    bool        RefreshTimeSet;         // flag to init time refresh
-    bool        uploadFileRady;         // OTA elegant Server uploaded file completed
-    char        DeviceIP[18];           // keeps actual IP
+    uint8_t     HowLongItTook;          // counter of connection retries
+    uint8_t     WiFichannel;            // channel
+    uint32_t    TimeMeasured;           // keeps the time to connection
+    IPAddress   previousIP;             // keeps the previous IP address
+    IPText      DeviceIP;               // actual IP (binary, reads as text)
+    uint32_t    uploadedFileLen;        // length of OTA elegant Server uploaded file
+    uint8_t     WiFiBSsid[6];           // BSSID
     char        WhoAmI[18];             // platform ID
     char        Version[18];            // current SW version
     char        Ssid[SSIDlength+1];     // network ID
     char        Password[PASSlength+1]; // network password
   };
+  static_assert(sizeof(ManageWifi) == ((54+sizeof(IPText)+sizeof(IPAddress)+SSIDlength+1+PASSlength+1+alignof(ManageWifi)-1)/alignof(ManageWifi))*alignof(ManageWifi),
+                "ManageWifi layout is not packed");
+  #if SSIDlength==32 && PASSlength==32
+    static_assert(sizeof(ManageWifi) <= 144+sizeof(IPAddress), "ManageWifi over its budget, 144 bytes + <previousIP>");
+  #endif  //SSIDlength PASSlength
+  static_assert(Connection_lost < 8 && LedTBD7 < 8, "<Codes4WiFi> or <Codes4Watchlamp> wider than its 3 bit field");
+  struct  LeaseRecord {                 // binary DHCP lease kept at <EEPROMleaseAddress>
+    uint8_t     Marker;                 // '#' - record set
+    uint8_t     Crc;                    // CRC8 of the record, <Crc> as 0
+    uint8_t     Bssid[6];               // BSSID of the AP which granted the lease
+    uint32_t    IP;                     // leased IP
+    uint32_t    Gateway;
+    uint32_t    Mask;
+    uint32_t    Dns;
+    uint32_t    Expiry;                 // lease expiry (epoch[S]), the record is not reused while the clock is not set
+  };
+  struct  CredSlot {                    // network credential slot at <EEPROMslotsAddress> (<CredSlots> > 1)
+    uint8_t     Marker;                 // '*' - slot set, other - free
+    uint8_t     Priority;               // 0 lowest ... 255 highest
+    uint8_t     Channel;                // cached channel, 0 unknown
+    uint8_t     Bssid[6];               // cached BSSID
+    uint32_t    LastSuccess;            // recency stamp, advanced on every successful connection (0 never)
+    char        Ssid[SSIDlength+1];     // network ID
+    char        Password[PASSlength+1]; // network password
+  };
+  struct  PmkRecord {                   // WPA2 key of the stored credentials at <EEPROMpmkAddress> (<_PMKCACHE>)
+    uint8_t     Marker;                 // '%' - record set
+    uint8_t     Spare[3];
+    uint32_t    Crc;                    // CRC32 of SSID, password and <Pmk>: the key belongs to these credentials
+    uint8_t     Pmk[32];                // PBKDF2-HMAC-SHA1(password, SSID, 4096)
+  };
+  #ifndef EEPROMpmkAddress
+    #define EEPROMpmkAddress  (EEPROMslotsAddress + (CredSlots>1 ? CredSlots : 0)*sizeof(CredSlot))  // after the slots
+  #endif  //EEPROMpmkAddress
+  // end of the library records (see EEPROM allocation in WifiNet.cpp)
+  constexpr uint16_t  WifiNetAppStart = _PMKCACHE==1 ? EEPROMpmkAddress+sizeof(PmkRecord) :
+                                        CredSlots>1 ? EEPROMslotsAddress+CredSlots*sizeof(CredSlot) :
+                                        _LEASECACHE==1 ? EEPROMleaseAddress+sizeof(LeaseRecord) : 0x0064;
+  static_assert(WifiNetAppStart <= EEPROMappAddress, "library EEPROM records overlap the application data: move the data "
+                "to <WifiNetAppStart> or above and set <EEPROMappAddress> to its start");
+  struct  RTCsnapshot {                 // connection snapshot kept in RTC user memory over deep sleep <_SETDEEPSLEEP>
+    uint32_t    Crc;                    // CRC32 of the rest of the snapshot
+    uint32_t    IP;                     // lease in use
+    uint32_t    Gateway;
+    uint32_t    Mask;
+    uint32_t    Dns;
+    uint32_t    Epoch;                  // epoch[S] when the snapshot was taken, 0 clock not set
+    uint32_t    OffsetMs;               // sleep duration + sub-second part of <Epoch> [mS]
+    uint32_t    LeaseLeft;              // [S] left of the lease of <IP> when the snapshot was taken, 0 unknown (DHCP)
+    uint8_t     Bssid[6];
+    uint8_t     Channel;
+    uint8_t     CredStat;
+    char        Ssid[SSIDlength+1];
+    char        Password[PASSlength+1];
+  };
+  struct  ConnAttempt {                 // phase time stamps of a connection attempt <Codes4ConnPhase>
+    uint32_t    Start;                  // <millis> at start of the attempt
+    uint16_t    Phase[PhaseCount];      // time[mS] from <Start> to end of each phase, 0xFFFF not reached
+  };
+  #define ConnHistBuckets  6              // connect latency histogram buckets (bounds in .cpp), +Inf bucket added
+  struct  WifiNetStats {                // counters served by <ServiceMetrics>
+    uint32_t    Attempts;               // connection attempts started
+    uint32_t    Reconnects;             // connection lost events
+    uint32_t    EEPROMcommits;          // EEPROM commits by the library
+    uint32_t    SoftAPentries;          // soft AP starts
+    uint32_t    ConnHist[ConnHistBuckets+1];  // attempts by time to got-IP (not cumulative), last is +Inf
+    uint32_t    ConnSumMs;              // sum of time to got-IP [mS]
+    unsigned long NTPsyncTime;          // <millis> at last network time set, 0 never
+  };
+  struct  WifiNetCommand {              // command of a web handler <Codes4Command>, <PostCommand>
+    uint8_t     Code;
+    uint8_t     Priority;               // slot priority of <CmdStoreCred> (<CredSlots> > 1)
+    int16_t     Slot;                   // slot to replace of <CmdStoreCred>, -1 by SSID (<CredSlots> > 1)
+    char        Ssid[SSIDlength+1];     // credentials of <CmdStoreCred>
+    char        Password[PASSlength+1];
+  };
+  struct  WifiNetAsset {                // constant asset in flash, WifiNetAssets.h <RegisterAssets>
+    const char*     Path;               // URL
+    const char*     Type;               // content type
+    const char*     ETag;               // content hash, quoted
+    const uint8_t*  Data;               // PROGMEM
+    uint16_t        Len;
+    bool            Gzip;               // <Data> gzip compressed
+  };
+  typedef void (*WifiConnectedCB)(const ManageWifi& M);  // user callback, called once IP is assigned to the station (SDK context, no copy)
+  typedef uint32_t (*ReconnectPolicyCB)(uint8_t Attempt, uint32_t Base, uint32_t Cap);  // user reconnect policy, returns wait[mS]
+  typedef void (*NTPdoneCB)(bool Synced, time_t Epoch, uint16_t DelayMs);  // user callback, end of an SNTP round <ServiceNTP>
 
   class WifiNet {
     public:
       WifiNet(ManageWifi M);					  // constructor
+      ManageWifi& State();                // instance state, worked on in place by the methods below
+      ManageWifi& begin();
+      ManageWifi& startWiFi(TimePack  SysClock);
+      ManageWifi& WiFiTimeOut(TimePack  SysClock);
+      ManageWifi& IsWifiConnected(TimePack  SysClock);
+      ManageWifi& startOTAWifiServer(TimePack SysClock);
+      ManageWifi& fetchCredFromEEPROM(TimePack _SysClock);
+      ManageWifi& UpdateWifiCredentials(TimePack _SysClock);
+      ManageWifi& ServiceOTACred(AsyncWebServerRequest *request, TimePack _SysClock);
+      ManageWifi& SelectCredSlot(TimePack _SysClock);
+      bool        IsItNewIPaddress ();
+      // by value forms (compatibility): <M> is loaded to the instance state, a copy of it is returned
       ManageWifi  begin(ManageWifi M);
       ManageWifi  startWiFi(TimePack  SysClock, ManageWifi M);
       ManageWifi  WiFiTimeOut(TimePack  SysClock, ManageWifi M);
       ManageWifi  IsWifiConnected(TimePack  SysClock, ManageWifi M);
-      void        WiFiCodePrint(uint8_t Index);
-      TimePack    GetWWWTime (TimePack  SysClock, ManageWifi M);
       ManageWifi  startOTAWifiServer(TimePack SysClock, ManageWifi M);
-      void        whileWait4Wifi(ManageWifi M);
       ManageWifi  fetchCredFromEEPROM(TimePack _SysClock, ManageWifi M);
       ManageWifi  UpdateWifiCredentials(TimePack _SysClock, ManageWifi M);
+      ManageWifi  ServiceOTACred(AsyncWebServerRequest *request, TimePack _SysClock, ManageWifi M);
+      ManageWifi  SelectCredSlot(TimePack _SysClock, ManageWifi M);
+      bool        IsItNewIPaddress (const ManageWifi& M);
+      void        WiFiCodePrint(uint8_t Index);
+      TimePack    GetWWWTime (TimePack  SysClock, const ManageWifi& M);
+      void        whileWait4Wifi(const ManageWifi& M);
       bool        ClearEEPROMwifiCredentials(TimePack  SysClock);
       bool        KeepCredentialsEEPROM (TimePack _SysClock, char* id, char* psw);
       bool        KeepChaBssidEEPROM (TimePack _SysClock, uint8_t Bssid[], uint8_t Channel);
-      ManageWifi  ServiceOTACred(AsyncWebServerRequest *request, TimePack _SysClock, ManageWifi M);
-      char*       SimpleUtilityPage(TimePack _SysClock, ManageWifi M, char* buf, uint8_t option, 
+      char*       SimpleUtilityPage(TimePack _SysClock, const ManageWifi& M, char* buf, uint8_t option, 
                        const char* PageTitleName, const char* FeedBack, const char* insert_action);
-      bool        storeIPaddress(TimePack _SysClock, char* IPstring, uint16_t EEPaddress);
+      size_t      SendUtilityPage(AsyncWebServerRequest *request, TimePack _SysClock, uint8_t option,
+                       const char* PageTitleName, const char* FeedBack, int Code=200,
+                       const char* const AppValues[]=nullptr, uint8_t AppCount=0);
+      bool        RegisterPage(uint8_t option, const WifiNetTemplate& Page);
+      #if _GZASSETS==1
+        bool      RegisterAssets(AsyncWebServer* Server);
+        void      ServiceAsset(AsyncWebServerRequest *request, const WifiNetAsset& Asset);
+      #endif  //_GZASSETS
+      bool        storeIPaddress(TimePack _SysClock, const char* IPstring, uint16_t EEPaddress);
       char*       fetchIPaddress(char* buff, uint16_t EEPaddress);
-      bool        CompareAndKeepIP (TimePack _SysClock,ManageWifi M);
-      bool        IsItNewIPaddress (ManageWifi M);
+      bool        CompareAndKeepIP (TimePack _SysClock, const ManageWifi& M);
       const char* getVersion();
+      bool        fetchCredSlot(uint8_t Slot, CredSlot* S);
+      bool        KeepCredSlot(TimePack _SysClock, uint8_t Slot, CredSlot* S);
+      uint8_t     FindCredSlot(const char* Ssid);
+      bool        AddCredSlot(TimePack _SysClock, const char* Ssid, const char* Psw, uint8_t Priority, int16_t Slot=-1);
+      bool        UpdateCredSlot(TimePack _SysClock, const ManageWifi& M);
+      bool        storeLease(TimePack _SysClock, uint8_t Bssid[]);
+      bool        fetchLease(LeaseRecord* L);
+      bool        ClearLease(TimePack _SysClock);
+      bool        KeepPmk(TimePack _SysClock, const char* Ssid, const char* Psw);
+      bool        fetchPmk(const char* Ssid, const char* Psw, char* Hex);
+      bool        SaveRTCsnapshot(const ManageWifi& M, uint32_t SleepMs);
+      bool        fetchRTCsnapshot(RTCsnapshot* R);
+      void        setReconnectPolicy(uint8_t Policy, uint32_t Base, uint32_t Cap, uint8_t MaxAttempts);
+      void        setReconnectPolicy(ReconnectPolicyCB Policy, uint8_t MaxAttempts);
+      uint32_t    ReconnectDelay(uint8_t Attempt);
+      unsigned long NextWakeIn();
+      void        StartAttempt();
+      void        MarkPhase(uint8_t Phase);
+      uint8_t     AttemptCount();
+      bool        getAttempt(uint8_t Back, ConnAttempt* A);
+      bool        PhaseStats(uint8_t Phase, uint16_t* Min, uint16_t* Median, uint16_t* P95);
+      const WifiNetStats& getStats();
+      void        RegisterMetrics(AsyncWebServer* Server);
+      void        TxBegin();
+      bool        TxWrite(uint16_t Address, const void* Data, uint16_t Len);
+      bool        TxCommit(bool Defer=false);
+      bool        ServiceEEPROM(bool Force=false);
+      void        ServiceMetrics(AsyncWebServerRequest *request);
+      void        RegisterStatus(AsyncWebServer* Server);
+      void        ServiceStatus(AsyncWebServerRequest *request);
+      WifiNetPool&  Pool();
+      bool        Admit(AsyncWebServerRequest *request);
+      void        RegisterProvisioning(AsyncWebServer* Server, TimePack& SysClock, bool Root=true);
+      #if _CMDQUEUE==1
+        bool      PostCommand(uint8_t Code);
+        bool      PostCommand(const WifiNetCommand& C);
+        uint8_t   ServiceCommands(TimePack _SysClock);
+      #endif  //_CMDQUEUE
+      #if _WIFINTPON==1 && _SNTPCLIENT==1
+        bool      StartNTP(NTPdoneCB Done=nullptr, const char* const Servers[]=nullptr, uint8_t Count=0);
+        uint8_t   ServiceNTP();
+        WifiNetSntp&  Sntp();
+      #endif  //_SNTPCLIENT
+      #if _CAPTIVEDNS==1
+        uint8_t   ServiceDNS();
+        WifiNetDns& Dns();
+      #endif  //_CAPTIVEDNS
+      void        onWifiConnected(WifiConnectedCB CallBack);
+      void        StationConnected(uint8_t Channel);
+      void        StationGotIP(uint32_t IP, uint32_t Mask, uint32_t GW);
+      void        StationDisconnected(uint8_t Reason);
+      void        StationAuthChanged(uint8_t OldMode, uint8_t NewMode);
     private:
+      bool        EEPROMcommit();
+      bool        CommitRecord(uint8_t Key);
+      bool        FlushEEPROM();
+      const char* Passphrase();
       ManageWifi  _LM;
+      WifiNetStats  _Stats;               // counters for <ServiceMetrics>
+      WifiConnectedCB   _ConnectedCB;     // user callback on got-IP
+      WiFiEventHandler  _EvGotIPh;        // station event handlers (kept to stay registered)
+      WiFiEventHandler  _EvConnh;
+      WiFiEventHandler  _EvDisconnh;
+      WiFiEventHandler  _EvAuthh;
+      volatile uint8_t  _EvFlags;         // latched station events <Codes4StaEvent>
+      volatile uint8_t  _EvReason;        // last disconnect reason
+      ReconnectPolicyCB _RcCustom;        // user reconnect policy
+      uint32_t    _RcBase;                // reconnect policy parameters
+      uint32_t    _RcCap;
+      unsigned long _RcNextAttempt;       // time of next connection window (while <_RcWaiting>)
+      uint8_t     _RcPolicy;              // <Codes4Reconnect>
+      uint8_t     _RcMaxAttempts;         // retries before soft AP
+      uint8_t     _RcAttempt;             // failed windows since last connection
+      bool        _RcWaiting;             // waiting between windows, radio idle
+      ConnAttempt _Ring[ConnRingSize];    // recent connection attempts
+      uint8_t     _RingHead;              // index of current attempt
+      uint8_t     _RingCount;             // attempts kept
+      uint32_t    _RTCepoch;              // epoch[S] restored from RTC snapshot, 0 none
+      uint32_t    _RTCoffsetMs;           // offset[mS] to add to <_RTCepoch> with <millis>
+      uint8_t     _LeaseState;            // cached lease status <Codes4Lease>
+      unsigned long _LeaseProbeTime;      // time the ARP conflict probe was sent
+      uint32_t    _LeaseIP;               // cached IP under probe
+      unsigned long _LeaseRenewMs;        // <millis> to return the cached lease in use to DHCP
+      unsigned long _LeaseGrantMs;        // <millis> of the DHCP grant not kept yet (<LeaseToKeep>)
+      unsigned long _LeaseEndMs;          // <millis> the lease of the address in use ends, 0 unknown
+      bool        _FastWake;              // connection window of a wake from RTC snapshot <_SETDEEPSLEEP>
+      uint8_t     _TxDepth;               // open EEPROM transactions <TxBegin>
+      bool        _TxDirty;               // <TxWrite> changed the image
+      uint32_t    _TxKeys;                // library records to commit <Codes4Record> bits
+      bool        _CommitPending;         // deferred commit waiting for <ServiceEEPROM>
+      unsigned long _CommitDue;           // time of the deferred commit
+      const WifiNetTemplate* _Pages[PageOptions];   // utility page templates by <option> <RegisterPage>
+      WifiNetPool _Pool;                  // slabs of the web handler responses
+      WifiNetAdmit  _Admit;               // admission of the requests to the registered handlers
+      #if _CMDQUEUE==1
+        WifiNetQueue<WifiNetCommand,CommandQueueLen> _Commands;   // posted by web handlers, run in loop()
+      #endif  //_CMDQUEUE
+      #if _WIFINTPON==1 && _SNTPCLIENT==1
+        WifiNetSntp _Sntp;                // network time rounds
+        NTPdoneCB   _NtpDone;             // user callback of <StartNTP>
+      #endif  //_SNTPCLIENT
+      #if _CAPTIVEDNS==1
+        WifiNetDns  _Dns;                 // captive portal DNS of the soft AP
+      #endif  //_CAPTIVEDNS
+      #if _JOURNALSTORE==1
+        WifiNetJournal  _Journal;         // flash journal of the library records <Codes4Record>
+        bool        _JournalOn;           // journal mounted (sectors between file system end and EEPROM)
+      #endif  //_JOURNALSTORE
+      #if _PMKCACHE==1
+        char      _Psk[2*PmkLength+1];    // hex PMK handed to <WiFi.begin>
+        bool      _PmkDue;                // stored credentials changed, key derived by <ServiceEEPROM>
+      #endif  //_PMKCACHE
 
   };
 
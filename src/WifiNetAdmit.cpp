@@ -0,0 +1,58 @@
+/*
+ * WifiNetAdmit.cpp admission control of the web handlers for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * constructor:   WifiNetAdmit
+ * methods:       check
+ *
+ */
+
+#include  "Arduino.h"
+#include  "WifiNetAdmit.h"
+
+// **************************************************************************************** //
+WifiNetAdmit::WifiNetAdmit() {
+  memset(_Bucket, 0, sizeof(_Bucket));
+  Admitted = 0;
+  RateLimited = 0;
+  Busy = 0;
+}     // end of WifiNetAdmit
+
+// **************************************************************************************** //
+uint8_t  WifiNetAdmit::check(uint32_t IP, uint32_t Now, uint8_t InFlight) {
+  /*
+    * verdict for a request of client <IP> at <Now>[mS] with <InFlight> responses streaming; a served request
+    * takes a token of the client (with <AdmitRate> >= 1 the next token is less than a second away)
+    * returns  <Codes4Admit>
+    */
+  if ( InFlight >= AdmitInFlight ) {                    // before the bucket: a busy answer costs no token
+    Busy++;
+    return  AdmitBusy;
+  }
+  #if AdmitRate>0                                       // token bucket of the client
+    Bucket* b = nullptr;
+    Bucket* old = &_Bucket[0];
+    for ( uint8_t i=0; i<AdmitClients && !b; i++ ) {
+      if ( _Bucket[i].IP==IP ) b = &_Bucket[i];
+      else if ( !_Bucket[i].IP || (old->IP && Now-_Bucket[i].Seen > Now-old->Seen) ) old = &_Bucket[i];
+    }
+    if ( !b ) {                                         // new client, full bucket
+      b = old;
+      b->IP = IP;
+      b->Seen = Now;
+      b->Tokens = AdmitBurst*1000;
+    }
+    uint32_t  idle = Now-b->Seen;
+    if ( idle > 60000 ) idle = 60000;                   // a full bucket anyway, no overflow below
+    uint32_t  refill = idle*AdmitRate;                  // [mS]*[1/S] = 1/1000 tokens
+    b->Seen = Now;
+    b->Tokens = refill >= (uint32_t)AdmitBurst*1000-b->Tokens ? AdmitBurst*1000 : b->Tokens+refill;
+    if ( b->Tokens < 1000 ) {
+      RateLimited++;
+      return  AdmitRateLimit;
+    }
+    b->Tokens -= 1000;
+  #endif  //AdmitRate
+  Admitted++;
+  return  AdmitOK;
+}     // end of check
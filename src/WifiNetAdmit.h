@@ -0,0 +1,59 @@
+#pragma once
+/*
+ * WifiNetAdmit.h admission control of the web handlers for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * a provisioning soft AP may have several phones at once, each refreshing the form and firing captive portal
+ * probes; the handlers <WifiNet> registers pass <WifiNet::Admit> first, which answers cheaply instead of
+ * rendering, writing EEPROM or taking a slab:
+ *
+ *    503 Retry-After: 1  - <AdmitInFlight> responses already streaming (slabs of <WifiNetPool> out)
+ *    429 Retry-After: 1  - the client's token bucket is empty: <AdmitBurst> requests at once, then <AdmitRate> a second
+ *
+ * the buckets of the last <AdmitClients> client IPs are kept, the least recently seen is reused for a new one.
+ * tokens are kept in 1/1000 so the refill needs no division; a check is O(<AdmitClients>), no allocation.
+ * statistics: <Admitted>, <RateLimited> (429), <Busy> (503)
+ */
+#ifndef WifiNetAdmit_h
+  #define WifiNetAdmit_h
+
+  #include  "Arduino.h"
+  #include  "WifiNetPool.h"             // <PoolSlabs>, the responses in flight
+
+  #ifndef AdmitClients
+    #define AdmitClients    8               // client IPs with a token bucket
+  #endif  //AdmitClients
+  #ifndef AdmitRate
+    #define AdmitRate       2               // [requests/S] refill of a client's bucket, 0 - no per client limit
+  #endif  //AdmitRate
+  #ifndef AdmitBurst
+    #define AdmitBurst      6               // [requests] size of a client's bucket
+  #endif  //AdmitBurst
+  #ifndef AdmitInFlight
+    #define AdmitInFlight   PoolSlabs       // responses streaming at once, at most <PoolSlabs>
+  #endif  //AdmitInFlight
+  static_assert(AdmitRate>=0 && AdmitBurst>=1 && AdmitBurst<=60, "<AdmitRate> 0..., <AdmitBurst> 1...60");
+
+  enum  Codes4Admit {                   // verdict of <WifiNetAdmit::check>
+    AdmitOK=0,                          // 0 - serve
+    AdmitBusy=1,                        // 1 - 503, too many responses in flight
+    AdmitRateLimit=2                    // 2 - 429, client over its rate
+  };
+
+  class WifiNetAdmit {
+    public:
+      WifiNetAdmit();
+      uint8_t     check(uint32_t IP, uint32_t Now, uint8_t InFlight);
+      uint32_t    Admitted;             // requests served
+      uint32_t    RateLimited;          // requests answered 429
+      uint32_t    Busy;                 // requests answered 503
+    private:
+      struct  Bucket {
+        uint32_t  IP;                   // 0 - free
+        uint32_t  Seen;                 // <millis> of the last refill
+        uint16_t  Tokens;               // [1/1000 request]
+      };
+      Bucket      _Bucket[AdmitClients];
+  };
+
+#endif  //WifiNetAdmit_h
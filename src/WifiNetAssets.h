@@ -0,0 +1,75 @@
+/*
+ * WifiNetAssets.h gzip compressed static assets of WifiNet library <_GZASSETS>
+ * generated by extras/tools/gzassets.py from extras/assets - do not edit, run the tool again
+ * (no #pragma once: WifiNet.cpp includes it again for the blobs)
+ *
+ * AssetCss   /wifinet.css                   90 bytes,    90 served (gzip is not smaller)
+ * AssetForm  /wifinet/cred  CredSlots>1    410 bytes,   264 served gzip
+ * AssetForm  /wifinet/cred                 354 bytes,   242 served gzip
+ */
+#ifndef WifiNetAssets_h
+  #define WifiNetAssets_h
+
+  #define AssetCssPath      "/wifinet.css"
+  #define AssetFormPath     "/wifinet/cred"
+  #define AssetFormAction   "setting"          // form action and field names in <AssetForm>
+  #define AssetFormSsid     "SSID"
+  #define AssetFormPass     "Pass"
+  #define AssetFormPrio     "Prio"
+#endif  //WifiNetAssets_h
+
+// the blobs, in the one translation unit that defines <WifiNetAssetData>
+#if defined(WifiNetAssetData) && !defined(WifiNetAssetData_h)
+  #define WifiNetAssetData_h
+  static const uint8_t AssetCssData[] PROGMEM = {
+    0x62,0x6f,0x64,0x79,0x20,0x7b,0x62,0x61,0x63,0x6b,0x67,0x72,0x6f,0x75,0x6e,0x64,
+    0x2d,0x63,0x6f,0x6c,0x6f,0x72,0x3a,0x20,0x23,0x39,0x44,0x43,0x44,0x46,0x34,0x3b,
+    0x20,0x66,0x6f,0x6e,0x74,0x2d,0x66,0x61,0x6d,0x69,0x6c,0x79,0x3a,0x20,0x41,0x72,
+    0x69,0x61,0x6c,0x2c,0x20,0x48,0x65,0x6c,0x76,0x65,0x74,0x69,0x63,0x61,0x2c,0x20,
+    0x53,0x61,0x6e,0x73,0x2d,0x53,0x65,0x72,0x69,0x66,0x3b,0x20,0x43,0x6f,0x6c,0x6f,
+    0x72,0x3a,0x20,0x62,0x6c,0x75,0x65,0x3b,0x7d,0x0a,
+  };
+  static const WifiNetAsset AssetCss = { AssetCssPath, "text/css", "\"23904c70d259ab28\"", AssetCssData, sizeof(AssetCssData), false };
+  #if CredSlots>1
+    static const uint8_t AssetFormData[] PROGMEM = {
+      0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x7d,0x91,0xb1,0x4e,0xc4,0x30,
+      0x0c,0x86,0xf7,0x3e,0x45,0x26,0x02,0x03,0x14,0x4e,0xba,0x13,0x82,0x34,0x03,0xe2,
+      0x06,0x16,0x54,0x51,0xf1,0x00,0x69,0xe3,0x5e,0xad,0x4b,0x93,0x2a,0x71,0x39,0xfa,
+      0xf6,0xb8,0x3d,0x3a,0x20,0x04,0x43,0x22,0x3b,0xf6,0xff,0xc5,0xf9,0xa3,0x3a,0xea,
+      0x9d,0x56,0x1d,0x18,0xab,0x15,0x21,0x39,0xd0,0xfb,0xaa,0xbc,0xdf,0xec,0x76,0xe2,
+      0x9d,0xd0,0x21,0x21,0x24,0x95,0x9f,0x0b,0xca,0xa1,0x3f,0x8a,0x08,0xae,0x90,0x89,
+      0x26,0x07,0xa9,0x03,0x20,0x29,0xba,0x08,0x6d,0x21,0xf3,0x13,0xb6,0xe8,0x81,0x6e,
+      0x9a,0x94,0xa4,0x56,0xf9,0x42,0xcc,0x54,0x1d,0xec,0xc4,0xf8,0x3b,0xfd,0x0a,0x74,
+      0x0a,0xf1,0x28,0x9a,0x08,0x16,0x3c,0xa1,0x71,0xcc,0xe5,0xf3,0x4c,0xb5,0x21,0xf6,
+      0xa2,0x07,0xea,0x82,0x2d,0xe4,0x61,0x26,0x9a,0x86,0x30,0x78,0xbe,0x05,0x88,0xd0,
+      0x1f,0xa4,0xbe,0xf0,0x75,0x1a,0x1e,0x7f,0xef,0x2b,0xb4,0xaa,0x5e,0x9e,0x1f,0x14,
+      0xfa,0x61,0x24,0x41,0xd3,0x00,0x85,0x24,0xf8,0x64,0x90,0x37,0x3d,0xc7,0x73,0x95,
+      0x47,0x7a,0x7a,0x5b,0xd6,0xaa,0x19,0x4c,0x4a,0x1c,0xd8,0xbf,0x75,0xa5,0x59,0x9e,
+      0xf2,0xad,0x2b,0x23,0x86,0x88,0x34,0x89,0xcb,0xdb,0xeb,0xcd,0x76,0x7b,0xf5,0x8f,
+      0x8e,0x3b,0xd7,0x99,0x7f,0x34,0xa5,0xb1,0xee,0x91,0xdb,0x3e,0x8c,0x1b,0x39,0xdd,
+      0x7b,0x82,0x38,0x7b,0x35,0x3b,0xc0,0x46,0xe4,0x67,0xb3,0xf2,0xe5,0x4b,0xb2,0x2f,
+      0xf8,0xd9,0x06,0xbd,0x9a,0x01,0x00,0x00,
+    };
+    static const WifiNetAsset AssetForm = { AssetFormPath, "text/html", "\"b7c391424f52beb8\"", AssetFormData, sizeof(AssetFormData), true };
+  #else
+    static const uint8_t AssetFormData[] PROGMEM = {
+      0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x02,0x03,0x75,0x90,0xb1,0x6e,0xc3,0x20,
+      0x10,0x40,0x77,0x7f,0x05,0x53,0xd9,0x8a,0xda,0x21,0x8a,0x5a,0xcc,0x10,0x35,0x43,
+      0x97,0x2a,0xaa,0xd5,0x0f,0xc0,0xf6,0x39,0x9c,0x02,0xd8,0x82,0x73,0x52,0xff,0x7d,
+      0x0f,0x5b,0x19,0xaa,0xaa,0x03,0xe8,0xe0,0xee,0xde,0xf1,0xd0,0x8e,0x82,0x37,0xda,
+      0x81,0xed,0x8d,0x26,0x24,0x0f,0xe6,0xd8,0x9c,0xf6,0xcf,0xbb,0x9d,0xf8,0x22,0xf4,
+      0x48,0x08,0x59,0xab,0x2d,0xa1,0x3d,0xc6,0x8b,0x48,0xe0,0x6b,0x99,0x69,0xf1,0x90,
+      0x1d,0x00,0x49,0xe1,0x12,0x0c,0xb5,0x54,0x37,0x1c,0x30,0x02,0x3d,0x76,0x39,0x4b,
+      0xa3,0xd5,0x4a,0xac,0x74,0x3b,0xf6,0x0b,0xe3,0x9f,0xcc,0x07,0xd0,0x6d,0x4c,0x17,
+      0xd1,0x25,0xe8,0x21,0x12,0x5a,0xcf,0x5c,0xbe,0xaf,0xf4,0x30,0xa6,0x20,0x02,0x90,
+      0x1b,0xfb,0x5a,0x9e,0x0b,0xd1,0x76,0x84,0x63,0xe4,0x29,0x40,0x84,0xf1,0x2c,0xcd,
+      0x43,0x6c,0xf3,0xf4,0xfa,0x77,0xbf,0x43,0x9b,0xe6,0xfd,0xed,0x45,0x63,0x9c,0x66,
+      0x12,0xb4,0x4c,0x50,0x4b,0x82,0x6f,0x06,0x45,0x1b,0x38,0x2e,0x59,0x7e,0xd2,0xe1,
+      0x73,0x5d,0xf7,0x9e,0xc9,0xe6,0xcc,0x41,0xff,0x7f,0xdf,0xc9,0x16,0x95,0x6d,0xd2,
+      0xaf,0xa2,0x3c,0xb7,0x01,0xb9,0xec,0x6a,0xfd,0xcc,0xc7,0x63,0x24,0x48,0xc5,0xb9,
+      0x98,0xb0,0x90,0xda,0xa4,0xd5,0xfa,0xb5,0xd5,0x0f,0xc0,0xa3,0xc7,0x08,0x62,0x01,
+      0x00,0x00,
+    };
+    static const WifiNetAsset AssetForm = { AssetFormPath, "text/html", "\"23978b2fd54afd4c\"", AssetFormData, sizeof(AssetFormData), true };
+  #endif
+#endif  //WifiNetAssetData
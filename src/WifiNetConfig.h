@@ -39,6 +39,36 @@
   #ifndef _STATICIP
     #define _STATICIP     0       // enable static IP configuration
   #endif  //_STATICIP
+  #ifndef _LEASECACHE
+    #define _LEASECACHE   0       // enable reuse of the last DHCP lease at boot (record at <EEPROMleaseAddress>)
+  #endif  //_LEASECACHE
+  #ifndef CredSlots
+    #define CredSlots     1       // number of network credential slots (1 - single EEPROM credentials record)
+  #endif  //CredSlots
+  #ifndef _JOURNALSTORE
+    #define _JOURNALSTORE 0       // keep library records in a wear leveled flash journal instead of EEPROM commits
+  #endif  //_JOURNALSTORE
+  #ifndef _PMKCACHE
+    #define _PMKCACHE     0       // connect by the WPA2 key derived once from the stored credentials (record at <EEPROMpmkAddress>)
+  #endif  //_PMKCACHE
+  #ifndef _DEFERCOMMIT
+    #define _DEFERCOMMIT  0       // leave EEPROM commits of web requests and connect path to <ServiceEEPROM> in loop()
+  #endif  //_DEFERCOMMIT
+  #ifndef _GZASSETS
+    #define _GZASSETS     0       // serve the style sheet and credential form as compressed flash assets <RegisterAssets>
+  #endif  //_GZASSETS
+  #ifndef _WIFIEVENTS
+    #define _WIFIEVENTS   1       // enable station event driven connection (got-IP, disconnected, auth-mode-changed)
+  #endif  //_WIFIEVENTS
+  #ifndef _CMDQUEUE
+    #define _CMDQUEUE     0       // web handlers post commands (credentials, reset, erase, re-scan) run by <ServiceCommands> in loop()
+  #endif  //_CMDQUEUE
+  #ifndef _SNTPCLIENT
+    #define _SNTPCLIENT   0       // network time by non blocking SNTP rounds of the library <ServiceNTP> instead of <configTime>
+  #endif  //_SNTPCLIENT
+  #ifndef _CAPTIVEDNS
+    #define _CAPTIVEDNS   0       // soft AP answers every DNS name with its address <ServiceDNS>, phones open the form by themselves
+  #endif  //_CAPTIVEDNS
 
   // the foloowing definitions need consideration
   //#define   CLEAREEPROM     true
@@ -51,18 +81,96 @@
   static const char CredSettingTrigger[] ="/setting";
   static const char SSID_Phrase[] = "SSID";             // SSID input field name
   static const char PSWD_Phrase[] = "Pass";             // password input field name
+  static const char PRIO_Phrase[] = "Prio";             // credential slot priority input field name (<CredSlots> > 1)
+  static const char SLOT_Phrase[] = "Slot";             // credential slot number input field name (<CredSlots> > 1)
   static const char Per_SSID[] PROGMEM = "Explorers House Guests";
   static const char Per_Pass[] PROGMEM = "a21guest";
   static const char NO_IP_Set[] PROGMEM = "000.000.000.000  ";    //17 chars
   #ifndef NTPdelayAfterReset
     #define NTPdelayAfterReset  1500                            // delay[mS] after reset for 1st time NTP call
   #endif  //NTPdelayAfterReset
+  #ifndef NTPservers
+    #define NTPservers          "pool.ntp.org", "time.nist.gov", "time.google.com"   // servers of <StartNTP> (<_SNTPCLIENT>)
+  #endif  //NTPservers
+  #ifndef WiFiDisconnectWait
+    #define WiFiDisconnectWait  500                             // max wait[mS] for link down after <WiFi.disconnect>
+  #endif  //WiFiDisconnectWait
   #ifdef  _SETDEEPSLEEP
     const uint8_t   ConnTimeOutRep  = 60;  // 60 repeats ( 100*60= 6 seconds for deep-sleep)
   #else
     const uint8_t   ConnTimeOutRep  =120; // 12- repeats ( 100*120= 12 seconds for regular)
   #endif  //_SETDEEPSLEEP
+  #ifndef ConnRingSize
+    #define ConnRingSize        8                               // number of recent connection attempts kept for phase statistics
+  #endif  //ConnRingSize
+  #ifndef MetricsPath
+    #define MetricsPath         "/metrics"                      // URL of Prometheus text metrics <RegisterMetrics>
+  #endif  //MetricsPath
+  #ifndef StatusPath
+    #define StatusPath          "/status"                       // URL of JSON connection status <RegisterStatus>
+  #endif  //StatusPath
+  #ifndef ProvisionFormPath
+    #define ProvisionFormPath   "/cred"                         // URL of the credential form <RegisterProvisioning>
+  #endif  //ProvisionFormPath
+  #ifndef PageOptions
+    #define PageOptions         8                               // utility page options, 6.. for application pages <RegisterPage>
+  #endif  //PageOptions
+  #ifndef RTCsnapOffset
+    #define RTCsnapOffset       0                               // RTC user memory block (4 bytes each) of wake snapshot <_SETDEEPSLEEP>
+  #endif  //RTCsnapOffset
   #define EEPROMipAddress 0x004B                                // EEPROM location of IP start record
+  #ifndef EEPROMleaseAddress
+    #define EEPROMleaseAddress  0x0064                          // EEPROM location of lease record (28 bytes, <_LEASECACHE>)
+  #endif  //EEPROMleaseAddress
+  #ifndef EEPROMappAddress
+    #define EEPROMappAddress    0x0064                          // 1st EEPROM byte of the application's own data; the library
+  #endif  //EEPROMappAddress                                    // records must end below it (checked at compile time)
+  #ifndef ReconnectPolicyDefault
+    #define ReconnectPolicyDefault  ReconnectFixed              // reconnect policy <Codes4Reconnect>
+  #endif  //ReconnectPolicyDefault
+  #ifndef ReconnectBase
+    #define ReconnectBase       1000                            // base wait[mS] between connection windows
+  #endif  //ReconnectBase
+  #ifndef ReconnectCap
+    #define ReconnectCap        60000                           // max wait[mS] between connection windows
+  #endif  //ReconnectCap
+  #ifndef ReconnectMaxAttempts
+    #define ReconnectMaxAttempts  0                             // retries after 1st window before soft AP (0 - soft AP at once)
+  #endif  //ReconnectMaxAttempts
+  #ifndef ReconnectStartJitter
+    #define ReconnectStartJitter  0                             // max random delay[mS] of the 1st attempt (0 - none)
+  #endif  //ReconnectStartJitter
+  #ifndef ReconnectTick
+    #define ReconnectTick       100                             // period[mS] of <WiFiTimeOut> calls during a connection window
+  #endif  //ReconnectTick
+  #ifndef EEPROMslotsAddress
+    #define EEPROMslotsAddress  0x0080                          // EEPROM location of credential slots (<CredSlots>*84 bytes, <CredSlots> > 1)
+  #endif  //EEPROMslotsAddress
+  #ifndef CommitIdleTime
+    #define CommitIdleTime      200                             // quiet time[mS] before a deferred commit <_DEFERCOMMIT>
+  #endif  //CommitIdleTime
+  #ifndef CommandQueueLen
+    #define CommandQueueLen     4                               // commands waiting for <ServiceCommands> (power of 2) <_CMDQUEUE>
+  #endif  //CommandQueueLen
+  #ifndef JournalSectors
+    #define JournalSectors      3                               // flash sectors (4KB each) of the record journal <_JOURNALSTORE>
+  #endif  //JournalSectors
+  #ifndef JournalFirstSector
+    #define JournalFirstSector  0                               // 1st journal sector, 0 - the <JournalSectors> below the EEPROM sector
+  #endif  //JournalFirstSector                                  // sectors must lie between file system end (_FS_end) and EEPROM,
+                                                                // else <begin> does not mount the journal (shrink the file system)
+  #ifndef SlotDefaultPriority
+    #define SlotDefaultPriority 100                             // priority of a new credential slot (0 lowest - 255 highest)
+  #endif  //SlotDefaultPriority
+  #ifndef SlotMinRSSI
+    #define SlotMinRSSI         -90                             // weaker APs[dBm] are not selected
+  #endif  //SlotMinRSSI
+  #ifndef LeaseDefaultTime
+    #define LeaseDefaultTime    7200                            // lease time[S] assumed when DHCP server's is unknown
+  #endif  //LeaseDefaultTime
+  #ifndef ARPprobeWait
+    #define ARPprobeWait        200                             // wait[mS] for a reply to the lease ARP conflict probe
+  #endif  //ARPprobeWait
 
   //
   // Part C - Common definition for library and calling methods
@@ -85,6 +193,48 @@
     LedSDfailure=6,         // 6 - Error opening SD file
     LedTBD7=7               // 7 - not in use
   };
+  enum  Codes4Lease {       // status of cached DHCP lease <_LEASECACHE>
+    LeaseNone=0,            // 0 - DHCP in use
+    LeaseApplied=1,         // 1 - cached lease applied by <WiFi.config>, waiting for link
+    LeaseProbing=2,         // 2 - ARP conflict probe sent
+    LeaseInUse=3,           // 3 - probe passed, cached lease in use (back to DHCP half way to its expiry)
+    LeaseToKeep=4           // 4 - DHCP lease not kept yet, <ServiceEEPROM> keeps it once the clock is set
+  };
+  enum  Codes4Reconnect {   // reconnect policies, wait between connection windows of <ConnTimeOutRep> ticks
+    ReconnectFixed=0,       // 0 - fixed wait <ReconnectBase>
+    ReconnectExpJitter=1,   // 1 - exponential with full jitter: random(0..min(<ReconnectCap>,<ReconnectBase>*2^n))
+    ReconnectCapped=2,      // 2 - exponential capped: min(<ReconnectCap>,<ReconnectBase>*2^n)
+    ReconnectCustom=3       // 3 - user function <ReconnectPolicyCB>
+  };
+  enum  Codes4ConnPhase {   // phases of a connection attempt, time stamped by <MarkPhase>
+    PhDisconnect=0,         // 0 - previous link down
+    PhBegin=1,              // 1 - <WiFi.begin> issued (credentials fetched and selected)
+    PhAssocAuth=2,          // 2 - associated and authenticated (SDK reports both by one event)
+    PhGotIP=3,              // 3 - IP assigned
+    PhStaticIP=4,           // 4 - static IP / cached lease configured and probed
+    PhCredUpdate=5,         // 5 - credentials updated
+    PhNTPsync=6,            // 6 - network time set
+    PhaseCount=7
+  };
+  enum  Codes4Record {      // library records kept in the flash journal <_JOURNALSTORE>, keys of <WifiNetJournal>
+    RecCred=0,              // 0 - credentials record, EEPROM 0x0000
+    RecIP=1,                // 1 - IP string at <EEPROMipAddress>
+    RecLease=2,             // 2 - DHCP lease at <EEPROMleaseAddress> (<_LEASECACHE>)
+    RecSlot=3,              // 3 ... 3+<CredSlots>-1 - credential slots at <EEPROMslotsAddress> (<CredSlots> > 1)
+    RecPmk=RecSlot+CredSlots  // next - cached PMK at <EEPROMpmkAddress> (<_PMKCACHE>)
+  };
+  enum  Codes4StaEvent {    // station events latched by <WifiNet> event handlers
+    EvGotIP=0x01,           // IP assigned to station
+    EvDisconnected=0x02,    // station disconnected from AP
+    EvAuthChanged=0x04      // AP authentication mode changed
+  };
+  enum  Codes4Command {     // commands posted by web handlers, run by <ServiceCommands> <_CMDQUEUE>
+    CmdNone=0,              // 0 - none
+    CmdStoreCred=1,         // 1 - store the credentials of the command, then reset (<activeTimeEvent> 4)
+    CmdReset=2,             // 2 - reset the platform (<activeTimeEvent> 4)
+    CmdErase=3,             // 3 - clear the EEPROM credentials
+    CmdRescan=4             // 4 - start the connection again (<startWiFi>)
+  };
   static const char _G3[] PROGMEM = " ";
   static const char _G4[] PROGMEM = "\n";
   static const char _G7[] PROGMEM = "Error";
@@ -0,0 +1,106 @@
+/*
+ * WifiNetDns.cpp captive portal DNS responder of the soft AP for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * constructor:   WifiNetDns
+ * methods:       begin; stop; active; service; answer
+ *
+ */
+
+#include  "Arduino.h"
+#include  "WifiNetDns.h"
+
+// **************************************************************************************** //
+WifiNetDns::WifiNetDns() {
+  _IP = 0;
+  Queries = 0;
+  Answered = 0;
+  Dropped = 0;
+}     // end of WifiNetDns
+
+// **************************************************************************************** //
+bool  WifiNetDns::begin(uint32_t IP) {
+  /*
+    * start answering with address <IP> (network order, as <IPAddress>) on <CaptiveDnsPort>
+    * returns  0 no address or the port could not be opened
+    */
+  if ( !IP ) return false;
+  if ( _IP ) _Udp.stop();
+  _IP = _Udp.begin(CaptiveDnsPort) ? IP : 0;
+  return  _IP != 0;
+}     // end of begin
+
+// **************************************************************************************** //
+void  WifiNetDns::stop() {
+  if ( !_IP ) return;
+  _Udp.stop();
+  _IP = 0;
+}     // end of stop
+
+bool  WifiNetDns::active() {
+  return  _IP != 0;
+}     // end of active
+
+// **************************************************************************************** //
+uint8_t  WifiNetDns::service() {
+  /*
+    * answer up to <CaptiveDnsBurst> waiting queries, for loop()
+    * returns  queries answered
+    */
+  uint8_t   sent = 0;
+  if ( !_IP ) return 0;
+  for ( uint8_t q=0; q<CaptiveDnsBurst; q++ ) {
+    if ( _Udp.parsePacket() <= 0 ) break;
+    uint8_t   pkt[CaptiveDnsLen];
+    int       len = _Udp.read(pkt, CaptiveDnsLen-16);       // room for the record
+    Queries++;
+    uint16_t  out = len>0 ? answer(pkt, len, sizeof(pkt), _IP) : 0;
+    if ( !out || !_Udp.beginPacket(_Udp.remoteIP(), _Udp.remotePort()) ) {
+      Dropped++;
+      continue;
+    }
+    _Udp.write(pkt, out);
+    if ( _Udp.endPacket() ) { Answered++; sent++; }
+    else                    Dropped++;
+  }
+  return  sent;
+}     // end of service
+
+// **************************************************************************************** //
+uint16_t  WifiNetDns::answer(uint8_t* Pkt, uint16_t Len, uint16_t Cap, uint32_t IP) {
+  /*
+    * turn query <Pkt> of <Len> bytes into its response in place, <Cap> bytes of buffer, answer address <IP>
+    * returns  length of the response, 0 - drop
+    */
+  if ( Len < 12 || (Pkt[2] & 0x80) ) return 0;          // short, or a response
+  uint8_t   rd = Pkt[2] & 0x01;
+  if ( (Pkt[2] & 0x78) || Pkt[4] || Pkt[5]!=1 ) {        // opcode other than QUERY, or not one question
+    Pkt[2] = 0x80 | (Pkt[2] & 0x78) | rd;                 // QR, opcode kept
+    Pkt[3] = 0x04;                                        // NOTIMP
+    memset(Pkt+4, 0, 8);
+    return  12;
+  }
+  uint16_t  p = 12;                                       // walk the name: labels, no compression in a question
+  while ( p < Len && Pkt[p] ) {
+    if ( Pkt[p] > 63 || p+Pkt[p]+1 > 12+255 ) return 0;
+    p += Pkt[p]+1;
+  }
+  if ( p+5 > Len ) return 0;                              // root label, type and class
+  uint16_t  type = (Pkt[p+1]<<8) | Pkt[p+2];
+  uint16_t  cls = (Pkt[p+3]<<8) | Pkt[p+4];
+  p += 5;                                                 // end of the question, the rest is cut
+  bool      a = (type==1 || type==255) && (cls==1 || cls==255);
+  if ( a && p+16 > Cap ) return 0;
+  Pkt[2] = 0x84 | rd;                                     // QR, AA, RD echoed
+  Pkt[3] = 0x00;                                          // NOERROR, no recursion available
+  Pkt[6] = 0; Pkt[7] = a;                                 // answers
+  memset(Pkt+8, 0, 4);                                    // no authority, no additional
+  if ( !a ) return p;
+  static const uint8_t RR[] PROGMEM = { 0xC0, 0x0C, 0, 1, 0, 1,   // name at the question, A, IN
+                                        (CaptiveDnsTtl>>24) & 0xFF, (CaptiveDnsTtl>>16) & 0xFF,
+                                        (CaptiveDnsTtl>>8) & 0xFF, CaptiveDnsTtl & 0xFF, 0, 4 };
+  memcpy_P(Pkt+p, RR, sizeof(RR));
+  p += sizeof(RR);
+  for ( uint8_t b=0; b<4; b++ ) Pkt[p++] = (IP >> (8*b)) & 0xFF;   // first octet in the low byte
+  return  p;
+}     // end of answer
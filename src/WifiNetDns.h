@@ -0,0 +1,56 @@
+#pragma once
+/*
+ * WifiNetDns.h captive portal DNS responder of the soft AP for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * while the soft AP waits for credentials (<Configure_OTA>, <Client_Connect_OTA>) every name resolves to the
+ * soft AP address, so the phone's connectivity probe reaches the credential form and the OS opens it by itself
+ * instead of the technician typing 192.168.4.1. <WifiNet> starts it with the soft AP and stops it when the
+ * status leaves those states; <WifiNet::ServiceDNS> in loop() answers the waiting queries.
+ *
+ *    A / ANY IN query    - one A record, the soft AP address, TTL <CaptiveDnsTtl>
+ *    other type / class  - NOERROR with no record (AAAA too), the client then asks for A
+ *    other opcode        - NOTIMP, header only
+ *    response, malformed - dropped
+ *
+ * the query is answered in place in one buffer of <CaptiveDnsLen> bytes on the stack: the header is rewritten,
+ * the question kept, anything after it (EDNS) cut and the record appended; no allocation, no name copy.
+ * statistics: <Queries>, <Answered>, <Dropped>
+ */
+#ifndef WifiNetDns_h
+  #define WifiNetDns_h
+
+  #include  "Arduino.h"
+  #include  <WiFiUdp.h>
+
+  #ifndef CaptiveDnsPort
+    #define CaptiveDnsPort  53              // UDP port of the responder
+  #endif  //CaptiveDnsPort
+  #ifndef CaptiveDnsTtl
+    #define CaptiveDnsTtl   60              // [S] TTL of the answer
+  #endif  //CaptiveDnsTtl
+  #ifndef CaptiveDnsLen
+    #define CaptiveDnsLen   300             // [bytes] query buffer: a name of 255, header, type, class and the record
+  #endif  //CaptiveDnsLen
+  #ifndef CaptiveDnsBurst
+    #define CaptiveDnsBurst 4               // queries answered by one <service> call
+  #endif  //CaptiveDnsBurst
+  static_assert(CaptiveDnsLen>=12+16+6 && CaptiveDnsLen<=512, "<CaptiveDnsLen> 34...512");
+
+  class WifiNetDns {
+    public:
+      WifiNetDns();
+      bool        begin(uint32_t IP);
+      void        stop();
+      bool        active();
+      uint8_t     service();
+      static uint16_t answer(uint8_t* Pkt, uint16_t Len, uint16_t Cap, uint32_t IP);
+      uint32_t    Queries;              // packets received
+      uint32_t    Answered;             // responses sent
+      uint32_t    Dropped;              // packets not answered
+    private:
+      WiFiUDP     _Udp;
+      uint32_t    _IP;                  // soft AP address, network order, 0 - stopped
+  };
+
+#endif  //WifiNetDns_h
@@ -0,0 +1,132 @@
+#pragma once
+/*
+ * WifiNetHal.h thin hardware abstraction for WifiNet library: radio, persistent store, raw flash, clock and log sink
+ * Created by Sachi Gerlitz
+ *
+ * <WifiNet.cpp> calls the Arduino ESP8266 core API (<WiFi>, <EEPROM>, <millis>, <Serial>, ...) directly.
+ * On the device these are the core objects and nothing here is in the path.
+ * On a host the compatibility headers in extras/native route the same API to the interfaces below,
+ * so the library builds unchanged (PlatformIO env:native) and is driven by a POSIX or scripted binding.
+ * The ESP8266 bindings let host harness code run on board against the real core.
+ *
+ */
+#ifndef WifiNetHal_h
+  #define WifiNetHal_h
+
+  #include  <stdint.h>
+  #include  <stddef.h>
+  #include  <time.h>
+
+  class WifiNetRadio {                  // station and soft AP radio
+    public:
+      virtual ~WifiNetRadio() {}
+      virtual bool      begin(const char* Ssid, const char* Pass, uint8_t Channel, const uint8_t* Bssid)=0; // 0 channel - scan
+      virtual void      disconnect()=0;
+      virtual bool      config(uint32_t IP, uint32_t Gateway, uint32_t Mask, uint32_t Dns)=0;  // 0 IP - DHCP
+      virtual uint8_t   status()=0;                 // <wl_status_t> values
+      virtual uint32_t  localIP()=0;
+      virtual uint32_t  gatewayIP()=0;
+      virtual uint32_t  subnetMask()=0;
+      virtual uint32_t  dnsIP()=0;
+      virtual int32_t   RSSI()=0;
+      virtual uint8_t   channel()=0;
+      virtual const uint8_t* BSSID()=0;
+      virtual int8_t    scanNetworks()=0;           // number of APs found
+      virtual bool      scanResult(uint8_t Index, const char** Ssid, int32_t* Rssi, uint8_t* Channel, const uint8_t** Bssid)=0;
+      virtual bool      softAP(const char* Ssid)=0;
+      virtual uint32_t  softAPIP()=0;
+  };
+  class WifiNetStore {                  // byte addressed persistent store (EEPROM emulation)
+    public:
+      virtual ~WifiNetStore() {}
+      virtual size_t    size()=0;
+      virtual uint8_t*  data()=0;                   // RAM image, written back by <commit>
+      virtual bool      commit()=0;
+  };
+  class WifiNetFlash {                  // raw flash sectors of the record journal <WifiNetJournal>
+    public:
+      virtual ~WifiNetFlash() {}
+      virtual bool      eraseSector(uint32_t Sector)=0;                           // all bytes to 0xFF
+      virtual bool      write(uint32_t Address, const uint32_t* Data, size_t Len)=0; // 4 byte aligned, clears bits only
+      virtual bool      read(uint32_t Address, uint32_t* Data, size_t Len)=0;
+  };
+  class WifiNetClock {                  // monotonic and wall clock
+    public:
+      virtual ~WifiNetClock() {}
+      virtual uint32_t  millis()=0;
+      virtual void      delay(uint32_t Ms)=0;
+      virtual time_t    now()=0;                    // epoch[S], values below 2020 - not set
+      virtual void      setNow(time_t Epoch)=0;
+  };
+  class WifiNetLog {                    // log sink of <Serial>
+    public:
+      virtual ~WifiNetLog() {}
+      virtual size_t    write(const uint8_t* Buf, size_t Len)=0;
+  };
+  struct  WifiNetHal {                  // one binding set
+    WifiNetRadio* Radio;
+    WifiNetStore* Store;
+    WifiNetClock* Clock;
+    WifiNetLog*   Log;
+    WifiNetFlash* Flash;                // nullptr - binding default
+  };
+
+  #if defined(ARDUINO_ARCH_ESP8266)
+    //
+    // ESP8266 bindings over the Arduino core
+    //
+    #include  <Arduino.h>
+    #include  <ESP8266WiFi.h>
+    #include  <EEPROM.h>
+    #include  <sys/time.h>
+    class WifiNetRadioESP8266 : public WifiNetRadio {
+      public:
+        bool      begin(const char* Ssid, const char* Pass, uint8_t Channel, const uint8_t* Bssid) {
+          return  Channel ? WiFi.begin(Ssid, Pass, Channel, Bssid, true)!=WL_CONNECT_FAILED : WiFi.begin(Ssid, Pass)!=WL_CONNECT_FAILED; }
+        void      disconnect()  { WiFi.disconnect(); }
+        bool      config(uint32_t IP, uint32_t Gateway, uint32_t Mask, uint32_t Dns) {
+          return  WiFi.config(IPAddress(IP), IPAddress(Gateway), IPAddress(Mask), IPAddress(Dns)); }
+        uint8_t   status()      { return WiFi.status(); }
+        uint32_t  localIP()     { return WiFi.localIP(); }
+        uint32_t  gatewayIP()   { return WiFi.gatewayIP(); }
+        uint32_t  subnetMask()  { return WiFi.subnetMask(); }
+        uint32_t  dnsIP()       { return WiFi.dnsIP(); }
+        int32_t   RSSI()        { return WiFi.RSSI(); }
+        uint8_t   channel()     { return WiFi.channel(); }
+        const uint8_t* BSSID()  { return WiFi.BSSID(); }
+        int8_t    scanNetworks(){ return WiFi.scanNetworks(false,false); }
+        bool      scanResult(uint8_t Index, const char** Ssid, int32_t* Rssi, uint8_t* Channel, const uint8_t** Bssid) {
+          _ScanSsid = WiFi.SSID(Index);
+          *Ssid = _ScanSsid.c_str(); *Rssi = WiFi.RSSI(Index); *Channel = WiFi.channel(Index); *Bssid = WiFi.BSSID(Index);
+          return  true; }
+        bool      softAP(const char* Ssid)  { return WiFi.softAP(Ssid); }
+        uint32_t  softAPIP()    { return WiFi.softAPIP(); }
+      private:
+        String    _ScanSsid;
+    };
+    class WifiNetStoreESP8266 : public WifiNetStore {
+      public:
+        size_t    size()        { return EEPROM.length(); }
+        uint8_t*  data()        { return EEPROM.getDataPtr(); }
+        bool      commit()      { return EEPROM.commit(); }
+    };
+    class WifiNetFlashESP8266 : public WifiNetFlash {
+      public:
+        bool      eraseSector(uint32_t Sector)  { return ESP.flashEraseSector(Sector); }
+        bool      write(uint32_t Address, const uint32_t* Data, size_t Len) { return ESP.flashWrite(Address, Data, Len); }
+        bool      read(uint32_t Address, uint32_t* Data, size_t Len)        { return ESP.flashRead(Address, Data, Len); }
+    };
+    class WifiNetClockESP8266 : public WifiNetClock {
+      public:
+        uint32_t  millis()      { return ::millis(); }
+        void      delay(uint32_t Ms)  { ::delay(Ms); }
+        time_t    now()         { return time(nullptr); }
+        void      setNow(time_t Epoch)  { struct timeval tv = { Epoch, 0 }; settimeofday(&tv, nullptr); }
+    };
+    class WifiNetLogESP8266 : public WifiNetLog {
+      public:
+        size_t    write(const uint8_t* Buf, size_t Len) { return Serial.write(Buf, Len); }
+    };
+  #endif  //ARDUINO_ARCH_ESP8266
+
+#endif  //WifiNetHal_h
@@ -0,0 +1,277 @@
+/*
+ * WifiNetJournal.cpp log structured record store over raw flash sectors for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * constructor:   WifiNetJournal
+ * methods:       begin; write; read; remove; activate; append; rotate; compact; scan; blank; erase; fetch
+ *
+ */
+
+#include  "Arduino.h"
+#include  "ESP8266WiFi.h"             // <ESP> flash access
+#include  "WifiNetJournal.h"
+
+#define   JournalPad(L)   ( ((L)+3) & ~3u )                     // record data length in flash
+#define   JournalHdr      8                                     // sector header[bytes]
+#define   JournalBufWords ( (sizeof(JournalRecord)+JournalMaxRecord+3)/4 )
+
+// **************************************************************************************** //
+static uint32_t JournalCrc(uint32_t Crc, const uint8_t* Data, size_t Len) {
+  /*
+    * CRC-32 (IEEE, reflected), continued from <Crc> (start with 0xFFFFFFFF, complement at the end)
+    */
+  while ( Len-- ) {
+    Crc ^= *Data++;
+    for ( uint8_t b=0; b<8; b++ ) Crc = ( Crc & 1 ) ? (Crc >> 1) ^ 0xEDB88320 : (Crc >> 1);
+  }
+  return  Crc;
+}     // end of JournalCrc
+
+static uint32_t RecordCrc(const JournalRecord* R, const uint8_t* Data) {
+  JournalRecord H = *R;
+  H.Crc = 0;
+  return  ~JournalCrc(JournalCrc(0xFFFFFFFF, (const uint8_t*)&H, sizeof(H)), Data, R->Len);
+}     // end of RecordCrc
+
+// **************************************************************************************** //
+WifiNetJournal::WifiNetJournal() {
+  _First = 0;
+  _Count = 0;
+  _Active = 0xFF;
+  _WritePos = 0;
+  _Seq = 0;
+  Appends = 0;
+  Erases = 0;
+  memset(_Gen, 0, sizeof(_Gen));
+  memset(_Addr, 0, sizeof(_Addr));
+}     // end of WifiNetJournal
+
+// **************************************************************************************** //
+bool  WifiNetJournal::begin(uint32_t FirstSector, uint8_t Sectors) {
+  /*
+    * mount the journal on flash sectors <FirstSector>...+<Sectors>-1 (2...<JournalMaxSectors>)
+    * replays the sectors oldest generation first, so the index ends on the latest version of each key
+    * sectors with no valid header which are not blank are left overs of a torn erase or header write: erased
+    * returns  0 for bad geometry or flash error
+    */
+  if ( Sectors<2 || Sectors>JournalMaxSectors ) return  false;
+  _First = FirstSector;
+  _Count = Sectors;
+  _Active = 0xFF;
+  _WritePos = 0;
+  _Seq = 0;
+  memset(_Addr, 0, sizeof(_Addr));
+  bool  ok = true;
+  for ( uint8_t s=0; s<_Count; s++ ) {
+    uint32_t  hdr[2];
+    _Gen[s] = 0;
+    if ( !ESP.flashRead((_First+s)*JournalSectorSize, hdr, sizeof(hdr)) ) return  false;
+    if ( hdr[1]==JournalMagic && hdr[0]!=0 && hdr[0]!=0xFFFFFFFF ) _Gen[s] = hdr[0];
+    else if ( !blank(s,0) ) ok &= erase(s);
+  }   // end of sector headers
+  uint32_t  last = 0;
+  for ( ;; ) {                                  // replay by generation
+    uint8_t   next = 0xFF;
+    for ( uint8_t s=0; s<_Count; s++ ) {
+      if ( _Gen[s]>last && ( next==0xFF || _Gen[s]<_Gen[next] ) ) next = s;
+    }
+    if ( next==0xFF ) break;
+    last = _Gen[next];
+    _Active = next;
+    _WritePos = scan(next);
+  }   // end of replay
+  if ( _Active==0xFF ) return  ok && activate(0);   // empty journal
+  for ( uint8_t s=0; s<_Count; s++ ) if ( _Gen[s]==0 ) return  ok;
+  return  ok && compact();                      // power lost between rotation and compaction
+}     // end of begin
+
+// **************************************************************************************** //
+bool  WifiNetJournal::write(uint8_t Key, const void* Data, uint16_t Len) {
+  /*
+    * append a new version of record <Key>; an unchanged record is not written again
+    * returns  0 for bad key / length or flash error (the previous version stays in effect)
+    */
+  if ( Key>=JournalKeys || Len==0 || Len>JournalMaxRecord ) return  false;
+  if ( _Addr[Key] ) {
+    JournalRecord R;
+    uint32_t      old[JournalBufWords];
+    if ( fetch(_Addr[Key], &R, old) && R.Len==Len && memcmp(old, Data, Len)==0 ) return  true;
+  }
+  return  append(Key, Data, Len);
+}     // end of write
+
+// **************************************************************************************** //
+int16_t WifiNetJournal::read(uint8_t Key, void* Data, uint16_t MaxLen) {
+  /*
+    * copy the latest version of record <Key> to <Data>, up to <MaxLen> bytes
+    * returns  record length (may exceed <MaxLen>), -1 for no record
+    */
+  JournalRecord R;
+  uint32_t      buf[JournalBufWords];
+  if ( Key>=JournalKeys || !_Addr[Key] || !fetch(_Addr[Key], &R, buf) ) return  -1;
+  memcpy(Data, buf, R.Len<MaxLen ? R.Len : MaxLen);
+  return  R.Len;
+}     // end of read
+
+// **************************************************************************************** //
+bool  WifiNetJournal::remove(uint8_t Key) {
+  /*
+    * append an empty version of record <Key>, shadowing the older ones until they are compacted away
+    */
+  if ( Key>=JournalKeys ) return  false;
+  if ( !_Addr[Key] ) return  true;
+  return  append(Key, nullptr, 0);
+}     // end of remove
+
+// **************************************************************************************** //
+bool  WifiNetJournal::activate(uint8_t Sector) {
+  /*
+    * open erased <Sector> for appending with the next generation
+    */
+  uint32_t  gen = 0;
+  for ( uint8_t s=0; s<_Count; s++ ) if ( _Gen[s]>gen ) gen = _Gen[s];
+  uint32_t  hdr[2] = { gen+1, JournalMagic };    // magic last: a complete magic means a complete generation
+  _Active = Sector;
+  _WritePos = JournalSectorSize;                // sealed unless the header is written
+  if ( !ESP.flashWrite((_First+Sector)*JournalSectorSize, hdr, sizeof(hdr)) ) return  false;
+  _Gen[Sector] = gen+1;
+  _WritePos = JournalHdr;
+  return  true;
+}     // end of activate
+
+// **************************************************************************************** //
+bool  WifiNetJournal::append(uint8_t Key, const void* Data, uint16_t Len) {
+  /*
+    * write one record at the end of the active sector (rotating first when it does not fit) and index it
+    * header and data go by one flash write, a write cut short fails CRC at next <begin>
+    */
+  uint16_t  size = sizeof(JournalRecord) + JournalPad(Len);
+  if ( _Active==0xFF || _WritePos+size > JournalSectorSize ) {
+    if ( !rotate() || _WritePos+size > JournalSectorSize ) return  false;
+  }
+  uint32_t  buf[JournalBufWords];
+  JournalRecord* R = (JournalRecord*)buf;
+  memset(buf, 0xFF, size);
+  R->Seq = _Seq+1;
+  R->Key = Key;
+  R->Spare = 0xFF;
+  R->Len = Len;
+  if ( Len ) memcpy(R+1, Data, Len);
+  R->Crc = RecordCrc(R, (const uint8_t*)(R+1));
+  uint32_t  address = (_First+_Active)*JournalSectorSize + _WritePos;
+  _WritePos += size;                            // a failed write leaves the space unusable anyway
+  if ( !ESP.flashWrite(address, buf, size) ) return  false;
+  _Seq++;
+  _Addr[Key] = Len ? address : 0;
+  Appends++;
+  return  true;
+}     // end of append
+
+// **************************************************************************************** //
+bool  WifiNetJournal::rotate() {
+  /*
+    * continue on the next erased sector (ring order spreads the erases), then compact the oldest
+    * sector so one erased sector is kept for the next rotation
+    */
+  for ( uint8_t i=1; i<=_Count; i++ ) {
+    uint8_t s = ( _Active==0xFF ? i : _Active+i ) % _Count;
+    if ( _Gen[s] ) continue;
+    if ( !activate(s) ) return  false;
+    for ( uint8_t t=0; t<_Count; t++ ) if ( _Gen[t]==0 ) return  true;
+    return  compact();
+  }   // end of sector search
+  return  false;                                // no erased sector
+}     // end of rotate
+
+// **************************************************************************************** //
+bool  WifiNetJournal::compact() {
+  /*
+    * copy the live records of the oldest sector to the active one and erase it
+    * live data (<JournalKeys> records at most) always fits a fresh sector; power lost midway leaves
+    * both copies, the newer sequence wins at <begin>
+    */
+  uint8_t   oldest = 0xFF;
+  for ( uint8_t s=0; s<_Count; s++ ) {
+    if ( s!=_Active && _Gen[s] && ( oldest==0xFF || _Gen[s]<_Gen[oldest] ) ) oldest = s;
+  }
+  if ( oldest==0xFF ) return  false;
+  uint32_t  from = (_First+oldest)*JournalSectorSize;
+  for ( uint8_t k=0; k<JournalKeys; k++ ) {
+    if ( !_Addr[k] || _Addr[k]<from || _Addr[k]>=from+JournalSectorSize ) continue;
+    JournalRecord R;
+    uint32_t      buf[JournalBufWords];
+    if ( !fetch(_Addr[k], &R, buf) ) return  false;
+    if ( _WritePos + sizeof(JournalRecord) + JournalPad(R.Len) > JournalSectorSize ) return  false;
+    if ( !append(k, buf, R.Len) ) return  false;
+  }   // end of live records
+  return  erase(oldest);
+}     // end of compact
+
+// **************************************************************************************** //
+uint16_t  WifiNetJournal::scan(uint8_t Sector) {
+  /*
+    * index the records of <Sector> in order
+    * after a bad (torn) record the scan resynchronises on the next valid one, 4 bytes at a time;
+    * the sector ends where the rest of it is erased
+    * returns  offset of the erased tail (next append), <JournalSectorSize> for a full sector
+    */
+  uint16_t  pos = JournalHdr;
+  uint32_t  base = (_First+Sector)*JournalSectorSize;
+  bool      torn = false;
+  while ( pos + sizeof(JournalRecord) <= JournalSectorSize ) {
+    JournalRecord R;
+    uint32_t      buf[JournalBufWords];
+    if ( !ESP.flashRead(base+pos, (uint32_t*)&R, sizeof(R)) ) return  JournalSectorSize;
+    if ( R.Seq==0xFFFFFFFF && R.Key==0xFF && R.Len==0xFFFF && R.Crc==0xFFFFFFFF && ( !torn || blank(Sector,pos) ) ) return  pos;
+    if ( !fetch(base+pos, &R, buf) ) {          // torn record (or erased words inside one)
+      torn = true;
+      pos += 4;
+      continue;
+    }
+    torn = false;
+    if ( R.Seq>_Seq ) _Seq = R.Seq;
+    _Addr[R.Key] = R.Len ? base+pos : 0;
+    pos += sizeof(JournalRecord) + JournalPad(R.Len);
+  }   // end of records
+  return  JournalSectorSize;
+}     // end of scan
+
+// **************************************************************************************** //
+bool  WifiNetJournal::blank(uint8_t Sector, uint16_t From) {
+  /*
+    * returns  1 when <Sector> is erased from offset <From> (4 byte aligned) to its end
+    */
+  uint32_t  buf[32];
+  for ( uint32_t pos=From; pos<JournalSectorSize; pos+=sizeof(buf) ) {
+    uint32_t  len = JournalSectorSize-pos < sizeof(buf) ? JournalSectorSize-pos : sizeof(buf);
+    if ( !ESP.flashRead((_First+Sector)*JournalSectorSize+pos, buf, len) ) return  false;
+    for ( uint8_t i=0; i<len/4; i++ ) if ( buf[i]!=0xFFFFFFFF ) return  false;
+  }
+  return  true;
+}     // end of blank
+
+// **************************************************************************************** //
+bool  WifiNetJournal::erase(uint8_t Sector) {
+  /*
+    * the magic is cleared first, an interrupted erase must not leave a header that looks valid
+    */
+  uint32_t  none = 0;
+  _Gen[Sector] = 0;
+  Erases++;
+  ESP.flashWrite((_First+Sector)*JournalSectorSize+4, &none, sizeof(none));
+  return  ESP.flashEraseSector(_First+Sector);
+}     // end of erase
+
+// **************************************************************************************** //
+bool  WifiNetJournal::fetch(uint32_t Address, JournalRecord* R, uint32_t* Data) {
+  /*
+    * read and check the record at <Address>: header to <R>, data to <Data> (<JournalBufWords> words)
+    * returns  0 for bad key / length or CRC
+    */
+  uint32_t  offset = Address % JournalSectorSize;
+  if ( !ESP.flashRead(Address, (uint32_t*)R, sizeof(JournalRecord)) ) return  false;
+  if ( R->Key>=JournalKeys || R->Spare!=0xFF || R->Len>JournalMaxRecord ) return  false;
+  if ( offset + sizeof(JournalRecord) + JournalPad(R->Len) > JournalSectorSize ) return  false;
+  if ( R->Len && !ESP.flashRead(Address+sizeof(JournalRecord), Data, JournalPad(R->Len)) ) return  false;
+  return  R->Crc == RecordCrc(R, (const uint8_t*)Data);
+}     // end of fetch
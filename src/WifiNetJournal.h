@@ -0,0 +1,72 @@
+#pragma once
+/*
+ * WifiNetJournal.h log structured record store over raw flash sectors for WifiNet library <_JOURNALSTORE>
+ * Created by Sachi Gerlitz
+ *
+ * records are appended, never rewritten in place: a new version of a record goes after the last one
+ * and the latest valid version wins. The journal rotates over <Sectors> flash sectors, so each sector is
+ * erased once per ~4KB of appended records instead of once per EEPROM commit.
+ *
+ * sector layout    [Generation][Magic] [record] [record] ... 0xFF (erased)
+ * record layout    [Seq][Key][0xFF][Len][Crc] [Len data bytes, padded to 4]    Crc - CRC32 of header (Crc as 0) and data
+ *
+ * one erased sector is kept as the next active one. When the active sector is full the spare becomes active
+ * and the oldest sector is compacted: its live records are copied to the active sector, then it is erased.
+ * power loss: <begin> replays the sectors by generation; a torn record fails CRC and is skipped (appends go on
+ * after it), a torn sector header or erase leaves a sector that is erased again, an interrupted compaction is redone.
+ * a write interrupted by power loss reads back as the previous version of the record or as the new one.
+ * flash access by <ESP.flashEraseSector>/<flashWrite>/<flashRead> (host: <WifiNetHost().Flash>)
+ */
+#ifndef WifiNetJournal_h
+  #define WifiNetJournal_h
+
+  #include  "Arduino.h"
+
+  #define JournalSectorSize 4096            // flash sector[bytes]
+  #define JournalMagic      0x314A4E57      // "WNJ1"
+  #ifndef JournalKeys
+    #define JournalKeys     8               // record keys 0...<JournalKeys>-1
+  #endif  //JournalKeys
+  #ifndef JournalMaxRecord
+    #define JournalMaxRecord  128           // max record length[bytes]
+  #endif  //JournalMaxRecord
+  #ifndef JournalMaxSectors
+    #define JournalMaxSectors 8
+  #endif  //JournalMaxSectors
+
+  struct  JournalRecord {               // record header, <Len> data bytes follow (padded to 4)
+    uint32_t    Seq;                    // sequence number, grows by 1 with every append
+    uint8_t     Key;
+    uint8_t     Spare;                  // 0xFF
+    uint16_t    Len;                    // 0 - record removed
+    uint32_t    Crc;
+  };
+
+  class WifiNetJournal {
+    public:
+      WifiNetJournal();
+      bool        begin(uint32_t FirstSector, uint8_t Sectors);       // mount: recover, index the latest records
+      bool        write(uint8_t Key, const void* Data, uint16_t Len);
+      int16_t     read(uint8_t Key, void* Data, uint16_t MaxLen);     // length read, -1 no record
+      bool        remove(uint8_t Key);
+      uint32_t    Appends;              // records appended since <begin>, compaction copies included
+      uint32_t    Erases;               // sectors erased since <begin>
+    private:
+      uint32_t    _First;               // first flash sector
+      uint8_t     _Count;               // number of sectors
+      uint8_t     _Active;              // sector being appended, 0xFF none
+      uint16_t    _WritePos;            // append offset in <_Active>
+      uint32_t    _Seq;                 // last record sequence number
+      uint32_t    _Gen[JournalMaxSectors];  // sector generation, 0 erased
+      uint32_t    _Addr[JournalKeys];   // flash address of the latest version of each key, 0 none
+      bool        activate(uint8_t Sector);
+      bool        append(uint8_t Key, const void* Data, uint16_t Len);
+      bool        rotate();
+      bool        compact();
+      uint16_t    scan(uint8_t Sector);
+      bool        blank(uint8_t Sector, uint16_t From);
+      bool        erase(uint8_t Sector);
+      bool        fetch(uint32_t Address, JournalRecord* R, uint32_t* Data);
+  };
+
+#endif  //WifiNetJournal_h
@@ -0,0 +1,124 @@
+/*
+ * WifiNetPage.cpp rendering of compile time HTML page templates for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * methods:       begin; set; keep; length; render; rewind; value
+ *
+ */
+
+#include  "Arduino.h"
+#include  "WifiNetPage.h"
+
+// **************************************************************************************** //
+void  WifiNetPage::begin(const WifiNetTemplate& Template) {
+  /*
+    * start a page of <Template>, all slots empty
+    */
+  _T = &Template;
+  memset(_Val, 0, sizeof(_Val));
+  _OwnMask = 0;
+  _OwnUsed = 0;
+  rewind();
+}     // end of begin
+
+void  WifiNetPage::rewind() {
+  _Run = 0;
+  _InSlot = false;
+  _Offset = 0;
+  _ValLen = 0xFFFF;
+  _Sent = 0;
+}     // end of rewind
+
+// **************************************************************************************** //
+void  WifiNetPage::set(uint8_t Slot, const char* Value) {
+  /*
+    * <Value> (RAM or PROGMEM) is referred to, it has to outlive the page
+    */
+  if ( Slot>=PageSlots ) return;
+  _Val[Slot] = Value;
+  _OwnMask &= ~(1u<<Slot);
+}     // end of set
+
+bool  WifiNetPage::keep(uint8_t Slot, const char* Value) {
+  /*
+    * <Value> (RAM or PROGMEM) is copied into the page, cut to the room left in <PageOwnLen>; it is never
+    * referred to, so it may go away once <keep> returns
+    * returns  0 cut short, or not kept (no room left: the slot stays empty)
+    */
+  if ( Slot>=PageSlots ) return  false;
+  _Val[Slot] = nullptr;
+  _OwnMask &= ~(1u<<Slot);
+  if ( !Value ) return  true;
+  size_t  room = PageOwnLen-_OwnUsed;
+  if ( !room ) return  false;
+  size_t  len = strnlen_P(Value, room-1);
+  memcpy_P(_Own+_OwnUsed, Value, len);
+  _Own[_OwnUsed+len] = '\0';
+  _Val[Slot] = (const char*)(uintptr_t)_OwnUsed;        // offset: the page is copied by value into the response
+  _OwnMask |= 1u<<Slot;
+  _OwnUsed += len+1;
+  return  pgm_read_byte(Value+len)=='\0';
+}     // end of keep
+
+const char*  WifiNetPage::value(uint8_t Slot) const {
+  if ( Slot>=PageSlots ) return  nullptr;
+  return  _OwnMask & (1u<<Slot) ? _Own+(uintptr_t)_Val[Slot] : _Val[Slot];
+}     // end of value
+
+// **************************************************************************************** //
+size_t  WifiNetPage::length() const {
+  /*
+    * page length[bytes]: the constant text (known from the cut table) and the slot values
+    */
+  size_t  len = pgm_read_word(_T->Cut+_T->Runs-1);
+  for ( uint8_t r=0; r<_T->Runs-1; r++ ) {
+    const char* v = value(pgm_read_byte(_T->Slot+r));
+    if ( v ) len += strlen_P(v);
+  }
+  return  len;
+}     // end of length
+
+// **************************************************************************************** //
+size_t  WifiNetPage::render(uint8_t* Buf, size_t MaxLen) {
+  /*
+    * copy the next <MaxLen> bytes of the page to <Buf>: a constant run by one copy from flash, then the value
+    * of the slot after it; the cursor keeps the run and the offset in it, nothing is rescanned
+    * returns bytes written, 0 once the page was sent
+    */
+  const WifiNetTemplate&  T = *_T;
+  uint8_t   run = _Run;                                 // cursor in locals (<Buf> may alias the page)
+  bool      inSlot = _InSlot;
+  size_t    offset = _Offset, valLen = _ValLen;
+  size_t    out = 0;
+  while ( out < MaxLen && run < T.Runs ) {
+    const char* src;
+    size_t      len;
+    uint8_t     slot = pgm_read_byte(T.Slot+run);
+    if ( !inSlot ) {                                    // constant run
+      size_t  start = run ? pgm_read_word(T.Cut+run-1) : 0;
+      src = T.Text+start;
+      len = pgm_read_word(T.Cut+run)-start;
+    } else {                                            // slot value
+      src = value(slot);
+      if ( !src ) src = "";
+      if ( valLen==0xFFFF ) valLen = strlen_P(src);
+      len = valLen;
+    }
+    size_t  n = len-offset;
+    if ( n > MaxLen-out ) n = MaxLen-out;
+    memcpy_P(Buf+out, src+offset, n);
+    out += n;
+    offset += n;
+    if ( offset < len ) break;                          // buffer full mid-run
+    offset = 0;
+    valLen = 0xFFFF;
+    if ( inSlot || slot==PageNoSlot ) { inSlot = false; run++; }
+    else                                inSlot = true;
+  }   // end of runs
+  _Run = run;
+  _InSlot = inSlot;
+  _Offset = offset;
+  _ValLen = valLen;
+  _Sent += out;
+  return  out;
+}     // end of render
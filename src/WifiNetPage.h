@@ -0,0 +1,145 @@
+#pragma once
+/*
+ * WifiNetPage.h compile time HTML page templates for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * a template is one string literal: the constant HTML, with slot markers <Tpl...> where the values go
+ *
+ *    WifiNetPageDef(RelayPage, TplHead "<h1>Relay is " TplApp0 "</h1><h2>" TplApp1 " switches</h2>" TplTail);
+ *    RunWifi.RegisterPage(6, RelayPage);                                 // <option> 6 of <SendUtilityPage>
+ *    const char* Values[] = { RelayOn ? "on" : "off", Counter };      // copied into the page, <Counter> may be local
+ *    RunWifi.SendUtilityPage(request, SysClock, 6, Title, "", 200, Values, 2);
+ *
+ * the markers are taken out at compile time: flash keeps the constant runs joined into one text and a table of
+ * cuts (end of each run in the text, slot after it), so a page is rendered by one copy per constant run plus the
+ * slot values, and the text is never scanned for markers.
+ * <WifiNetPage> holds one page being rendered (template, slot values, cursor) and streams it in chunks of any size.
+ */
+#ifndef WifiNetPage_h
+  #define WifiNetPage_h
+
+  #include  "Arduino.h"
+
+  #ifndef PageOwnLen
+    #define PageOwnLen    160           // [bytes] of slot values copied into the page (time stamp, SSID, password, title...)
+  #endif  //PageOwnLen
+  static_assert(PageOwnLen<=255, "<PageOwnLen> up to 255");
+  #define PageSlots       16            // slot markers 0x10..0x1F
+  #define PageNoSlot      PageSlots     // last run of a template
+
+  enum  Codes4PageSlot {                // values of a utility page
+    SlotWhoAmI=0,                       // platform name
+    SlotVersion=1,                      // SW version
+    SlotStamp=2,                        // current time
+    SlotTitle=3,                        // page title <PageTitleName>
+    SlotFeedBack=4,                     // message from application <FeedBack>
+    SlotSsid=5,                         // SSID and password obtained by the credential form
+    SlotPass=6,
+    SlotAction=7,                       // credential form action (<CredSettingTrigger> without '/')
+    SlotSsidName=8,                     // credential form input field names
+    SlotPswdName=9,
+    SlotPrioName=10,
+    SlotApp=11                          // 1st of the application slots <TplApp0>..<TplApp4>
+  };
+  #define PageAppSlots    (PageSlots-SlotApp)
+
+  // slot markers, as separate literals (no hex digit run into the text)
+  #define TplWhoAmI       "\x10"
+  #define TplVersion      "\x11"
+  #define TplStamp        "\x12"
+  #define TplTitle        "\x13"
+  #define TplFeedBack     "\x14"
+  #define TplSsid         "\x15"
+  #define TplPass         "\x16"
+  #define TplAction       "\x17"
+  #define TplSsidName     "\x18"
+  #define TplPswdName     "\x19"
+  #define TplPrioName     "\x1A"
+  #define TplApp0         "\x1B"
+  #define TplApp1         "\x1C"
+  #define TplApp2         "\x1D"
+  #define TplApp3         "\x1E"
+  #define TplApp4         "\x1F"
+
+  // parts of the utility pages (color picker https://htmlcolorcodes.com/color-picker/)
+  #if _GZASSETS==1                      // style sheet served once and revalidated by ETag (WifiNetAssets.h)
+    #include  "WifiNetAssets.h"
+    #define TplStyle      "<link rel='stylesheet' href='" AssetCssPath "'></head>\n"
+  #else
+    #define TplStyle      "<style>body {background-color: #9DCDF4; font-family: Arial, Helvetica, Sans-Serif; Color: blue;}</style></head>\n"
+  #endif  //_GZASSETS
+  #define TplHead         "<html><head><title>ESP8266 Utilities</title>" TplStyle \
+                          "<body><h2>" TplWhoAmI " " TplVersion " " TplStamp "</h2><h1>" TplTitle "</h1>"
+  #define TplTail         "</body></html>"
+
+  namespace WifiNetTpl {
+    constexpr bool isSlot(char C) { return (uint8_t)C>=0x10 && (uint8_t)C<0x10+PageSlots; }
+    template<size_t N> constexpr uint8_t slots(const char (&S)[N]) {
+      uint8_t   n = 0;
+      for ( size_t i=0; i<N-1; i++ ) n += isSlot(S[i]);
+      return  n;
+    }
+    template<size_t N> constexpr uint16_t used(const char (&S)[N]) {
+      uint16_t  m = 0;
+      for ( size_t i=0; i<N-1; i++ ) if ( isSlot(S[i]) ) m |= 1u<<((uint8_t)S[i]-0x10);
+      return  m;
+    }
+    template<size_t N, uint8_t Slots> struct Blob {   // flash image of a template
+      char      Text[N];                // constant runs joined
+      uint16_t  Cut[Slots+1];           // end of run i in <Text>
+      uint8_t   Slot[Slots+1];          // slot after run i, <PageNoSlot> after the last
+    };
+    template<uint8_t Slots, size_t N> constexpr Blob<N,Slots> build(const char (&S)[N]) {
+      static_assert(N < 0xFFFF, "page template too long");
+      Blob<N,Slots> B = {};
+      uint16_t  len = 0;
+      uint8_t   run = 0;
+      for ( size_t i=0; i<N-1; i++ ) {
+        if ( isSlot(S[i]) ) { B.Cut[run] = len; B.Slot[run++] = (uint8_t)S[i]-0x10; }
+        else                B.Text[len++] = S[i];
+      }
+      B.Cut[run] = len;
+      B.Slot[run] = PageNoSlot;
+      return  B;
+    }
+  }   // end of WifiNetTpl
+
+  struct  WifiNetTemplate {             // a template in flash, see <WifiNetPageDef>
+    const char*     Text;
+    const uint16_t* Cut;
+    const uint8_t*  Slot;
+    uint8_t         Runs;
+    uint16_t        Used;               // slots in the template, bit per <Codes4PageSlot>
+  };
+
+  // declare template <Name> (a <WifiNetTemplate>) of string literal <Html>, built by the compiler
+  #define WifiNetPageDef(Name, Html) \
+    static constexpr auto Name##Blob PROGMEM = WifiNetTpl::build<WifiNetTpl::slots(Html)>(Html); \
+    static const WifiNetTemplate Name = { Name##Blob.Text, Name##Blob.Cut, Name##Blob.Slot, \
+                                          WifiNetTpl::slots(Html)+1, WifiNetTpl::used(Html) }
+
+  class WifiNetPage {
+    public:
+      void          begin(const WifiNetTemplate& Template);
+      void          set(uint8_t Slot, const char* Value);
+      bool          keep(uint8_t Slot, const char* Value);
+      bool          uses(uint8_t Slot) const  { return Slot<PageSlots && (_T->Used & (1u<<Slot)); }
+      size_t        length() const;
+      size_t        render(uint8_t* Buf, size_t MaxLen);
+      void          rewind();
+      size_t        sent() const        { return _Sent; }
+    private:
+      const char*   value(uint8_t Slot) const;
+      const WifiNetTemplate* _T;
+      const char*   _Val[PageSlots];    // slot values (RAM or PROGMEM), nullptr empty; offset in <_Own> if kept
+      uint16_t      _OwnMask;           // slots kept in <_Own>
+      uint8_t       _OwnUsed;
+      uint8_t       _Run;               // run being sent
+      bool          _InSlot;            // sending the slot value after <_Run>
+      uint16_t      _Offset;            // bytes of the run / value already sent
+      uint16_t      _ValLen;            // length of the value being sent, 0xFFFF not measured
+      size_t        _Sent;              // bytes produced
+      char          _Own[PageOwnLen];
+  };
+
+#endif  //WifiNetPage_h
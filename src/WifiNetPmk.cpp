@@ -0,0 +1,166 @@
+/*
+ * WifiNetPmk.cpp WPA2 pairwise master key derivation for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * methods:       derive; toHex; pbkdf2; hmac; sha1; compress; pads; finish
+ *
+ */
+
+#include  "Arduino.h"
+#include  "WifiNetPmk.h"
+
+#define   Rol(X,N)        ( ((X) << (N)) | ((X) >> (32-(N))) )
+#define   PmkMaxSalt      64                                    // [bytes] of <pbkdf2> salt (SSID is 32 at most)
+
+static const uint32_t Sha1Init[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+// **************************************************************************************** //
+static uint32_t Load(const uint8_t* P) {
+  return  (uint32_t)P[0]<<24 | (uint32_t)P[1]<<16 | (uint32_t)P[2]<<8 | P[3];
+}     // end of Load
+
+static void Store(uint8_t* P, uint32_t V) {
+  P[0] = V>>24; P[1] = V>>16; P[2] = V>>8; P[3] = V;
+}     // end of Store
+
+// **************************************************************************************** //
+void  WifiNetPmk::compress(uint32_t H[5], const uint32_t W[16]) {
+  /*
+    * SHA1 of one message block <W> (big endian words) into state <H>; the schedule runs in 16 words
+    */
+  uint32_t  w[16];
+  memcpy(w, W, sizeof(w));
+  uint32_t  a = H[0], b = H[1], c = H[2], d = H[3], e = H[4];
+  for ( uint8_t t=0; t<80; t++ ) {
+    if ( t>=16 ) {
+      uint32_t  x = w[(t+13)&15] ^ w[(t+8)&15] ^ w[(t+2)&15] ^ w[t&15];
+      w[t&15] = Rol(x,1);
+    }
+    uint32_t  f, k;
+    if      ( t<20 ) { f = (b & c) | (~b & d);          k = 0x5A827999; }
+    else if ( t<40 ) { f = b ^ c ^ d;                   k = 0x6ED9EBA1; }
+    else if ( t<60 ) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+    else             { f = b ^ c ^ d;                   k = 0xCA62C1D6; }
+    uint32_t  tmp = Rol(a,5) + f + e + k + w[t&15];
+    e = d; d = c; c = Rol(b,30); b = a; a = tmp;
+  }   // end of rounds
+  H[0] += a; H[1] += b; H[2] += c; H[3] += d; H[4] += e;
+}     // end of compress
+
+// **************************************************************************************** //
+void  WifiNetPmk::finish(uint32_t H[5], uint64_t Total, const uint8_t* Data, size_t Len) {
+  /*
+    * hash <Data> into <H> and pad; <Total> is the message length[bytes] hashed before <Data>
+    */
+  uint32_t  W[16];
+  uint8_t   block[64];
+  Total += Len;
+  for ( ; Len>=64; Data+=64, Len-=64 ) {
+    for ( uint8_t i=0; i<16; i++ ) W[i] = Load(Data+4*i);
+    compress(H, W);
+  }
+  memset(block, 0, sizeof(block));
+  memcpy(block, Data, Len);
+  block[Len] = 0x80;
+  if ( Len>=56 ) {                              // no room for the length
+    for ( uint8_t i=0; i<16; i++ ) W[i] = Load(block+4*i);
+    compress(H, W);
+    memset(block, 0, sizeof(block));
+  }
+  Store(block+56, Total>>29);
+  Store(block+60, Total<<3);
+  for ( uint8_t i=0; i<16; i++ ) W[i] = Load(block+4*i);
+  compress(H, W);
+}     // end of finish
+
+// **************************************************************************************** //
+void  WifiNetPmk::sha1(const uint8_t* Data, size_t Len, uint8_t Digest[20]) {
+  uint32_t  H[5];
+  memcpy(H, Sha1Init, sizeof(H));
+  finish(H, 0, Data, Len);
+  for ( uint8_t i=0; i<5; i++ ) Store(Digest+4*i, H[i]);
+}     // end of sha1
+
+// **************************************************************************************** //
+void  WifiNetPmk::pads(const uint8_t* Key, size_t KeyLen, uint32_t Inner[5], uint32_t Outer[5]) {
+  /*
+    * SHA1 states after the HMAC inner (key^0x36) and outer (key^0x5C) pad blocks
+    */
+  uint8_t   k[64];
+  uint32_t  W[16];
+  memset(k, 0, sizeof(k));
+  if ( KeyLen>64 ) sha1(Key, KeyLen, k);        // long keys are hashed first
+  else             memcpy(k, Key, KeyLen);
+  for ( uint8_t i=0; i<16; i++ ) W[i] = Load(k+4*i) ^ 0x36363636;
+  memcpy(Inner, Sha1Init, sizeof(Sha1Init));
+  compress(Inner, W);
+  for ( uint8_t i=0; i<16; i++ ) W[i] = Load(k+4*i) ^ 0x5C5C5C5C;
+  memcpy(Outer, Sha1Init, sizeof(Sha1Init));
+  compress(Outer, W);
+}     // end of pads
+
+// **************************************************************************************** //
+void  WifiNetPmk::hmac(const uint8_t* Key, size_t KeyLen, const uint8_t* Data, size_t Len, uint8_t Mac[20]) {
+  uint32_t  inner[5], outer[5];
+  uint8_t   d[20];
+  pads(Key, KeyLen, inner, outer);
+  finish(inner, 64, Data, Len);
+  for ( uint8_t i=0; i<5; i++ ) Store(d+4*i, inner[i]);
+  finish(outer, 64, d, sizeof(d));
+  for ( uint8_t i=0; i<5; i++ ) Store(Mac+4*i, outer[i]);
+}     // end of hmac
+
+// **************************************************************************************** //
+void  WifiNetPmk::pbkdf2(const uint8_t* Pass, size_t PassLen, const uint8_t* Salt, size_t SaltLen,
+                         uint32_t Iterations, uint8_t* Out, size_t OutLen) {
+  /*
+    * PBKDF2-HMAC-SHA1 (RFC 8018), <SaltLen> up to <PmkMaxSalt>
+    * U(n) = HMAC(U(n-1)) is two compressions: the 20 byte message always makes one padded block after the
+    * pad state, so both blocks are built once and only their first 5 words change
+    */
+  uint32_t  inner[5], outer[5], h[5], t[5];
+  uint32_t  Wi[16], Wo[16];                     // inner block [U 0x80.. 672], outer block [inner digest 0x80.. 672]
+  uint8_t   msg[PmkMaxSalt+4];
+  if ( SaltLen>PmkMaxSalt ) SaltLen = PmkMaxSalt;
+  pads(Pass, PassLen, inner, outer);
+  memset(Wi, 0, sizeof(Wi));
+  Wi[5] = 0x80000000;
+  Wi[15] = (64+20)*8;
+  memcpy(Wo, Wi, sizeof(Wo));
+  memcpy(msg, Salt, SaltLen);
+  for ( uint32_t block=1; OutLen; block++ ) {
+    Store(msg+SaltLen, block);                  // U1 = HMAC(Salt || block)
+    memcpy(h, inner, sizeof(h));
+    finish(h, 64, msg, SaltLen+4);
+    memcpy(Wo, h, sizeof(h));
+    memcpy(h, outer, sizeof(h));
+    compress(h, Wo);
+    memcpy(t, h, sizeof(t));
+    for ( uint32_t n=1; n<Iterations; n++ ) {
+      memcpy(Wi, h, sizeof(h));
+      memcpy(h, inner, sizeof(h));
+      compress(h, Wi);
+      memcpy(Wo, h, sizeof(h));
+      memcpy(h, outer, sizeof(h));
+      compress(h, Wo);
+      for ( uint8_t i=0; i<5; i++ ) t[i] ^= h[i];
+    }   // end of iterations
+    uint8_t   T[20];
+    size_t    n = OutLen<20 ? OutLen : 20;
+    for ( uint8_t i=0; i<5; i++ ) Store(T+4*i, t[i]);
+    memcpy(Out, T, n);
+    Out += n;
+    OutLen -= n;
+  }   // end of blocks
+}     // end of pbkdf2
+
+// **************************************************************************************** //
+void  WifiNetPmk::derive(const char* Passphrase, const char* Ssid, uint8_t Pmk[PmkLength]) {
+  pbkdf2((const uint8_t*)Passphrase, strlen(Passphrase), (const uint8_t*)Ssid, strlen(Ssid), PmkIterations, Pmk, PmkLength);
+}     // end of derive
+
+void  WifiNetPmk::toHex(const uint8_t Pmk[PmkLength], char Hex[2*PmkLength+1]) {
+  static const char Digits[] = "0123456789abcdef";
+  for ( uint8_t i=0; i<PmkLength; i++ ) { Hex[2*i] = Digits[Pmk[i]>>4]; Hex[2*i+1] = Digits[Pmk[i]&15]; }
+  Hex[2*PmkLength] = '\0';
+}     // end of toHex
@@ -0,0 +1,34 @@
+#pragma once
+/*
+ * WifiNetPmk.h WPA2 pairwise master key derivation for WifiNet library <_PMKCACHE>
+ * Created by Sachi Gerlitz
+ *
+ * PMK = PBKDF2-HMAC-SHA1(passphrase, SSID, 4096 iterations, 32 bytes)  (IEEE 802.11i, H.4)
+ * the station SDK runs this on every <WiFi.begin> with a passphrase (hundreds of mS on an ESP8266); derived once
+ * and passed as 64 hex chars, <WiFi.begin> takes it as the key and skips the derivation.
+ * the HMAC key pads are hashed once per derivation; each of the 2*4096 HMACs then costs two SHA1 blocks
+ * on prebuilt, pre-padded message blocks.
+ */
+#ifndef WifiNetPmk_h
+  #define WifiNetPmk_h
+
+  #include  "Arduino.h"
+
+  #define PmkLength       32              // [bytes]
+  #define PmkIterations   4096
+
+  class WifiNetPmk {
+    public:
+      static void   derive(const char* Passphrase, const char* Ssid, uint8_t Pmk[PmkLength]);
+      static void   toHex(const uint8_t Pmk[PmkLength], char Hex[2*PmkLength+1]);
+      static void   pbkdf2(const uint8_t* Pass, size_t PassLen, const uint8_t* Salt, size_t SaltLen,
+                           uint32_t Iterations, uint8_t* Out, size_t OutLen);
+      static void   hmac(const uint8_t* Key, size_t KeyLen, const uint8_t* Data, size_t Len, uint8_t Mac[20]);
+      static void   sha1(const uint8_t* Data, size_t Len, uint8_t Digest[20]);
+    private:
+      static void   compress(uint32_t H[5], const uint32_t W[16]);
+      static void   pads(const uint8_t* Key, size_t KeyLen, uint32_t Inner[5], uint32_t Outer[5]);
+      static void   finish(uint32_t H[5], uint64_t Total, const uint8_t* Tail, size_t Len);
+  };
+
+#endif  //WifiNetPmk_h
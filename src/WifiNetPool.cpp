@@ -0,0 +1,67 @@
+/*
+ * WifiNetPool.cpp fixed slab buffer pool of the web handlers for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * constructor:   WifiNetPool
+ * methods:       borrow; release; refuse
+ *
+ */
+
+#include  "Arduino.h"
+#include  "WifiNetPool.h"
+
+// **************************************************************************************** //
+WifiNetPool::WifiNetPool() {
+  _Used = 0;
+  InUse = 0;
+  HighWater = 0;
+  Borrows = 0;
+  Exhausted = 0;
+}     // end of WifiNetPool
+
+// **************************************************************************************** //
+void*  WifiNetPool::borrow() {
+  /*
+    * returns  a free slab (<PoolSlabSize> bytes, 8 aligned), nullptr when all are out
+    */
+  uint16_t  free = ~_Used & ((1u<<PoolSlabs)-1);
+  if ( !free ) {
+    Exhausted++;
+    return  nullptr;
+  }
+  uint8_t   s = __builtin_ctz(free);                    // lowest free slab
+  _Used |= 1u<<s;
+  InUse++;
+  Borrows++;
+  if ( InUse > HighWater ) HighWater = InUse;
+  return  _Slab[s];
+}     // end of borrow
+
+void*  WifiNetPool::borrow(AsyncWebServerRequest *request) {
+  /*
+    * a slab for the response of <request>, released when the request is gone (client disconnect, response
+    * sent or aborted); takes the <onDisconnect> handler of the request
+    */
+  void*   slab = borrow();
+  if ( slab ) request->onDisconnect([this, slab]() { release(slab); });
+  return  slab;
+}     // end of borrow
+
+// **************************************************************************************** //
+void  WifiNetPool::release(void* Slab) {
+  if ( !Slab ) return;
+  uint8_t   s = ((uint8_t*)Slab - _Slab[0]) / PoolSlabSize;
+  if ( s >= PoolSlabs || !(_Used & (1u<<s)) ) return;   // not ours or returned already
+  _Used &= ~(1u<<s);
+  InUse--;
+}     // end of release
+
+// **************************************************************************************** //
+void  WifiNetPool::refuse(AsyncWebServerRequest *request) {
+  /*
+    * fallback when the pool is exhausted: 503 with Retry-After, nothing allocated for a body
+    */
+  AsyncWebServerResponse* response = request->beginResponse(503);
+  response->addHeader(F("Retry-After"), F(PoolRetryAfter));
+  request->send(response);
+}     // end of refuse
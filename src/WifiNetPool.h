@@ -0,0 +1,51 @@
+#pragma once
+/*
+ * WifiNetPool.h fixed slab buffer pool of the web handlers for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * <PoolSlabs> slabs of <PoolSlabSize> bytes, owned by the <WifiNet> instance (<WifiNet::Pool>), replace the
+ * per request new[] / by value captures of the handlers: a handler borrows a slab for the state of its
+ * response and the slab comes back when the request is gone, so the heap sees no per request blocks and
+ * cannot fragment under concurrent requests.
+ *
+ *    void* Slab = RunWifi.Pool().borrow(request);     // returned by itself when the client disconnects
+ *    if ( !Slab ) return RunWifi.Pool().refuse(request);   // pool exhausted: 503, Retry-After
+ *
+ * bookkeeping is a bit mask, borrow and release are O(1). Handlers run in the SDK system context and loop()
+ * in the user context, they do not preempt each other, so no locking.
+ * statistics: <InUse>, <HighWater> (most slabs out at once), <Borrows>, <Exhausted> (borrows refused)
+ */
+#ifndef WifiNetPool_h
+  #define WifiNetPool_h
+
+  #include  "Arduino.h"
+  #include  <ESPAsyncWebServer.h>
+
+  #ifndef PoolSlabs
+    #define PoolSlabs       4               // number of slabs (1...16)
+  #endif  //PoolSlabs
+  #ifndef PoolSlabSize
+    #define PoolSlabSize    ( __SIZEOF_POINTER__>4 ? 320 : 256 )  // [bytes] of a slab, multiple of 8 (host: 8 byte pointers)
+  #endif  //PoolSlabSize
+  #ifndef PoolRetryAfter
+    #define PoolRetryAfter  "1"             // [S] Retry-After of <refuse>
+  #endif  //PoolRetryAfter
+  static_assert(PoolSlabs>=1 && PoolSlabs<=16 && PoolSlabSize%8==0, "<PoolSlabs> 1...16, <PoolSlabSize> multiple of 8");
+
+  class WifiNetPool {
+    public:
+      WifiNetPool();
+      void*       borrow();
+      void*       borrow(AsyncWebServerRequest *request);
+      void        release(void* Slab);
+      void        refuse(AsyncWebServerRequest *request);
+      uint8_t     InUse;                // slabs borrowed now
+      uint8_t     HighWater;            // most slabs borrowed at once
+      uint32_t    Borrows;              // slabs handed out
+      uint32_t    Exhausted;            // borrows refused, pool empty
+    private:
+      uint16_t    _Used;                // borrowed slabs, bit per slab
+      alignas(8) uint8_t _Slab[PoolSlabs][PoolSlabSize];
+  };
+
+#endif  //WifiNetPool_h
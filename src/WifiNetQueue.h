@@ -0,0 +1,57 @@
+#pragma once
+/*
+ * WifiNetQueue.h bounded single producer / single consumer command queue for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * web handlers run in the network callback context and loop() in the user context; instead of both working on
+ * the same state, a handler posts a command and loop() takes it at a safe point (<WifiNet::ServiceCommands>):
+ *
+ *    handler:   if ( !RunWifi.PostCommand(CmdReset) ) ...busy, try again       (producer)
+ *    loop():    RunWifi.ServiceCommands(SysClock);                              (consumer)
+ *
+ * <N> slots of <T> (copied in and out); the producer owns <_Tail>, the consumer owns <_Head>, each index is
+ * published with a release store after the slot is written / read and loaded with acquire by the other side,
+ * so there is no lock, no interrupt masking and no read-modify-write (none is needed with one thread per side).
+ * the indices run free over 0..255, <N> a power of 2 so the slot is the index masked.
+ * one producer only: more handlers posting at once (ESP32, two cores) need their own queues.
+ */
+#ifndef WifiNetQueue_h
+  #define WifiNetQueue_h
+
+  #include  <atomic>
+  #include  <stdint.h>
+
+  template<class T, uint8_t N> class WifiNetQueue {
+    static_assert(N>=2 && N<=128 && (N & (N-1))==0, "<N> of WifiNetQueue is a power of 2, 2...128");
+    public:
+      WifiNetQueue() : _Head(0), _Tail(0) {}
+      bool      post(const T& Item) {
+        /*
+          * producer: copy <Item> in, returns 0 when full (nothing written)
+          */
+        uint8_t   tail = _Tail.load(std::memory_order_relaxed);
+        if ( (uint8_t)(tail - _Head.load(std::memory_order_acquire)) == N ) return  false;
+        _Slot[tail & (N-1)] = Item;
+        _Tail.store(tail+1, std::memory_order_release);
+        return  true;
+      }     // end of post
+      bool      take(T& Item) {
+        /*
+          * consumer: copy the oldest item out, returns 0 when empty
+          */
+        uint8_t   head = _Head.load(std::memory_order_relaxed);
+        if ( head == _Tail.load(std::memory_order_acquire) ) return  false;
+        Item = _Slot[head & (N-1)];
+        _Head.store(head+1, std::memory_order_release);
+        return  true;
+      }     // end of take
+      uint8_t   count() const {               // items waiting (a snapshot, either side)
+        return  _Tail.load(std::memory_order_acquire) - _Head.load(std::memory_order_acquire);
+      }
+    private:
+      std::atomic<uint8_t>  _Head;            // next to take, written by the consumer
+      std::atomic<uint8_t>  _Tail;            // next to post, written by the producer
+      T         _Slot[N];
+  };
+
+#endif  //WifiNetQueue_h
@@ -0,0 +1,127 @@
+#pragma once
+/*
+ * WifiNetRecords.h typed records of the application EEPROM region for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * the application declares its record types once; offsets, sizes and the region end are computed at compile
+ * time, records are read and written whole (no byte loops) and carry a schema version:
+ *
+ *    struct  Settings {                          // trivially copyable
+ *      static const uint8_t  RecordVersion = 2;
+ *      static const uint16_t RecordSlot = 48;    // optional: EEPROM bytes kept for the record (default its size),
+ *                                                // later versions grow into it without moving the records after it
+ *      uint16_t  Interval;
+ *      char      Topic[32];
+ *      static bool RecordMigrate(Settings& R, uint8_t From, const uint8_t* Old, uint16_t OldLen);  // optional
+ *    };
+ *    typedef WifiNetRecords<WifiNetAppStart, Settings, Calibration> AppRecords;
+ *    EEPROM.begin(AppRecords::End);
+ *    Settings S = {...defaults...};
+ *    AppRecords::read(S);                        // keeps the defaults when the record was never written
+ *    AppRecords::write(S);
+ *
+ * layout at <Base>, in declaration order:  [tag: '$' Version Len(2)] [record in <RecordSlot> bytes] ...
+ * records follow each other, so there is no overlap inside a registry; <Base> is checked against the end of
+ * the library records (<WifiNetAppStart>) and a second registry starts at the <End> of the first.
+ * a record stored by an older version is passed to <RecordMigrate>; without one the old bytes are kept as the
+ * prefix of the new layout (fields added at the end keep their defaults). A migrated record is written back.
+ */
+#ifndef WifiNetRecords_h
+  #define WifiNetRecords_h
+
+  #include  "Arduino.h"
+  #include  "EEPROM.h"
+  #include  "Clock.h"                   // <TimePack> of the WifiNet.h declarations
+  #include  "WifiNet.h"
+  #include  <type_traits>
+
+  #define RecordMarker    '$'
+
+  namespace WifiNetRec {
+    struct  Tag {                       // record header
+      uint8_t     Marker;               // <RecordMarker> - record set
+      uint8_t     Version;              // <RecordVersion> of the writer
+      uint16_t    Len;                  // record length[bytes] of the writer
+    };
+    template<class T, class=void> struct Capacity { static const uint16_t value = sizeof(T); };
+    template<class T> struct Capacity<T, decltype((void)T::RecordSlot)> {
+      static_assert(sizeof(T) <= T::RecordSlot, "record exceeds its <RecordSlot>");
+      static const uint16_t value = T::RecordSlot; };
+    template<class T> struct Slot {     // EEPROM bytes of a record
+      static_assert(std::is_trivially_copyable<T>::value, "records are copied whole: trivially copyable types only");
+      static const uint16_t value = sizeof(Tag) + Capacity<T>::value;
+    };
+    template<class...> struct Size { static const uint16_t value = 0; };
+    template<class R, class... Rs> struct Size<R, Rs...> { static const uint16_t value = Slot<R>::value + Size<Rs...>::value; };
+    template<class T, class... Rs> struct Offset;     // offset of <T> in the region
+    template<class T, class... Rs> struct Offset<T, T, Rs...> { static const uint16_t value = 0; };
+    template<class T, class R, class... Rs> struct Offset<T, R, Rs...> {
+      static const uint16_t value = Slot<R>::value + Offset<T, Rs...>::value; };
+    template<class T, class... Rs> struct Count { static const uint8_t value = 0; };
+    template<class T, class R, class... Rs> struct Count<T, R, Rs...> {
+      static const uint8_t value = std::is_same<T,R>::value + Count<T, Rs...>::value; };
+    template<class... Rs> struct Unique { static const bool value = true; };
+    template<class R, class... Rs> struct Unique<R, Rs...> {
+      static const bool value = Count<R, Rs...>::value==0 && Unique<Rs...>::value; };
+    template<class T, class=void> struct Migrate {    // default: old bytes as prefix of the new layout
+      static bool run(T& R, uint8_t, const uint8_t* Old, uint16_t OldLen) {
+        memcpy(&R, Old, OldLen<sizeof(T) ? OldLen : sizeof(T));
+        return  true; }
+    };
+    template<class T> struct Migrate<T, decltype((void)T::RecordMigrate)> {
+      static bool run(T& R, uint8_t From, const uint8_t* Old, uint16_t OldLen) { return T::RecordMigrate(R, From, Old, OldLen); }
+    };
+  }   // end of WifiNetRec
+
+  template<uint16_t Base, class... Recs> class WifiNetRecords {
+    public:
+      static_assert(Base >= WifiNetAppStart, "application records overlap the library records");
+      static_assert(WifiNetRec::Unique<Recs...>::value, "a record type is declared twice");
+      static const uint16_t End = Base + WifiNetRec::Size<Recs...>::value;    // first address after the region
+      static_assert(End <= 4096, "records exceed the EEPROM sector");
+
+      template<class T> static constexpr uint16_t offset() { return Base + WifiNetRec::Offset<T, Recs...>::value; }
+
+      template<class T> static bool read(T& R) {
+        /*
+          * copy record <T> to <R>; an older version is migrated and written back
+          * returns  0 record never written or unreadable (<R> unchanged)
+          */
+        if ( EEPROM.length() < End ) return  false;
+        const uint8_t*  p = EEPROM.getConstDataPtr() + offset<T>();
+        WifiNetRec::Tag tag;
+        memcpy(&tag, p, sizeof(tag));
+        if ( tag.Marker!=RecordMarker || tag.Len > WifiNetRec::Capacity<T>::value ) return  false;
+        if ( tag.Version==T::RecordVersion && tag.Len==sizeof(T) ) {
+          memcpy(&R, p+sizeof(tag), sizeof(T));
+          return  true;
+        }
+        T   migrated = R;
+        if ( !WifiNetRec::Migrate<T>::run(migrated, tag.Version, p+sizeof(tag), tag.Len) ) return  false;
+        R = migrated;
+        return  write(R);
+      }   // end of read
+
+      template<class T> static bool write(const T& R, bool Commit=true) {
+        /*
+          * store <R> as record <T>; several writes may share one commit (<Commit> 0 for all but the last)
+          * an unchanged record is not written nor committed
+          */
+        if ( EEPROM.length() < End ) return  false;
+        WifiNetRec::Tag tag = { RecordMarker, T::RecordVersion, sizeof(T) };
+        const uint8_t*  c = EEPROM.getConstDataPtr() + offset<T>();
+        if ( memcmp(c, &tag, sizeof(tag))==0 && memcmp(c+sizeof(tag), &R, sizeof(T))==0 ) return  true;
+        uint8_t*  p = EEPROM.getDataPtr() + offset<T>();
+        memcpy(p, &tag, sizeof(tag));
+        memcpy(p+sizeof(tag), &R, sizeof(T));
+        return  Commit ? EEPROM.commit() : true;
+      }   // end of write
+
+      template<class T> static bool erase(bool Commit=true) {
+        if ( EEPROM.length() < End ) return  false;
+        EEPROM.write(offset<T>(), 0xFF);
+        return  Commit ? EEPROM.commit() : true;
+      }   // end of erase
+  };
+
+#endif  //WifiNetRecords_h
@@ -0,0 +1,226 @@
+/*
+ * WifiNetSntp.cpp non blocking SNTP client of several servers for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * constructor:   WifiNetSntp
+ * methods:       begin; stop; active; service; synced; now; nowMs; receive; resolve
+ *
+ * RFC 4330 / RFC 5905 packet: 48 bytes, LI VN Mode | stratum | poll | precision | root delay | root dispersion |
+ * reference ID (kiss code at stratum 0) | reference, originate (24), receive (32), transmit (40) timestamps
+ */
+
+#include  "Arduino.h"
+#include  "WifiNetSntp.h"
+#if defined(ARDUINO_ARCH_ESP8266)
+  #include  "lwip/dns.h"              // resolver in the background
+#endif  //ARDUINO_ARCH_ESP8266
+
+static const uint32_t NtpUnix = 2208988800UL;           // [S] 1900 to 1970
+
+static uint32_t NtpWord(const uint8_t* P) {
+  return  ((uint32_t)P[0]<<24) | ((uint32_t)P[1]<<16) | ((uint32_t)P[2]<<8) | P[3];
+}   // end of NtpWord
+
+static int64_t NtpMs(const uint8_t* P) {                // timestamp to epoch[mS]
+  uint32_t  sec = NtpWord(P);
+  int64_t   s = (int64_t)sec - NtpUnix;
+  if ( sec < 0x80000000UL ) s += 0x100000000LL;         // era 1, from 2036
+  return  s*1000 + (((uint64_t)NtpWord(P+4)*1000) >> 32);
+}   // end of NtpMs
+
+// **************************************************************************************** //
+WifiNetSntp::WifiNetSntp() {
+  memset(_Server, 0, sizeof(_Server));
+  _Count = 0;
+  _Open = false;
+  _InRound = false;
+  _Due = false;
+  _Out = 0;
+  _RoundAt = 0;
+  _Retry = SntpRetryMs;
+  _EpochMs = 0;
+  _Mark = 0;
+  Rounds = Failed = Requests = Replies = Ignored = KissOfDeath = 0;
+  Delay = 0;
+  Offset = 0;
+}     // end of WifiNetSntp
+
+// **************************************************************************************** //
+bool  WifiNetSntp::begin(const char* const Servers[], uint8_t Count) {
+  /*
+    * open the socket and take <Count> server names / dotted addresses (kept by pointer, static strings);
+    * the first round goes out at the next <service>. the clock is kept over a new <begin>
+    * returns  0 no server or no socket
+    */
+  stop();
+  _Count = Count < SntpServers ? Count : SntpServers;
+  for ( uint8_t i=0; i<_Count; i++ ) {
+    memset(&_Server[i], 0, sizeof(Server));
+    _Server[i].Name = Servers[i];
+    resolve(_Server[i]);
+  }
+  _Open = _Count && _Udp.begin(0);                      // any local port
+  _Due = true;
+  _Retry = SntpRetryMs;
+  return  _Open;
+}     // end of begin
+
+// **************************************************************************************** //
+void  WifiNetSntp::stop() {
+  if ( _Open ) _Udp.stop();
+  _Open = false;
+  _InRound = false;
+}     // end of stop
+
+bool  WifiNetSntp::active() {
+  return  _Open;
+}     // end of active
+
+bool  WifiNetSntp::synced() {
+  return  _EpochMs != 0;
+}     // end of synced
+
+time_t  WifiNetSntp::now(uint32_t Now) {
+  return  nowMs(Now)/1000;
+}     // end of now
+
+int64_t  WifiNetSntp::nowMs(uint32_t Now) {
+  /*
+    * returns  epoch[mS] at <millis> <Now>, 0 - not synced
+    */
+  return  _EpochMs ? _EpochMs + (uint32_t)(Now - _Mark) : 0;
+}     // end of nowMs
+
+// **************************************************************************************** //
+uint8_t  WifiNetSntp::service(uint32_t Now) {
+  /*
+    * one step for loop() at <millis> <Now>: start a due round, take the replies that arrived, end the round
+    * returns  <Codes4Sntp>
+    */
+  if ( !_Open ) return SntpIdle;
+  if ( !_InRound ) {
+    if ( !_Due && (int32_t)(Now-_RoundAt) < 0 ) {
+      receive(Now);                                     // late replies, counted and dropped
+      return  SntpIdle;
+    }
+    _Due = false;
+    _InRound = true;
+    _RoundAt = Now;
+    _RoundDelay = -1;
+    _Out = 0;
+    int64_t   ms = nowMs(Now);
+    for ( uint8_t i=0; i<_Count; i++ ) {                // all servers at once
+      Server& S = _Server[i];
+      S.Nonce = 0;
+      if ( !S.IP ) { resolve(S); continue; }
+      if ( S.Denied || (S.Hold && (int32_t)(Now-S.HoldUntil) < 0) ) continue;
+      uint8_t   pkt[48];
+      memset(pkt, 0, sizeof(pkt));
+      pkt[0] = 0x23;                                    // LI 0, version 4, client
+      uint32_t  sec = ms ? (uint32_t)(ms/1000 + NtpUnix) : Now;
+      uint32_t  nonce = ((uint32_t)random(0x7FFFFFFF) << 1) | 1;   // never 0
+      for ( uint8_t b=0; b<4; b++ ) {
+        pkt[40+b] = sec >> (24-8*b);
+        pkt[44+b] = nonce >> (24-8*b);
+      }
+      if ( !_Udp.beginPacket(IPAddress(S.IP), SntpPort) ) continue;
+      _Udp.write(pkt, sizeof(pkt));
+      if ( !_Udp.endPacket() ) continue;
+      S.Nonce = nonce;
+      S.SentAt = Now;
+      _Out++;
+      Requests++;
+    }   // end of servers
+  }   // end of round start
+  receive(Now);
+  if ( _Out && (int32_t)(Now-_RoundAt) < SntpTimeoutMs ) return SntpIdle;
+
+  _InRound = false;                                     // round over, later replies are not ours
+  Rounds++;
+  for ( uint8_t i=0; i<_Count; i++ ) _Server[i].Nonce = 0;
+  if ( _RoundDelay < 0 ) {
+    Failed++;
+    _RoundAt = Now + _Retry;
+    _Retry = _Retry*2 < SntpBackoffMs ? _Retry*2 : SntpBackoffMs;
+    return  SntpFailed;
+  }
+  Offset = _EpochMs ? (int32_t)(_RoundMs - nowMs(_RoundMark)) : 0;
+  _EpochMs = _RoundMs;
+  _Mark = _RoundMark;
+  Delay = _RoundDelay;
+  _Retry = SntpRetryMs;
+  _RoundAt = Now + SntpPollS*1000UL;
+  return  SntpSynced;
+}     // end of service
+
+// **************************************************************************************** //
+void  WifiNetSntp::receive(uint32_t Now) {
+  /*
+    * read the waiting replies; a valid one answering a request of the round is a sample, kept when its
+    * delay is the lowest of the round
+    */
+  uint8_t   pkt[48];
+  for ( uint8_t n=0; n<SntpServers+2 && _Udp.parsePacket() > 0; n++ ) {
+    int       len = _Udp.read(pkt, sizeof(pkt));
+    uint32_t  from = _Udp.remoteIP();
+    Server*   S = nullptr;
+    for ( uint8_t i=0; i<_Count && !S && len>=48; i++ )
+      if ( _Server[i].Nonce && _Server[i].IP==from && NtpWord(pkt+28)==_Server[i].Nonce ) S = &_Server[i];
+    uint8_t   vn = (pkt[0]>>3) & 7;
+    if ( !S || len < 48 || (pkt[0] & 7)!=4 || vn<1 || vn>4 ) {   // not ours, late or not a server reply
+      Ignored++;
+      continue;
+    }
+    S->Nonce = 0;                                       // answered, good or not
+    _Out--;
+    if ( !pkt[1] ) {                                    // kiss of death
+      KissOfDeath++;
+      if ( !memcmp(pkt+12, "DENY", 4) || !memcmp(pkt+12, "RSTR", 4) ) S->Denied = 1;
+      else if ( !memcmp(pkt+12, "RATE", 4) ) {
+        S->Hold = !S->Hold ? SntpRateMs : S->Hold*2 < SntpBackoffMs ? S->Hold*2 : SntpBackoffMs;
+        S->HoldUntil = Now + S->Hold;
+      }
+      continue;
+    }
+    if ( (pkt[0]>>6)==3 || pkt[1]>15 || (!NtpWord(pkt+40) && !NtpWord(pkt+44)) ) {   // unsynchronized server
+      Ignored++;
+      continue;
+    }
+    int64_t   t2 = NtpMs(pkt+32), t3 = NtpMs(pkt+40);
+    int32_t   rtt = Now - S->SentAt;
+    int32_t   delay = rtt - (int32_t)(t3-t2);
+    if ( delay < 0 ) delay = 0;                         // server time over the mS resolution of <millis>
+    int64_t   epoch = (t2 + t3 + rtt)/2;                // at <Now>: server time plus half the path
+    int32_t   off = _EpochMs ? (int32_t)(epoch - nowMs(Now)) : 0;
+    Replies++;
+    S->Hold = 0;
+    if ( _RoundDelay < 0 || delay < _RoundDelay || (delay==_RoundDelay && abs(off) < abs(_RoundOff)) ) {
+      _RoundMs = epoch;
+      _RoundMark = Now;
+      _RoundDelay = delay;
+      _RoundOff = off;
+    }
+  }   // end of packets
+}     // end of receive
+
+// **************************************************************************************** //
+void  WifiNetSntp::resolve(Server& S) {
+  /*
+    * address of <S>: a dotted one at once, a name by the lwIP resolver in the background (device only)
+    */
+  IPAddress ip;
+  if ( ip.fromString(S.Name) ) {
+    S.IP = ip;
+    return;
+  }
+  #if defined(ARDUINO_ARCH_ESP8266)
+    if ( S.Resolving ) return;
+    ip_addr_t addr;
+    err_t     e = dns_gethostbyname(S.Name, &addr, [](const char*, const ip_addr_t* A, void* Arg) {
+      Server* s = (Server*)Arg;
+      s->Resolving = 0;
+      if ( A ) s->IP = ip4_addr_get_u32(ip_2_ip4(A)); }, &S);
+    if ( e == ERR_OK )              S.IP = ip4_addr_get_u32(ip_2_ip4(&addr));
+    else if ( e == ERR_INPROGRESS ) S.Resolving = 1;
+  #endif  //ARDUINO_ARCH_ESP8266
+}     // end of resolve
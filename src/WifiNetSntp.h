@@ -0,0 +1,106 @@
+#pragma once
+/*
+ * WifiNetSntp.h non blocking SNTP client of several servers for WifiNet library
+ * Created by Sachi Gerlitz
+ *
+ * replaces the blocking <configTime> / <getLocalTime> sequence of <WifiNet::GetWWWTime>: <service> is called
+ * from loop() (<WifiNet::ServiceNTP>) and never waits, each call sends, reads what arrived and returns.
+ *
+ *    round     - one request to every usable server at once over one UDP socket; the round ends when all
+ *                replied or after <SntpTimeoutMs>. the sample of the lowest round-trip delay wins (then the
+ *                smaller offset), the clock is kept as an epoch at a <millis> mark (no system call)
+ *    next      - <SntpPollS> after a synced round; after a failed one <SntpRetryMs>, doubling up to <SntpBackoffMs>
+ *    reply     - server mode, version 1...4, stratum 1...15, synchronized (LI != 3) and our transmit timestamp
+ *                (a nonce) echoed as originate, anything else is ignored
+ *    KoD       - stratum 0: "DENY" / "RSTR" drop the server for good, "RATE" holds it off from <SntpRateMs>,
+ *                doubling up to <SntpBackoffMs>; other codes are ignored
+ *    names     - dotted addresses are used as they are; on the device a name is resolved by the lwIP resolver
+ *                in the background (no <hostByName> wait), a server joins the rounds once it has an address
+ *
+ * delay and offset are in mS from <millis> at send and at read, so the loop latency adds to the delay alike
+ * for every server. statistics: <Rounds>, <Failed>, <Requests>, <Replies>, <Ignored>, <KissOfDeath>
+ */
+#ifndef WifiNetSntp_h
+  #define WifiNetSntp_h
+
+  #include  "Arduino.h"
+  #include  <WiFiUdp.h>
+
+  #ifndef SntpServers
+    #define SntpServers     3               // servers of a round (1...8)
+  #endif  //SntpServers
+  #ifndef SntpPort
+    #define SntpPort        123             // UDP port of the servers
+  #endif  //SntpPort
+  #ifndef SntpTimeoutMs
+    #define SntpTimeoutMs   1000            // [mS] a round waits for the replies
+  #endif  //SntpTimeoutMs
+  #ifndef SntpRetryMs
+    #define SntpRetryMs     2000            // [mS] next round after a failed one, doubles
+  #endif  //SntpRetryMs
+  #ifndef SntpBackoffMs
+    #define SntpBackoffMs   300000          // [mS] cap of the retry and of a server held off by "RATE"
+  #endif  //SntpBackoffMs
+  #ifndef SntpRateMs
+    #define SntpRateMs      16000           // [mS] first hold-off of a server by "RATE"
+  #endif  //SntpRateMs
+  #ifndef SntpPollS
+    #define SntpPollS       3600            // [S] next round after a synced one
+  #endif  //SntpPollS
+  static_assert(SntpServers>=1 && SntpServers<=8 && SntpRetryMs<=SntpBackoffMs, "<SntpServers> 1...8, <SntpRetryMs> up to <SntpBackoffMs>");
+
+  enum  Codes4Sntp {                    // returned by <WifiNetSntp::service>
+    SntpIdle=0,                         // 0 - nothing completed
+    SntpSynced=1,                       // 1 - a round ended with a sample, <now> follows it
+    SntpFailed=2                        // 2 - a round ended without a usable reply
+  };
+
+  class WifiNetSntp {
+    public:
+      WifiNetSntp();
+      bool        begin(const char* const Servers[], uint8_t Count);
+      void        stop();
+      bool        active();
+      uint8_t     service(uint32_t Now);
+      bool        synced();
+      time_t      now(uint32_t Now);
+      int64_t     nowMs(uint32_t Now);
+      uint32_t    Rounds;               // rounds completed
+      uint32_t    Failed;               // rounds without a usable reply
+      uint32_t    Requests;             // requests sent
+      uint32_t    Replies;              // replies taken as samples
+      uint32_t    Ignored;              // packets not taken (invalid, late, not ours)
+      uint32_t    KissOfDeath;          // KoD replies
+      uint16_t    Delay;                // [mS] round-trip of the last sample
+      int32_t     Offset;               // [mS] correction of the last sample against the clock before it
+    private:
+      struct  Server {
+        const char* Name;
+        uint32_t  IP;                   // network order, 0 - not resolved yet
+        uint32_t  Nonce;                // fraction of our transmit timestamp, 0 - no request out
+        uint32_t  SentAt;               // <millis> at send
+        uint32_t  HoldUntil;            // <millis> of the next request after "RATE"
+        uint32_t  Hold;                 // [mS] current hold-off, 0 - none
+        uint8_t   Denied : 1;           // "DENY" / "RSTR"
+        uint8_t   Resolving : 1;        // lookup out (device)
+      };
+      void        receive(uint32_t Now);
+      void        resolve(Server& S);
+      Server      _Server[SntpServers];
+      uint8_t     _Count;
+      WiFiUDP     _Udp;
+      bool        _Open;                // socket open, <begin> done
+      bool        _InRound;
+      bool        _Due;                 // first round at the next <service>
+      uint8_t     _Out;                 // requests of the round not answered
+      uint32_t    _RoundAt;             // <millis> the round started / is due
+      uint32_t    _Retry;               // [mS] wait after the next failed round
+      int64_t     _EpochMs;             // [mS] epoch at <_Mark>, 0 - not synced
+      uint32_t    _Mark;                // <millis> of <_EpochMs>
+      int64_t     _RoundMs;             // best sample of the round: epoch[mS] at <_RoundMark>
+      uint32_t    _RoundMark;
+      int32_t     _RoundDelay;          // [mS], -1 none
+      int32_t     _RoundOff;            // [mS] against the clock, tie break of equal delays
+  };
+
+#endif  //WifiNetSntp_h